@@ -314,8 +314,10 @@ have_func 'timegm'
 have_func 'rb_io_wait' # since ruby-3.0
 have_func 'rb_io_descriptor' # since ruby-3.1
 have_func 'rb_hash_new_capa' # since ruby-3.2
+have_func 'rb_enc_interned_str', 'ruby/encoding.h' # since ruby-3.0
 
 have_header 'inttypes.h'
+have_header 'ruby/atomic.h' # since ruby-3.0
 have_header('ruby/fiber/scheduler.h') if RUBY_PLATFORM=~/mingw|mswin/
 
 checking_for "C99 variable length arrays" do
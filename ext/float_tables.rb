@@ -0,0 +1,95 @@
+# -*- ruby -*-
+#
+# Generate the tables of powers of five used by pg_float.c for float parsing (Eisel-Lemire) and formatting (Ryu).
+#
+# Usage:
+#   ruby ext/float_tables.rb ext/pg_float_tables.h
+
+SMALLEST_POWER_OF_FIVE = -342
+LARGEST_POWER_OF_FIVE = 308
+POW5_INV_BITCOUNT = 125
+POW5_BITCOUNT = 125
+POW5_INV_TABLE_SIZE = 342
+POW5_TABLE_SIZE = 326
+
+def u64(value)
+	"UINT64_C(0x%016x)" % value
+end
+
+# Shift +value+ to +bits+ significant bits, truncating the lower bits.
+def scale(value, bits)
+	shift = value.bit_length - bits
+	shift > 0 ? value >> shift : value << -shift
+end
+
+# 128 bit approximation of 5^q, truncated for q >= 0 and rounded up for q < 0
+def power_of_five_128(q)
+	if q >= 0
+		scale(5 ** q, 128)
+	else
+		power5 = 5 ** -q
+		b = q >= -27 ? power5.bit_length + 127 : 2 * power5.bit_length + 128
+		c = (1 << b) / power5 + 1
+		c.bit_length > 128 ? scale(c, 128) : c
+	end
+end
+
+out_h = ARGV[0] or abort "usage: #{$0} <output.h>"
+
+File.open(out_h, 'w') do |fd|
+	fd.puts <<EOCODE
+/*
+ * #{File.basename(out_h)} - Tables of powers of five for pg_float.c
+ *
+ * WARNING: This file is autogenerated. Please edit ext/#{File.basename(__FILE__)} !
+ *
+ * Generated with arbitrary precision integers:
+ *
+ *   rbpg_power_of_five_128[q]: 5^q for q >= 0 shifted to 128 bits with the most significant bit set and truncated.
+ *                              For q < 0: 2^b / 5^-q + 1, with b = bitlen(5^-q) + 127 for q >= -27
+ *                              or b = 2 * bitlen(5^-q) + 128 for q < -27, then truncated to 128 bits.
+ *   rbpg_pow5_split[i]:        5^i shifted to 125 bits.
+ *   rbpg_pow5_inv_split[i]:    2^(bitlen(5^i) - 1 + 125) / 5^i + 1
+ */
+
+/* 128 bit approximation of 5^q (high 64 bits, low 64 bits) for q from RBPG_SMALLEST_POWER_OF_FIVE to RBPG_LARGEST_POWER_OF_FIVE,
+ * truncated for q >= 0 and rounded up for q < 0 */
+#define RBPG_SMALLEST_POWER_OF_FIVE (#{SMALLEST_POWER_OF_FIVE})
+#define RBPG_LARGEST_POWER_OF_FIVE #{LARGEST_POWER_OF_FIVE}
+static const uint64_t rbpg_power_of_five_128[] = {
+EOCODE
+
+	(SMALLEST_POWER_OF_FIVE..LARGEST_POWER_OF_FIVE).each do |q|
+		v = power_of_five_128(q)
+		fd.puts "\t#{u64(v >> 64)}, #{u64(v & (2**64 - 1))},"
+	end
+
+	fd.puts <<EOCODE
+};
+
+/* 5^i and 2^k/5^i scaled to 125 bits (low 64 bits, high 64 bits) as used by the Ryu algorithm */
+#define RBPG_POW5_INV_BITCOUNT #{POW5_INV_BITCOUNT}
+#define RBPG_POW5_BITCOUNT #{POW5_BITCOUNT}
+#define RBPG_POW5_INV_TABLE_SIZE #{POW5_INV_TABLE_SIZE}
+#define RBPG_POW5_TABLE_SIZE #{POW5_TABLE_SIZE}
+static const uint64_t rbpg_pow5_inv_split[RBPG_POW5_INV_TABLE_SIZE][2] = {
+EOCODE
+
+	POW5_INV_TABLE_SIZE.times do |i|
+		pow5 = 5 ** i
+		v = (1 << (pow5.bit_length - 1 + POW5_INV_BITCOUNT)) / pow5 + 1
+		fd.puts "\t{ #{u64(v & (2**64 - 1))}, #{u64(v >> 64)} },"
+	end
+
+	fd.puts <<EOCODE
+};
+static const uint64_t rbpg_pow5_split[RBPG_POW5_TABLE_SIZE][2] = {
+EOCODE
+
+	POW5_TABLE_SIZE.times do |i|
+		v = scale(5 ** i, POW5_BITCOUNT)
+		fd.puts "\t{ #{u64(v & (2**64 - 1))}, #{u64(v >> 64)} },"
+	end
+
+	fd.puts "};"
+end
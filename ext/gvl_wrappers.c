@@ -20,11 +20,61 @@ PostgresPollingStatusType PQcancelPoll(PGcancelConn *cancelConn){return PGRES_PO
 int PQpipelineSync(PGconn *conn){return 0;}
 #endif
 
+/* Enable the fast path of the GVL wrappers. Set by PG.gvl_adaptive= */
+int pg_gvl_adaptive = 0;
+
+/*
+ * Return true if libpq functions which don't wait for the socket may be called without releasing the GVL.
+ *
+ * Notice callbacks set by Ruby are called through rb_thread_call_with_gvl(), which requires a released GVL.
+ * libpq returns the current notice hooks without changing them, when called with a NULL function.
+ */
+int
+pg_gvl_fast_path_p( PGconn *conn )
+{
+	return pg_gvl_adaptive &&
+		PQsetNoticeReceiver(conn, NULL, NULL) != gvl_notice_receiver_proxy &&
+		PQsetNoticeProcessor(conn, NULL, NULL) != gvl_notice_processor_proxy;
+}
+
 #ifdef ENABLE_GVL_UNLOCK
 FOR_EACH_BLOCKING_FUNCTION( DEFINE_GVL_WRAPPER_STRUCT );
 FOR_EACH_BLOCKING_FUNCTION( DEFINE_GVL_SKELETON );
+FOR_EACH_BLOCKING_FUNCTION( DEFINE_GVL_STAT );
+
+static struct pg_gvl_stat *gvl_stats[] = {
+	FOR_EACH_BLOCKING_FUNCTION( DEFINE_GVL_STAT_LIST )
+	NULL
+};
 #endif
 FOR_EACH_BLOCKING_FUNCTION( DEFINE_GVL_STUB );
+
+/*
+ * Return a Hash of the call counters of all wrapped libpq functions.
+ *
+ * The keys are the function names and the values are Hashes with
+ * the number of calls with released GVL (:blocking) and on the fast path (:nonblocking).
+ * Functions which were never called are omitted.
+ */
+VALUE
+pg_gvl_stats( void )
+{
+	VALUE hash = rb_hash_new();
+#ifdef ENABLE_GVL_UNLOCK
+	struct pg_gvl_stat **stat;
+
+	for( stat = gvl_stats; *stat; stat++ ){
+		VALUE counts;
+		if( (*stat)->blocking == 0 && (*stat)->nonblocking == 0 ) continue;
+
+		counts = rb_hash_new();
+		rb_hash_aset(counts, ID2SYM(rb_intern("blocking")), SIZET2NUM((*stat)->blocking));
+		rb_hash_aset(counts, ID2SYM(rb_intern("nonblocking")), SIZET2NUM((*stat)->nonblocking));
+		rb_hash_aset(hash, rb_str_new_cstr((*stat)->name), counts);
+	}
+#endif
+	return hash;
+}
 #ifdef ENABLE_GVL_UNLOCK
 FOR_EACH_CALLBACK_FUNCTION( DEFINE_GVL_WRAPPER_STRUCT );
 FOR_EACH_CALLBACK_FUNCTION( DEFINE_GVLCB_SKELETON );
@@ -21,6 +21,15 @@
 #	include RUBY_EXTCONF_H
 #endif
 
+#ifdef HAVE_RUBY_ATOMIC_H
+#	include <ruby/atomic.h>
+/* The call counters are shared by all Ractors. */
+#	define PG_GVL_STAT_INC(var) RUBY_ATOMIC_SIZE_INC(var)
+#else
+/* No Ractors before ruby-3.0 and all calls run under the GVL. */
+#	define PG_GVL_STAT_INC(var) ((var)++)
+#endif
+
 #ifndef LIBPQ_HAS_CHUNK_MODE
 typedef struct pg_cancel_conn PGcancelConn;
 #endif
@@ -37,7 +46,7 @@ typedef struct pg_cancel_conn PGcancelConn;
 #define DEFINE_PARAM_DECL(type, name) \
 	type name;
 
-#define DEFINE_GVL_WRAPPER_STRUCT(name, when_non_void, rettype, lastparamtype, lastparamname) \
+#define DEFINE_GVL_WRAPPER_STRUCT(name, when_non_void, rettype, lastparamtype, lastparamname, fast_path) \
 	struct gvl_wrapper_##name##_params { \
 		struct { \
 			FOR_EACH_PARAM_OF_##name(DEFINE_PARAM_DECL) \
@@ -46,7 +55,7 @@ typedef struct pg_cancel_conn PGcancelConn;
 		when_non_void( rettype retval; ) \
 	};
 
-#define DEFINE_GVL_SKELETON(name, when_non_void, rettype, lastparamtype, lastparamname) \
+#define DEFINE_GVL_SKELETON(name, when_non_void, rettype, lastparamtype, lastparamname, fast_path) \
 	static void * gvl_##name##_skeleton( void *data ){ \
 		struct gvl_wrapper_##name##_params *p = (struct gvl_wrapper_##name##_params*)data; \
 		when_non_void( p->retval = ) \
@@ -55,26 +64,42 @@ typedef struct pg_cancel_conn PGcancelConn;
 	}
 
 #ifdef ENABLE_GVL_UNLOCK
-#define DEFINE_GVL_STUB(name, when_non_void, rettype, lastparamtype, lastparamname) \
+#define DEFINE_GVL_STAT(name, when_non_void, rettype, lastparamtype, lastparamname, fast_path) \
+	static struct pg_gvl_stat gvl_##name##_stat = { #name, 0, 0 };
+
+#define DEFINE_GVL_STAT_LIST(name, when_non_void, rettype, lastparamtype, lastparamname, fast_path) \
+	&gvl_##name##_stat,
+
+/*
+ * The GVL is kept while calling the libpq function, if fast_path evaluates to true.
+ * This is used to avoid two GVL handoffs for calls which are known not to block.
+ */
+#define DEFINE_GVL_STUB(name, when_non_void, rettype, lastparamtype, lastparamname, fast_path) \
 	rettype gvl_##name(FOR_EACH_PARAM_OF_##name(DEFINE_PARAM_LIST3) lastparamtype lastparamname){ \
 		struct gvl_wrapper_##name##_params params = { \
 			{FOR_EACH_PARAM_OF_##name(DEFINE_PARAM_LIST1) lastparamname}, when_non_void((rettype)0) \
 		}; \
-		rb_thread_call_without_gvl(gvl_##name##_skeleton, &params, RUBY_UBF_IO, 0); \
+		if( fast_path ){ \
+			PG_GVL_STAT_INC(gvl_##name##_stat.nonblocking); \
+			gvl_##name##_skeleton(&params); \
+		} else { \
+			PG_GVL_STAT_INC(gvl_##name##_stat.blocking); \
+			rb_thread_call_without_gvl(gvl_##name##_skeleton, &params, RUBY_UBF_IO, 0); \
+		} \
 		when_non_void( return params.retval; ) \
 	}
 #else
-#define DEFINE_GVL_STUB(name, when_non_void, rettype, lastparamtype, lastparamname) \
+#define DEFINE_GVL_STUB(name, when_non_void, rettype, lastparamtype, lastparamname, fast_path) \
 	rettype gvl_##name(FOR_EACH_PARAM_OF_##name(DEFINE_PARAM_LIST3) lastparamtype lastparamname){ \
 		when_non_void( return ) \
 			name( FOR_EACH_PARAM_OF_##name(DEFINE_PARAM_LIST1) lastparamname ); \
 	}
 #endif
 
-#define DEFINE_GVL_STUB_DECL(name, when_non_void, rettype, lastparamtype, lastparamname) \
+#define DEFINE_GVL_STUB_DECL(name, when_non_void, rettype, lastparamtype, lastparamname, fast_path) \
 	rettype gvl_##name(FOR_EACH_PARAM_OF_##name(DEFINE_PARAM_LIST3) lastparamtype lastparamname);
 
-#define DEFINE_GVLCB_SKELETON(name, when_non_void, rettype, lastparamtype, lastparamname) \
+#define DEFINE_GVLCB_SKELETON(name, when_non_void, rettype, lastparamtype, lastparamname, fast_path) \
 	static void * gvl_##name##_skeleton( void *data ){ \
 		struct gvl_wrapper_##name##_params *p = (struct gvl_wrapper_##name##_params*)data; \
 		when_non_void( p->retval = ) \
@@ -83,7 +108,7 @@ typedef struct pg_cancel_conn PGcancelConn;
 	}
 
 #ifdef ENABLE_GVL_UNLOCK
-#define DEFINE_GVLCB_STUB(name, when_non_void, rettype, lastparamtype, lastparamname) \
+#define DEFINE_GVLCB_STUB(name, when_non_void, rettype, lastparamtype, lastparamname, fast_path) \
 	rettype gvl_##name(FOR_EACH_PARAM_OF_##name(DEFINE_PARAM_LIST3) lastparamtype lastparamname){ \
 		struct gvl_wrapper_##name##_params params = { \
 			{FOR_EACH_PARAM_OF_##name(DEFINE_PARAM_LIST1) lastparamname}, when_non_void((rettype)0) \
@@ -92,7 +117,7 @@ typedef struct pg_cancel_conn PGcancelConn;
 		when_non_void( return params.retval; ) \
 	}
 #else
-#define DEFINE_GVLCB_STUB(name, when_non_void, rettype, lastparamtype, lastparamname) \
+#define DEFINE_GVLCB_STUB(name, when_non_void, rettype, lastparamtype, lastparamname, fast_path) \
 	rettype gvl_##name(FOR_EACH_PARAM_OF_##name(DEFINE_PARAM_LIST3) lastparamtype lastparamname){ \
 		when_non_void( return ) \
 			name( FOR_EACH_PARAM_OF_##name(DEFINE_PARAM_LIST1) lastparamname ); \
@@ -102,6 +127,29 @@ typedef struct pg_cancel_conn PGcancelConn;
 #define GVL_TYPE_VOID(string)
 #define GVL_TYPE_NONVOID(string) string
 
+/*
+ * Conditions for the fast path of the adaptive GVL mode (see PG.gvl_adaptive=)
+ */
+#define GVL_SKIP_NEVER 0
+/* The function doesn't wait for the socket - it only processes buffered data. */
+#define GVL_SKIP_IF_ADAPTIVE(conn) pg_gvl_fast_path_p(conn)
+/* The function doesn't wait for the socket in nonblocking mode. */
+#define GVL_SKIP_IF_NONBLOCKING(conn) (pg_gvl_fast_path_p(conn) && PQisnonblocking(conn))
+/* A complete result is already buffered. */
+#define GVL_SKIP_IF_NOT_BUSY(conn) (pg_gvl_fast_path_p(conn) && !PQisBusy(conn))
+
+struct pg_gvl_stat {
+	const char *name;
+	/* Number of calls with released GVL */
+	size_t blocking;
+	/* Number of calls on the fast path */
+	size_t nonblocking;
+};
+
+extern int pg_gvl_adaptive;
+int pg_gvl_fast_path_p( PGconn *conn );
+VALUE pg_gvl_stats( void );
+
 
 /*
  * Definitions of blocking functions and their parameters
@@ -234,45 +282,45 @@ typedef struct pg_cancel_conn PGcancelConn;
 	param(PGcancel *, cancel) \
 	param(char *, errbuf)
 
-/* function( name, void_or_nonvoid, returntype, lastparamtype, lastparamname ) */
+/* function( name, void_or_nonvoid, returntype, lastparamtype, lastparamname, fast_path ) */
 #define FOR_EACH_BLOCKING_FUNCTION(function) \
-	function(PQconnectdb, GVL_TYPE_NONVOID, PGconn *, const char *, conninfo) \
-	function(PQconnectStart, GVL_TYPE_NONVOID, PGconn *, const char *, conninfo) \
-	function(PQconnectPoll, GVL_TYPE_NONVOID, PostgresPollingStatusType, PGconn *, conn) \
-	function(PQreset, GVL_TYPE_VOID, void, PGconn *, conn) \
-	function(PQresetStart, GVL_TYPE_NONVOID, int, PGconn *, conn) \
-	function(PQresetPoll, GVL_TYPE_NONVOID, PostgresPollingStatusType, PGconn *, conn) \
-	function(PQping, GVL_TYPE_NONVOID, PGPing, const char *, conninfo) \
-	function(PQexec, GVL_TYPE_NONVOID, PGresult *, const char *, command) \
-	function(PQexecParams, GVL_TYPE_NONVOID, PGresult *, int, resultFormat) \
-	function(PQexecPrepared, GVL_TYPE_NONVOID, PGresult *, int, resultFormat) \
-	function(PQprepare, GVL_TYPE_NONVOID, PGresult *, const Oid *, paramTypes) \
-	function(PQdescribePrepared, GVL_TYPE_NONVOID, PGresult *, const char *, stmtName) \
-	function(PQdescribePortal, GVL_TYPE_NONVOID, PGresult *, const char *, portalName) \
-	function(PQclosePrepared, GVL_TYPE_NONVOID, PGresult *, const char *, stmtName) \
-	function(PQclosePortal, GVL_TYPE_NONVOID, PGresult *, const char *, portalName) \
-	function(PQgetResult, GVL_TYPE_NONVOID, PGresult *, PGconn *, conn) \
-	function(PQputCopyData, GVL_TYPE_NONVOID, int, int, nbytes) \
-	function(PQputCopyEnd, GVL_TYPE_NONVOID, int, const char *, errormsg) \
-	function(PQgetCopyData, GVL_TYPE_NONVOID, int, int, async) \
-	function(PQnotifies, GVL_TYPE_NONVOID, PGnotify *, PGconn *, conn) \
-	function(PQsendQuery, GVL_TYPE_NONVOID, int, const char *, query) \
-	function(PQsendQueryParams, GVL_TYPE_NONVOID, int, int, resultFormat) \
-	function(PQsendPrepare, GVL_TYPE_NONVOID, int, const Oid *, paramTypes) \
-	function(PQsendQueryPrepared, GVL_TYPE_NONVOID, int, int, resultFormat) \
-	function(PQsendDescribePrepared, GVL_TYPE_NONVOID, int, const char *, stmt) \
-	function(PQsendDescribePortal, GVL_TYPE_NONVOID, int, const char *, portal) \
-	function(PQsendClosePrepared, GVL_TYPE_NONVOID, int, const char *, stmt) \
-	function(PQsendClosePortal, GVL_TYPE_NONVOID, int, const char *, portal) \
-	function(PQpipelineSync, GVL_TYPE_NONVOID, int, PGconn *, conn) \
-	function(PQsendPipelineSync, GVL_TYPE_NONVOID, int, PGconn *, conn) \
-	function(PQsetClientEncoding, GVL_TYPE_NONVOID, int, const char *, encoding) \
-	function(PQisBusy, GVL_TYPE_NONVOID, int, PGconn *, conn) \
-	function(PQcancelBlocking, GVL_TYPE_NONVOID, int, PGcancelConn *, conn) \
-	function(PQcancelStart, GVL_TYPE_NONVOID, int, PGcancelConn *, conn) \
-	function(PQcancelPoll, GVL_TYPE_NONVOID, PostgresPollingStatusType, PGcancelConn *, conn) \
-	function(PQencryptPasswordConn, GVL_TYPE_NONVOID, char *, const char *, algorithm) \
-	function(PQcancel, GVL_TYPE_NONVOID, int, int, errbufsize);
+	function(PQconnectdb, GVL_TYPE_NONVOID, PGconn *, const char *, conninfo, GVL_SKIP_NEVER) \
+	function(PQconnectStart, GVL_TYPE_NONVOID, PGconn *, const char *, conninfo, GVL_SKIP_NEVER) \
+	function(PQconnectPoll, GVL_TYPE_NONVOID, PostgresPollingStatusType, PGconn *, conn, GVL_SKIP_NEVER) \
+	function(PQreset, GVL_TYPE_VOID, void, PGconn *, conn, GVL_SKIP_NEVER) \
+	function(PQresetStart, GVL_TYPE_NONVOID, int, PGconn *, conn, GVL_SKIP_NEVER) \
+	function(PQresetPoll, GVL_TYPE_NONVOID, PostgresPollingStatusType, PGconn *, conn, GVL_SKIP_NEVER) \
+	function(PQping, GVL_TYPE_NONVOID, PGPing, const char *, conninfo, GVL_SKIP_NEVER) \
+	function(PQexec, GVL_TYPE_NONVOID, PGresult *, const char *, command, GVL_SKIP_NEVER) \
+	function(PQexecParams, GVL_TYPE_NONVOID, PGresult *, int, resultFormat, GVL_SKIP_NEVER) \
+	function(PQexecPrepared, GVL_TYPE_NONVOID, PGresult *, int, resultFormat, GVL_SKIP_NEVER) \
+	function(PQprepare, GVL_TYPE_NONVOID, PGresult *, const Oid *, paramTypes, GVL_SKIP_NEVER) \
+	function(PQdescribePrepared, GVL_TYPE_NONVOID, PGresult *, const char *, stmtName, GVL_SKIP_NEVER) \
+	function(PQdescribePortal, GVL_TYPE_NONVOID, PGresult *, const char *, portalName, GVL_SKIP_NEVER) \
+	function(PQclosePrepared, GVL_TYPE_NONVOID, PGresult *, const char *, stmtName, GVL_SKIP_NEVER) \
+	function(PQclosePortal, GVL_TYPE_NONVOID, PGresult *, const char *, portalName, GVL_SKIP_NEVER) \
+	function(PQgetResult, GVL_TYPE_NONVOID, PGresult *, PGconn *, conn, GVL_SKIP_IF_NOT_BUSY(conn)) \
+	function(PQputCopyData, GVL_TYPE_NONVOID, int, int, nbytes, GVL_SKIP_IF_NONBLOCKING(conn)) \
+	function(PQputCopyEnd, GVL_TYPE_NONVOID, int, const char *, errormsg, GVL_SKIP_IF_NONBLOCKING(conn)) \
+	function(PQgetCopyData, GVL_TYPE_NONVOID, int, int, async, (async && GVL_SKIP_IF_ADAPTIVE(conn))) \
+	function(PQnotifies, GVL_TYPE_NONVOID, PGnotify *, PGconn *, conn, GVL_SKIP_IF_ADAPTIVE(conn)) \
+	function(PQsendQuery, GVL_TYPE_NONVOID, int, const char *, query, GVL_SKIP_IF_NONBLOCKING(conn)) \
+	function(PQsendQueryParams, GVL_TYPE_NONVOID, int, int, resultFormat, GVL_SKIP_IF_NONBLOCKING(conn)) \
+	function(PQsendPrepare, GVL_TYPE_NONVOID, int, const Oid *, paramTypes, GVL_SKIP_IF_NONBLOCKING(conn)) \
+	function(PQsendQueryPrepared, GVL_TYPE_NONVOID, int, int, resultFormat, GVL_SKIP_IF_NONBLOCKING(conn)) \
+	function(PQsendDescribePrepared, GVL_TYPE_NONVOID, int, const char *, stmt, GVL_SKIP_IF_NONBLOCKING(conn)) \
+	function(PQsendDescribePortal, GVL_TYPE_NONVOID, int, const char *, portal, GVL_SKIP_IF_NONBLOCKING(conn)) \
+	function(PQsendClosePrepared, GVL_TYPE_NONVOID, int, const char *, stmt, GVL_SKIP_IF_NONBLOCKING(conn)) \
+	function(PQsendClosePortal, GVL_TYPE_NONVOID, int, const char *, portal, GVL_SKIP_IF_NONBLOCKING(conn)) \
+	function(PQpipelineSync, GVL_TYPE_NONVOID, int, PGconn *, conn, GVL_SKIP_IF_NONBLOCKING(conn)) \
+	function(PQsendPipelineSync, GVL_TYPE_NONVOID, int, PGconn *, conn, GVL_SKIP_IF_NONBLOCKING(conn)) \
+	function(PQsetClientEncoding, GVL_TYPE_NONVOID, int, const char *, encoding, GVL_SKIP_NEVER) \
+	function(PQisBusy, GVL_TYPE_NONVOID, int, PGconn *, conn, GVL_SKIP_IF_ADAPTIVE(conn)) \
+	function(PQcancelBlocking, GVL_TYPE_NONVOID, int, PGcancelConn *, conn, GVL_SKIP_NEVER) \
+	function(PQcancelStart, GVL_TYPE_NONVOID, int, PGcancelConn *, conn, GVL_SKIP_NEVER) \
+	function(PQcancelPoll, GVL_TYPE_NONVOID, PostgresPollingStatusType, PGcancelConn *, conn, GVL_SKIP_NEVER) \
+	function(PQencryptPasswordConn, GVL_TYPE_NONVOID, char *, const char *, algorithm, GVL_SKIP_NEVER) \
+	function(PQcancel, GVL_TYPE_NONVOID, int, int, errbufsize, GVL_SKIP_NEVER)
 
 FOR_EACH_BLOCKING_FUNCTION( DEFINE_GVL_STUB_DECL );
 
@@ -287,10 +335,10 @@ FOR_EACH_BLOCKING_FUNCTION( DEFINE_GVL_STUB_DECL );
 #define FOR_EACH_PARAM_OF_notice_receiver_proxy(param) \
 	param(void *, arg)
 
-/* function( name, void_or_nonvoid, returntype, lastparamtype, lastparamname ) */
+/* function( name, void_or_nonvoid, returntype, lastparamtype, lastparamname, fast_path ) */
 #define FOR_EACH_CALLBACK_FUNCTION(function) \
-	function(notice_processor_proxy, GVL_TYPE_VOID, void, const char *, message) \
-	function(notice_receiver_proxy, GVL_TYPE_VOID, void, const PGresult *, result) \
+	function(notice_processor_proxy, GVL_TYPE_VOID, void, const char *, message, GVL_SKIP_NEVER) \
+	function(notice_receiver_proxy, GVL_TYPE_VOID, void, const PGresult *, result, GVL_SKIP_NEVER) \
 
 FOR_EACH_CALLBACK_FUNCTION( DEFINE_GVL_STUB_DECL );
 
@@ -46,6 +46,7 @@
  */
 
 #include "pg.h"
+#include "pg_util.h"
 
 int pg_skip_deprecation_warning;
 VALUE rb_mPG;
@@ -327,6 +328,106 @@ pg_s_init_ssl(VALUE self, VALUE do_ssl)
 }
 
 
+/*
+ * call-seq:
+ *    PG.gvl_adaptive = Boolean
+ *
+ * Enable or disable the adaptive GVL mode.
+ *
+ * By default the Ruby GVL is released on each call to a possibly blocking libpq function, so that other threads can run while waiting for the server.
+ * In adaptive mode the GVL is kept for calls that are known not to block:
+ * * sending queries and COPY data on a nonblocking connection (the default with <tt>PG::Connection.async_api = true</tt>)
+ * * retrieving a result which is already completely received
+ * * +PQisBusy+, +PQnotifies+ and nonblocking +PQgetCopyData+, which only process data already read from the socket
+ *
+ * This saves two GVL handoffs per call, which is noticeable for small queries at high rates.
+ * The fast path is not used for connections with a notice receiver or notice processor.
+ *
+ * The mode is global for all connections and is disabled by default.
+ * See PG.gvl_stats for the number of calls on each path.
+ */
+static VALUE
+pg_s_gvl_adaptive_set(VALUE self, VALUE enable)
+{
+	UNUSED( self );
+	pg_gvl_adaptive = RTEST(enable);
+	return enable;
+}
+
+/*
+ * call-seq:
+ *    PG.gvl_adaptive -> Boolean
+ *
+ * Returns +true+ if the adaptive GVL mode is enabled.
+ * See PG.gvl_adaptive= .
+ */
+static VALUE
+pg_s_gvl_adaptive_get(VALUE self)
+{
+	UNUSED( self );
+	return pg_gvl_adaptive ? Qtrue : Qfalse;
+}
+
+/*
+ * call-seq:
+ *    PG.gvl_stats -> Hash
+ *
+ * Returns the number of calls of each libpq function with released GVL (+:blocking+) and on the fast path of the adaptive GVL mode (+:nonblocking+).
+ *
+ *   PG.gvl_stats  # => {"PQisBusy"=>{:blocking=>2, :nonblocking=>14}, "PQgetResult"=>{:blocking=>0, :nonblocking=>8}, ...}
+ *
+ * The counters are process global and don't distinguish between connections.
+ * Functions which were not called yet are not part of the Hash.
+ * An empty Hash is returned, if pg is compiled without GVL unlock.
+ */
+static VALUE
+pg_s_gvl_stats(VALUE self)
+{
+	UNUSED( self );
+	return pg_gvl_stats();
+}
+
+/*
+ * call-seq:
+ *    PG.simd -> Symbol
+ *
+ * Returns the implementation used to scan COPY text data for special characters.
+ *
+ * * +:avx2+ compares 32 bytes at once
+ * * +:sse2+ compares 16 bytes at once
+ * * +:swar+ compares 8 bytes at once on CPUs without SSE2
+ * * +:scalar+ compares byte by byte
+ *
+ * The fastest implementation supported by the CPU is selected when pg is loaded.
+ */
+static VALUE
+pg_s_simd_get(VALUE self)
+{
+	UNUSED( self );
+	return ID2SYM(rb_intern(rbpg_simd_name()));
+}
+
+/*
+ * call-seq:
+ *    PG.simd = Symbol
+ *
+ * Select the implementation used to scan COPY text data.
+ * This is intended for benchmarks and tests only.
+ * Raises an ArgumentError if the implementation is unknown or not supported by the CPU.
+ *
+ * See PG.simd .
+ */
+static VALUE
+pg_s_simd_set(VALUE self, VALUE name)
+{
+	UNUSED( self );
+	if( !rbpg_simd_select(rb_id2name(rb_to_id(name))) ){
+		rb_raise( rb_eArgError, "unsupported implementation: %" PRIsVALUE, name );
+	}
+	return name;
+}
+
+
 /**************************************************************************
  * Initializer
  **************************************************************************/
@@ -360,6 +461,14 @@ Init_pg_ext(void)
 	rb_define_singleton_method( rb_mPG, "init_openssl", pg_s_init_openssl, 2 );
 	rb_define_singleton_method( rb_mPG, "init_ssl", pg_s_init_ssl, 1 );
 
+	rb_define_singleton_method( rb_mPG, "gvl_adaptive=", pg_s_gvl_adaptive_set, 1 );
+	rb_define_singleton_method( rb_mPG, "gvl_adaptive", pg_s_gvl_adaptive_get, 0 );
+	rb_define_singleton_method( rb_mPG, "gvl_stats", pg_s_gvl_stats, 0 );
+
+	rbpg_simd_init();
+	rb_define_singleton_method( rb_mPG, "simd", pg_s_simd_get, 0 );
+	rb_define_singleton_method( rb_mPG, "simd=", pg_s_simd_set, 1 );
+
 
 	/******     PG::Connection CLASS CONSTANTS: Connection Status     ******/
 
@@ -698,6 +807,10 @@ Init_pg_ext(void)
 	init_pg_binary_decoder();
 	init_pg_copycoder();
 	init_pg_recordcoder();
+	init_pg_jsoncoder();
+	init_pg_uuidcoder();
+	init_pg_intervalcoder();
 	init_pg_tuple();
 	init_pg_cancon();
+	init_pg_replication();
 }
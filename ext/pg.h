@@ -115,12 +115,18 @@ typedef struct {
 	VALUE encoder_for_put_copy_data;
 	/* Kind of PG::Coder object for casting COPY rows to ruby values */
 	VALUE decoder_for_get_copy_data;
+	/* COPY progress counters or NULL if disabled */
+	struct pg_copy_stats *copy_stats;
+	/* Proc object called with the COPY progress counters */
+	VALUE copy_progress;
 	/* Ruby encoding index of the client/internal encoding */
 	int enc_idx : PG_ENC_IDX_BITS;
 	/* flags controlling Symbol/String field names */
 	unsigned int flags : 1;
 	/* enable automatic flushing of send data at the end of send_query calls */
 	unsigned int flush_data : 1;
+	/* the end of COPY OUT data was reached by get_copy_rows, but not yet reported */
+	unsigned int copy_out_done : 1;
 
 	/* File descriptor to be used for rb_w32_unwrap_io_handle() */
 	int ruby_sd;
@@ -194,6 +200,18 @@ typedef VALUE (* t_pg_typecast_copy_get)( t_typemap *, VALUE, int, int, int );
 #define PG_CODER_FORMAT_ERROR_TO_RAISE 0x4
 #define PG_CODER_FORMAT_ERROR_TO_STRING 0x8
 #define PG_CODER_FORMAT_ERROR_TO_PARTIAL 0xc
+#define PG_CODER_JSON_SYMBOLIZE_NAMES 0x10
+#define PG_CODER_JSON_DEEP_FREEZE 0x20
+#define PG_CODER_JSON_BIGDECIMAL 0x40
+#define PG_CODER_TIMESTAMP_CACHE 0x80
+#define PG_CODER_NUMERIC_TO_INTEGER 0x100
+#define PG_CODER_NUMERIC_TO_FLOAT 0x200
+#define PG_CODER_UUID_BINARY 0x400
+#define PG_CODER_UUID_INTERN 0x800
+#define PG_CODER_INTERVAL_TO_SECONDS 0x1000
+
+/* Size of a raw timestamp value that is kept in t_pg_timestamp_cache_entry */
+#define PG_TIMESTAMP_CACHE_RAW_LEN 48
 
 struct pg_coder {
 	t_pg_coder_enc_func enc_func;
@@ -205,6 +223,20 @@ struct pg_coder {
 	int flags;
 };
 
+/* Memo of the last decoded timestamp of a column, used with PG_CODER_TIMESTAMP_CACHE */
+typedef struct {
+	/* format and flags of the coder that filled the entry */
+	int format;
+	int flags;
+	/* raw value of the cached Time object or -1 */
+	int len;
+	char raw[PG_TIMESTAMP_CACHE_RAW_LEN];
+	VALUE time;
+	/* date part of the last text timestamp and its seconds since epoch at midnight UTC, day 0 if empty */
+	int year, mon, day;
+	time_t day_sec;
+} t_pg_timestamp_cache_entry;
+
 typedef struct {
 	t_pg_coder comp;
 	t_pg_coder *elem;
@@ -228,11 +260,30 @@ struct pg_typemap {
 typedef struct {
 	t_typemap typemap;
 	int nfields;
+	/* Incremented by each call to #initialize on the same object */
+	int generation;
 	struct pg_tmbc_converter {
 		t_pg_coder *cconv;
 	} convs[0];
 } t_tmbc;
 
+/* Representations of the columns of a COPY row plan.
+ * These are encoded and decoded inline by PG::BinaryEncoder::CopyRow, PG::BinaryDecoder::CopyRow
+ * and PG::TextDecoder::CopyRow. */
+enum pg_bin_kind {
+	PG_BIN_GENERIC = 0, /* call the coder of the type map */
+	PG_BIN_BOOLEAN,
+	PG_BIN_INT2,
+	PG_BIN_INT4,
+	PG_BIN_INT8,
+	PG_BIN_INTEGER,     /* decoder of int2, int4 or int8 depending on the length */
+	PG_BIN_FLOAT4,
+	PG_BIN_FLOAT8,
+	PG_BIN_FLOAT,       /* decoder of float4 or float8 depending on the length */
+	PG_BIN_DIRECT,      /* decoder which reads the field data in place */
+	PG_TEXT_INTEGER,    /* text decoder of integers, parsed in place by PG::TextDecoder::CopyRow */
+};
+
 extern const rb_data_type_t pg_typemap_type;
 extern const rb_data_type_t pg_coder_type;
 
@@ -251,6 +302,7 @@ extern VALUE rb_eConnectionBad;
 extern VALUE rb_eInvalidResultStatus;
 extern VALUE rb_eNoResultError;
 extern VALUE rb_eInvalidChangeOfResultFields;
+extern VALUE rb_eQueryTimeout;
 extern VALUE rb_mPGconstants;
 extern VALUE rb_cPGconn;
 extern VALUE rb_cPGresult;
@@ -302,19 +354,31 @@ void init_pg_type_map_in_ruby                          _(( void ));
 void init_pg_coder                                     _(( void ));
 void init_pg_copycoder                                 _(( void ));
 void init_pg_recordcoder                               _(( void ));
+void init_pg_jsoncoder                                 _(( void ));
+void init_pg_uuidcoder                                 _(( void ));
+void init_pg_intervalcoder                             _(( void ));
 void init_pg_text_encoder                              _(( void ));
 void init_pg_text_decoder                              _(( void ));
 void init_pg_binary_encoder                            _(( void ));
 void init_pg_binary_decoder                            _(( void ));
 void init_pg_tuple                                     _(( void ));
 void init_pg_cancon                                    _(( void ));
+void init_pg_replication                               _(( void ));
 VALUE lookup_error_class                               _(( const char * ));
 VALUE pg_bin_dec_bytea                                 _(( t_pg_coder*, const char *, int, int, int, int ));
 VALUE pg_text_dec_string                               _(( t_pg_coder*, const char *, int, int, int, int ));
+VALUE pg_text_dec_integer                              _(( t_pg_coder*, const char *, int, int, int, int ));
+VALUE pg_text_dec_numeric                              _(( t_pg_coder*, const char *, int, int, int, int ));
 int pg_coder_enc_to_s                                  _(( t_pg_coder*, VALUE, char *, VALUE *, int));
 int pg_text_enc_identifier                             _(( t_pg_coder*, VALUE, char *, VALUE *, int));
 t_pg_coder_enc_func pg_coder_enc_func                  _(( t_pg_coder* ));
 t_pg_coder_dec_func pg_coder_dec_func                  _(( t_pg_coder*, int ));
+int pg_bin_enc_kind                                    _(( t_pg_coder_enc_func ));
+int pg_bin_dec_kind                                    _(( t_pg_coder_dec_func ));
+int pg_copycoder_enc_append                            _(( t_pg_coder *, VALUE, VALUE, int ));
+void pg_j2date                                         _(( int, int *, int *, int * ));
+t_pg_timestamp_cache_entry *pg_timestamp_cache_entry   _(( t_pg_coder *, int ));
+VALUE pg_timestamp_cache_store                         _(( t_pg_timestamp_cache_entry *, const char *, int, VALUE ));
 VALUE pg_define_coder                                  _(( const char *, void *, VALUE, VALUE ));
 VALUE pg_obj_to_i                                      _(( VALUE ));
 VALUE pg_tmbc_allocate                                 _(( void ));
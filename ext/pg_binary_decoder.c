@@ -297,12 +297,15 @@ length_error:
  * * +PG::Coder::TIMESTAMP_APP_UTC+ : Return timestamp as UTC time (default)
  * * +PG::Coder::TIMESTAMP_APP_LOCAL+ : Return timestamp as local time
  *
+ * The flag +PG::Coder::TIMESTAMP_CACHE+ enables a cache of the last decoded timestamp per column.
+ * A repeated value of a column returns the same Time object, which is therefore frozen.
+ *
  * Example:
  *   deco = PG::BinaryDecoder::Timestamp.new(flags: PG::Coder::TIMESTAMP_DB_UTC | PG::Coder::TIMESTAMP_APP_LOCAL)
  *   deco.decode("\0"*8)  # => 2000-01-01 01:00:00 +0100
  */
 static VALUE
-pg_bin_dec_timestamp(t_pg_coder *conv, const char *val, int len, int tuple, int field, int enc_idx)
+pg_bin_dec_timestamp_convert(t_pg_coder *conv, const char *val, int len, int tuple, int field, int enc_idx)
 {
 	int64_t timestamp;
 	int64_t sec;
@@ -346,6 +349,23 @@ pg_bin_dec_timestamp(t_pg_coder *conv, const char *val, int len, int tuple, int
 	}
 }
 
+static VALUE
+pg_bin_dec_timestamp(t_pg_coder *conv, const char *val, int len, int tuple, int field, int enc_idx)
+{
+	t_pg_timestamp_cache_entry *entry;
+
+	if( !(conv->flags & PG_CODER_TIMESTAMP_CACHE) ){
+		return pg_bin_dec_timestamp_convert(conv, val, len, tuple, field, enc_idx);
+	}
+
+	entry = pg_timestamp_cache_entry(conv, field);
+	if( entry->len == len && memcmp(entry->raw, val, len) == 0 ){
+		return entry->time;
+	}
+	return pg_timestamp_cache_store(entry, val, len,
+			pg_bin_dec_timestamp_convert(conv, val, len, tuple, field, enc_idx));
+}
+
 #define PG_INT32_MIN    (-0x7FFFFFFF-1)
 #define PG_INT32_MAX    (0x7FFFFFFF)
 #define POSTGRES_EPOCH_JDATE   2451545 /* == date2j(2000, 1, 1) */
@@ -353,7 +373,7 @@ pg_bin_dec_timestamp(t_pg_coder *conv, const char *val, int len, int tuple, int
 
 /* taken from PostgreSQL sources at src/backend/utils/adt/datetime.c */
 void
-j2date(int jd, int *year, int *month, int *day)
+pg_j2date(int jd, int *year, int *month, int *day)
 {
 	unsigned int julian;
 	unsigned int quad;
@@ -375,7 +395,7 @@ j2date(int jd, int *year, int *month, int *day)
 	quad = julian * 2141 / 65536;
 	*day = julian - 7834 * quad / 256;
 	*month = (quad + 10) % MONTHS_PER_YEAR + 1;
-}								/* j2date() */
+}								/* pg_j2date() */
 
 /*
  * Document-class: PG::BinaryDecoder::Date < PG::SimpleDecoder
@@ -402,7 +422,7 @@ pg_bin_dec_date(t_pg_coder *conv, const char *val, int len, int tuple, int field
 		case PG_INT32_MIN:
 			return rb_str_new2("-infinity");
 		default:
-			j2date(date + POSTGRES_EPOCH_JDATE, &year, &month, &day);
+			pg_j2date(date + POSTGRES_EPOCH_JDATE, &year, &month, &day);
 
 			return rb_funcall(s_Date, s_id_new, 4, INT2NUM(year), INT2NUM(month), INT2NUM(day), s_Date_GREGORIAN);
 	}
@@ -425,6 +445,143 @@ init_pg_bin_decoder_date(VALUE rb_mPG_BinaryDecoder)
 	return Qnil;
 }
 
+#define NUMERIC_POS     0x0000
+#define NUMERIC_NEG     0x4000
+#define NUMERIC_NAN     0xC000
+#define NUMERIC_PINF    0xD000
+#define NUMERIC_NINF    0xF000
+
+/*
+ * Document-class: PG::BinaryDecoder::Numeric < PG::SimpleDecoder
+ *
+ * This is a decoder class for conversion of PostgreSQL binary +numeric+ type
+ * to Ruby BigDecimal objects.
+ *
+ * The target classes are chosen per PG::Coder#flags= like with PG::TextDecoder::Numeric .
+ * Integer values of up to 16 digits are converted directly from the base-10000 digit groups.
+ * All other values are converted to decimal text first.
+ *
+ * As soon as this class is used, it requires the 'bigdecimal' gem.
+ */
+static VALUE
+pg_bin_dec_numeric(t_pg_coder *conv, const char *val, int len, int tuple, int field, int enc_idx)
+{
+	int ndigits, weight, sign, dscale;
+	int i, d, need;
+	char buf[128];
+	char *out, *start;
+	VALUE tmp = Qnil;
+
+	if( len < 8 ){
+		rb_raise( rb_eTypeError, "wrong data for binary numeric converter in tuple %d field %d", tuple, field);
+	}
+	ndigits = read_nbo16(val);
+	weight = read_nbo16(val + 2);
+	sign = (uint16_t)read_nbo16(val + 4);
+	dscale = read_nbo16(val + 6);
+	if( ndigits < 0 || dscale < 0 || len != 8 + 2 * ndigits ){
+		rb_raise( rb_eTypeError, "wrong data for binary numeric converter in tuple %d field %d", tuple, field);
+	}
+	val += 8;
+
+	switch( sign ){
+		case NUMERIC_POS:
+		case NUMERIC_NEG:
+			break;
+		case NUMERIC_NAN:
+			return pg_text_dec_numeric(conv, "NaN", 3, tuple, field, enc_idx);
+		case NUMERIC_PINF:
+			return pg_text_dec_numeric(conv, "Infinity", 8, tuple, field, enc_idx);
+		case NUMERIC_NINF:
+			return pg_text_dec_numeric(conv, "-Infinity", 9, tuple, field, enc_idx);
+		default:
+			rb_raise( rb_eTypeError, "wrong sign for binary numeric converter in tuple %d field %d", tuple, field);
+	}
+
+	/* Trailing zero digit groups are not sent, so that there's no fractional part if ndigits <= weight + 1 */
+	if( (conv->flags & PG_CODER_NUMERIC_TO_INTEGER) && ndigits <= weight + 1 && weight < 4 ){
+		int64_t v = 0;
+		for( i = 0; i <= weight; i++ ){
+			v = v * 10000 + (i < ndigits ? read_nbo16(val + 2 * i) : 0);
+		}
+		return LL2NUM(sign == NUMERIC_NEG ? -v : v);
+	}
+
+	/* Convert to text like PostgreSQL's numeric_out() */
+	need = 1 + (weight < 0 ? 1 : (weight + 1) * 4) + 1 + dscale + 4;
+	if( need > (int)sizeof(buf) ){
+		tmp = rb_str_new(NULL, need);
+		start = RSTRING_PTR(tmp);
+	} else {
+		start = buf;
+	}
+	out = start;
+	if( sign == NUMERIC_NEG ) *out++ = '-';
+
+	if( weight < 0 ){
+		*out++ = '0';
+	} else {
+		for( i = 0; i <= weight; i++ ){
+			d = i < ndigits ? read_nbo16(val + 2 * i) : 0;
+			if( d < 0 || d > 9999 ){
+				rb_raise( rb_eTypeError, "wrong digit for binary numeric converter in tuple %d field %d", tuple, field);
+			}
+			if( i == 0 ){
+				/* no leading zeros */
+				int n = d >= 1000 ? 4 : d >= 100 ? 3 : d >= 10 ? 2 : 1;
+				int j;
+				for( j = n - 1; j >= 0; j-- ){
+					out[j] = '0' + d % 10;
+					d /= 10;
+				}
+				out += n;
+			} else {
+				out[0] = '0' + d / 1000;
+				out[1] = '0' + d / 100 % 10;
+				out[2] = '0' + d / 10 % 10;
+				out[3] = '0' + d % 10;
+				out += 4;
+			}
+		}
+	}
+
+	if( dscale > 0 ){
+		char *frac_end;
+		*out++ = '.';
+		frac_end = out + dscale;
+		for( i = weight + 1; out < frac_end; i++ ){
+			d = i >= 0 && i < ndigits ? read_nbo16(val + 2 * i) : 0;
+			if( d < 0 || d > 9999 ){
+				rb_raise( rb_eTypeError, "wrong digit for binary numeric converter in tuple %d field %d", tuple, field);
+			}
+			out[0] = '0' + d / 1000;
+			out[1] = '0' + d / 100 % 10;
+			out[2] = '0' + d / 10 % 10;
+			out[3] = '0' + d % 10;
+			out += 4;
+		}
+		out = frac_end;
+	}
+
+	{
+		VALUE res = pg_text_dec_numeric(conv, start, (int)(out - start), tuple, field, enc_idx);
+		RB_GC_GUARD(tmp);
+		return res;
+	}
+}
+
+/* called per autoload when BinaryDecoder::Numeric is used */
+static VALUE
+init_pg_bin_decoder_numeric(VALUE rb_mPG_BinaryDecoder)
+{
+	rb_funcall(rb_mPG, rb_intern("require_bigdecimal_without_warning"), 0);
+
+	/* dummy = rb_define_class_under( rb_mPG_BinaryDecoder, "Numeric", rb_cPG_SimpleDecoder ); */
+	pg_define_coder( "Numeric", pg_bin_dec_numeric, rb_cPG_SimpleDecoder, rb_mPG_BinaryDecoder );
+
+	return Qnil;
+}
+
 
 /*
  * Document-class: PG::BinaryDecoder::String < PG::SimpleDecoder
@@ -435,12 +592,29 @@ init_pg_bin_decoder_date(VALUE rb_mPG_BinaryDecoder)
  *
  */
 
+/*
+ * Return the binary representation read by the given decoder function as one of PG_BIN_*.
+ *
+ * It is used by PG::BinaryDecoder::CopyRow to read fixed width values without calling the decoder
+ * and to pass the remaining binary fields in place instead of a copy.
+ */
+int
+pg_bin_dec_kind(t_pg_coder_dec_func dec_func)
+{
+	if( dec_func == pg_bin_dec_boolean ) return PG_BIN_BOOLEAN;
+	if( dec_func == pg_bin_dec_integer ) return PG_BIN_INTEGER;
+	if( dec_func == pg_bin_dec_float ) return PG_BIN_FLOAT;
+	if( dec_func == pg_bin_dec_timestamp || dec_func == pg_bin_dec_date ) return PG_BIN_DIRECT;
+	return PG_BIN_GENERIC;
+}
+
 void
 init_pg_binary_decoder(void)
 {
 	/* This module encapsulates all decoder classes with binary input format */
 	rb_mPG_BinaryDecoder = rb_define_module_under( rb_mPG, "BinaryDecoder" );
 	rb_define_private_method(rb_singleton_class(rb_mPG_BinaryDecoder), "init_date", init_pg_bin_decoder_date, 0);
+	rb_define_private_method(rb_singleton_class(rb_mPG_BinaryDecoder), "init_numeric", init_pg_bin_decoder_numeric, 0);
 
 	/* Make RDoc aware of the decoder classes... */
 	/* dummy = rb_define_class_under( rb_mPG_BinaryDecoder, "Boolean", rb_cPG_SimpleDecoder ); */
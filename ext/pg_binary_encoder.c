@@ -9,8 +9,12 @@
 #ifdef HAVE_INTTYPES_H
 #include <inttypes.h>
 #endif
+#include <math.h>
 
 VALUE rb_mPG_BinaryEncoder;
+static VALUE s_cBigDecimal;
+static VALUE s_str_F;
+static ID s_id_to_s;
 static ID s_id_gregorianP;
 static ID s_id_gregorian;
 static ID s_id_year;
@@ -511,6 +515,232 @@ pg_bin_enc_array(t_pg_coder *conv, VALUE value, char *out, VALUE *intermediate,
 	}
 }
 
+#define NUMERIC_POS     0x0000
+#define NUMERIC_NEG     0x4000
+#define NUMERIC_NAN     0xC000
+#define NUMERIC_PINF    0xD000
+#define NUMERIC_NINF    0xF000
+
+#define FLOOR_DIV4(p) ((p) >= 0 ? (p) / 4 : -((3 - (p)) / 4))
+
+/*
+ * Write a numeric value in binary format.
+ *
+ * The digits are taken from _s_ to _end_ and may contain one decimal point, which is skipped.
+ * They must not have leading or trailing zeros and _exp10_ is the decimal exponent of the last digit.
+ * Returns the number of bytes written.
+ */
+static int
+write_numeric(char *out, int sign, const char *s, const char *end, int exp10, int dscale)
+{
+	static const int pow10[] = { 1, 10, 100, 1000 };
+	char *start = out;
+	int ndigits = 0;
+	const char *p;
+	int first, weight, group, pos, acc;
+
+	for( p = s; p < end; p++ ){
+		if( *p != '.' ) ndigits++;
+	}
+	if( ndigits == 0 ){
+		/* zero */
+		write_nbo16(0, out);
+		write_nbo16(0, out + 2);
+		write_nbo16(NUMERIC_POS, out + 4);
+		write_nbo16(dscale, out + 6);
+		return 8;
+	}
+
+	first = exp10 + ndigits - 1;
+	weight = FLOOR_DIV4(first);
+	write_nbo16(weight - FLOOR_DIV4(exp10) + 1, out);
+	write_nbo16(weight, out + 2);
+	write_nbo16(sign, out + 4);
+	write_nbo16(dscale, out + 6);
+	out += 8;
+
+	group = weight;
+	acc = 0;
+	pos = first;
+	for( p = s; p < end; p++ ){
+		if( *p == '.' ) continue;
+		if( FLOOR_DIV4(pos) < group ){
+			write_nbo16(acc, out); out += 2;
+			acc = 0;
+			group--;
+		}
+		acc += (*p - '0') * pow10[pos - 4 * group];
+		pos--;
+	}
+	write_nbo16(acc, out); out += 2;
+
+	return (int)(out - start);
+}
+
+static int
+write_numeric_special(char *out, int sign)
+{
+	write_nbo16(0, out);
+	write_nbo16(0, out + 2);
+	write_nbo16(sign, out + 4);
+	write_nbo16(0, out + 6);
+	return 8;
+}
+
+/*
+ * Parse a decimal number like "-123.450" into the digit range and decimal exponent
+ * expected by write_numeric().
+ * Returns the sign or -1 if the string is not a valid number.
+ */
+static int
+parse_numeric(const char *s, const char *end, const char **dstart, const char **dend, int *exp10, int *dscale)
+{
+	int sign = NUMERIC_POS;
+	const char *p, *dot = NULL;
+
+	if( end - s == 3 && memcmp(s, "NaN", 3) == 0 ) return NUMERIC_NAN;
+	if( s < end && (*s == '-' || *s == '+') ){
+		if( *s == '-' ) sign = NUMERIC_NEG;
+		s++;
+	}
+	if( end - s == 8 && memcmp(s, "Infinity", 8) == 0 ) return sign == NUMERIC_NEG ? NUMERIC_NINF : NUMERIC_PINF;
+
+	for( p = s; p < end; p++ ){
+		if( *p == '.' && !dot ){
+			dot = p;
+		} else if( (unsigned char)(*p - '0') > 9 ){
+			return -1;
+		}
+	}
+	if( end == s || (dot && end - s == 1) ) return -1;
+
+	*dscale = dot ? (int)(end - dot - 1) : 0;
+	*exp10 = -*dscale;
+	/* strip trailing zeros */
+	while( end > s && (end[-1] == '0' || end[-1] == '.') ){
+		if( end[-1] == '0' ) ++*exp10;
+		end--;
+	}
+	/* strip leading zeros */
+	while( s < end && (*s == '0' || *s == '.') ) s++;
+
+	*dstart = s;
+	*dend = end;
+	return sign;
+}
+
+/*
+ * Document-class: PG::BinaryEncoder::Numeric < PG::SimpleEncoder
+ *
+ * This is the binary encoder class for the PostgreSQL +numeric+ type.
+ *
+ * It converts Integer, Float and BigDecimal objects to base-10000 digit groups.
+ * All other objects are expected to respond to +to_s+ with a decimal number.
+ *
+ * As soon as this class is used, it requires the 'bigdecimal' gem.
+ */
+static int
+pg_bin_enc_numeric(t_pg_coder *conv, VALUE value, char *out, VALUE *intermediate, int enc_idx)
+{
+	if(out){
+		VALUE v = *intermediate;
+
+		if( FIXNUM_P(v) ){
+			long l = FIX2LONG(v);
+			unsigned long u = l < 0 ? -(unsigned long)l : (unsigned long)l;
+			char digits[24];
+			char *end = digits + sizeof(digits);
+			char *p = end;
+			int exp10 = 0;
+
+			/* write the digits without trailing zeros */
+			for( ; u; u /= 10 ){
+				if( p == end && u % 10 == 0 ){
+					exp10++;
+				} else {
+					*--p = '0' + u % 10;
+				}
+			}
+			return write_numeric(out, l < 0 ? NUMERIC_NEG : NUMERIC_POS, p, end, exp10, 0);
+		} else if( RB_FLOAT_TYPE_P(v) ){
+			double d = RFLOAT_VALUE(v);
+			char digits[20];
+			int ndigits, exp10;
+
+			if( isnan(d) ) return write_numeric_special(out, NUMERIC_NAN);
+			if( isinf(d) ) return write_numeric_special(out, d < 0 ? NUMERIC_NINF : NUMERIC_PINF);
+			if( d == 0.0 ) return write_numeric(out, NUMERIC_POS, digits, digits, 0, 0);
+
+			ndigits = rbpg_dtoa_shortest(fabs(d), digits, &exp10);
+			return write_numeric(out, d < 0 ? NUMERIC_NEG : NUMERIC_POS, digits, digits + ndigits, exp10, exp10 < 0 ? -exp10 : 0);
+		} else {
+			const char *s = RSTRING_PTR(v);
+			const char *dstart, *dend;
+			int exp10, dscale;
+			int sign = parse_numeric(s, s + RSTRING_LEN(v), &dstart, &dend, &exp10, &dscale);
+
+			if( sign == NUMERIC_POS || sign == NUMERIC_NEG ){
+				return write_numeric(out, sign, dstart, dend, exp10, dscale);
+			}
+			return write_numeric_special(out, sign);
+		}
+	} else {
+		switch(TYPE(value)){
+			case T_FIXNUM:
+				*intermediate = value;
+				/* up to 19 digits are 5 digit groups */
+				return 8 + 2 * 5;
+			case T_FLOAT:
+				*intermediate = value;
+				/* up to 17 digits can span 6 digit groups */
+				return 8 + 2 * 6;
+			default: {
+				VALUE str;
+				const char *dstart, *dend;
+				int exp10, dscale;
+
+				if( RB_TYPE_P(value, T_BIGNUM) ){
+					str = rb_big2str(value, 10);
+				} else if( rb_obj_is_kind_of(value, s_cBigDecimal) ){
+					/* value.to_s('F') */
+					str = rb_funcall(value, s_id_to_s, 1, s_str_F);
+				} else {
+					str = rb_obj_as_string(value);
+				}
+				int sign = parse_numeric(RSTRING_PTR(str), RSTRING_END(str), &dstart, &dend, &exp10, &dscale);
+
+				if( sign < 0 ){
+					rb_raise( rb_eArgError, "invalid value for binary numeric: %+"PRIsVALUE, value );
+				}
+				/* PostgreSQL limits the weight to int16 and the display scale to 0x3FFF */
+				if( (sign == NUMERIC_POS || sign == NUMERIC_NEG) &&
+						(dscale > 0x3FFF || exp10 + (dend - dstart) > 4 * 0x7FFF || exp10 < -4 * 0x7FFF) ){
+					rb_raise( rb_eArgError, "value out of range for binary numeric: %+"PRIsVALUE, value );
+				}
+				*intermediate = str;
+				if( sign != NUMERIC_POS && sign != NUMERIC_NEG ) return 8;
+				return 8 + 2 * (int)((dend - dstart) / 4 + 2);
+			}
+		}
+	}
+}
+
+/* called per autoload when BinaryEncoder::Numeric is used */
+static VALUE
+init_pg_bin_encoder_numeric(VALUE rb_mPG_BinaryEncoder)
+{
+	rb_gc_register_address(&s_str_F);
+	s_str_F = rb_str_freeze(rb_str_new_cstr("F"));
+	rb_funcall(rb_mPG, rb_intern("require_bigdecimal_without_warning"), 0);
+	rb_gc_register_address(&s_cBigDecimal);
+	s_cBigDecimal = rb_const_get(rb_cObject, rb_intern("BigDecimal"));
+
+	/* dummy = rb_define_class_under( rb_mPG_BinaryEncoder, "Numeric", rb_cPG_SimpleEncoder ); */
+	pg_define_coder( "Numeric", pg_bin_enc_numeric, rb_cPG_SimpleEncoder, rb_mPG_BinaryEncoder );
+
+	return Qnil;
+}
+
 /*
  * Document-class: PG::BinaryEncoder::FromBase64 < PG::CompositeEncoder
  *
@@ -556,6 +786,23 @@ pg_bin_enc_from_base64(t_pg_coder *conv, VALUE value, char *out, VALUE *intermed
 	}
 }
 
+/*
+ * Return the binary representation written by the given encoder function as one of PG_BIN_*.
+ *
+ * It is used by PG::BinaryEncoder::CopyRow to write fixed width values without calling the encoder.
+ */
+int
+pg_bin_enc_kind(t_pg_coder_enc_func enc_func)
+{
+	if( enc_func == pg_bin_enc_boolean ) return PG_BIN_BOOLEAN;
+	if( enc_func == pg_bin_enc_int2 ) return PG_BIN_INT2;
+	if( enc_func == pg_bin_enc_int4 ) return PG_BIN_INT4;
+	if( enc_func == pg_bin_enc_int8 ) return PG_BIN_INT8;
+	if( enc_func == pg_bin_enc_float4 ) return PG_BIN_FLOAT4;
+	if( enc_func == pg_bin_enc_float8 ) return PG_BIN_FLOAT8;
+	return PG_BIN_GENERIC;
+}
+
 void
 init_pg_binary_encoder(void)
 {
@@ -564,9 +811,11 @@ init_pg_binary_encoder(void)
 	s_id_year = rb_intern("year");
 	s_id_month = rb_intern("month");
 	s_id_day = rb_intern("day");
+	s_id_to_s = rb_intern("to_s");
 
 	/* This module encapsulates all encoder classes with binary output format */
 	rb_mPG_BinaryEncoder = rb_define_module_under( rb_mPG, "BinaryEncoder" );
+	rb_define_private_method(rb_singleton_class(rb_mPG_BinaryEncoder), "init_numeric", init_pg_bin_encoder_numeric, 0);
 
 	/* Make RDoc aware of the encoder classes... */
 	/* dummy = rb_define_class_under( rb_mPG_BinaryEncoder, "Boolean", rb_cPG_SimpleEncoder ); */
@@ -627,6 +627,15 @@ init_pg_coder(void)
 	rb_define_const( rb_cPG_Coder, "FORMAT_ERROR_TO_RAISE", INT2NUM(PG_CODER_FORMAT_ERROR_TO_RAISE));
 	rb_define_const( rb_cPG_Coder, "FORMAT_ERROR_TO_STRING", INT2NUM(PG_CODER_FORMAT_ERROR_TO_STRING));
 	rb_define_const( rb_cPG_Coder, "FORMAT_ERROR_TO_PARTIAL", INT2NUM(PG_CODER_FORMAT_ERROR_TO_PARTIAL));
+	rb_define_const( rb_cPG_Coder, "JSON_SYMBOLIZE_NAMES", INT2NUM(PG_CODER_JSON_SYMBOLIZE_NAMES));
+	rb_define_const( rb_cPG_Coder, "JSON_DEEP_FREEZE", INT2NUM(PG_CODER_JSON_DEEP_FREEZE));
+	rb_define_const( rb_cPG_Coder, "JSON_BIGDECIMAL", INT2NUM(PG_CODER_JSON_BIGDECIMAL));
+	rb_define_const( rb_cPG_Coder, "TIMESTAMP_CACHE", INT2NUM(PG_CODER_TIMESTAMP_CACHE));
+	rb_define_const( rb_cPG_Coder, "NUMERIC_TO_INTEGER", INT2NUM(PG_CODER_NUMERIC_TO_INTEGER));
+	rb_define_const( rb_cPG_Coder, "NUMERIC_TO_FLOAT", INT2NUM(PG_CODER_NUMERIC_TO_FLOAT));
+	rb_define_const( rb_cPG_Coder, "UUID_BINARY", INT2NUM(PG_CODER_UUID_BINARY));
+	rb_define_const( rb_cPG_Coder, "UUID_INTERN", INT2NUM(PG_CODER_UUID_INTERN));
+	rb_define_const( rb_cPG_Coder, "INTERVAL_TO_SECONDS", INT2NUM(PG_CODER_INTERVAL_TO_SECONDS));
 
 	/*
 	 * Name of the coder or the corresponding data type.
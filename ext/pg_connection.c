@@ -13,6 +13,10 @@
 VALUE rb_cPGconn;
 static ID s_id_encode;
 static ID s_id_autoclose_set;
+static ID s_id_timeout;
+static ID s_id_async_cancel;
+static ID s_id_reset;
+static ID s_id_call;
 static VALUE sym_type, sym_format, sym_value;
 static VALUE sym_symbol, sym_string;
 
@@ -23,6 +27,19 @@ static void pgconn_set_internal_encoding_index( VALUE );
 static const rb_data_type_t pg_connection_type;
 static VALUE pgconn_async_flush(VALUE self);
 
+/* COPY progress counters, see PG::Connection#copy_stats */
+struct pg_copy_stats {
+	uint64_t rows;
+	uint64_t bytes;
+	uint64_t encode_ns;
+	uint64_t decode_ns;
+	uint64_t wait_ns;
+	uint64_t start_ns;
+	/* Call the progress proc every progress_rows rows, 0 = never */
+	uint64_t progress_rows;
+	uint64_t next_progress;
+};
+
 /*
  * Global functions
  */
@@ -179,6 +196,7 @@ pgconn_gc_mark( void *_this )
 	rb_gc_mark_movable( this->trace_stream );
 	rb_gc_mark_movable( this->encoder_for_put_copy_data );
 	rb_gc_mark_movable( this->decoder_for_get_copy_data );
+	rb_gc_mark_movable( this->copy_progress );
 }
 
 static void
@@ -194,6 +212,7 @@ pgconn_gc_compact( void *_this )
 	pg_gc_location( this->trace_stream );
 	pg_gc_location( this->encoder_for_put_copy_data );
 	pg_gc_location( this->decoder_for_get_copy_data );
+	pg_gc_location( this->copy_progress );
 }
 
 
@@ -214,6 +233,7 @@ pgconn_gc_free( void *_this )
 	if (this->pgconn != NULL)
 		PQfinish( this->pgconn );
 
+	xfree(this->copy_stats);
 	xfree(this);
 }
 
@@ -224,7 +244,7 @@ static size_t
 pgconn_memsize( const void *_this )
 {
 	const t_pg_connection *this = (const t_pg_connection *)_this;
-	return sizeof(*this);
+	return sizeof(*this) + (this->copy_stats ? sizeof(*this->copy_stats) : 0);
 }
 
 static const rb_data_type_t pg_connection_type = {
@@ -267,6 +287,7 @@ pgconn_s_allocate( VALUE klass )
 	RB_OBJ_WRITE(self, &this->encoder_for_put_copy_data, Qnil);
 	RB_OBJ_WRITE(self, &this->decoder_for_get_copy_data, Qnil);
 	RB_OBJ_WRITE(self, &this->trace_stream, Qnil);
+	RB_OBJ_WRITE(self, &this->copy_progress, Qnil);
 	rb_ivar_set(self, rb_intern("@calls_to_put_copy_data"), INT2FIX(0));
 	rb_ivar_set(self, rb_intern("@iopts_for_reset"), Qnil);
 
@@ -2649,6 +2670,181 @@ wait_socket_readable( VALUE self, struct timeval *ptimeout, void *(*is_readable)
 	return retval;
 }
 
+/*
+ * Return the monotonic clock in nanoseconds, if COPY progress counters are enabled.
+ */
+static uint64_t
+pgconn_copy_stats_clock( t_pg_connection *this )
+{
+	struct timespec ts;
+
+	if( !this->copy_stats ) return 0;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* Account the time since +t0+ as waiting for the server. */
+static void
+pgconn_copy_stats_wait( t_pg_connection *this, uint64_t t0 )
+{
+	if( this->copy_stats ) this->copy_stats->wait_ns += pgconn_copy_stats_clock(this) - t0;
+}
+
+/* Account +rows+ rows with +bytes+ bytes of COPY data and the coder time since +t0+. */
+static void
+pgconn_copy_stats_add( t_pg_connection *this, long rows, long bytes, uint64_t *coder_ns, uint64_t t0 )
+{
+	struct pg_copy_stats *stats = this->copy_stats;
+	if( !stats ) return;
+	stats->rows += rows;
+	stats->bytes += bytes;
+	if( coder_ns ) *coder_ns += pgconn_copy_stats_clock(this) - t0;
+}
+
+/*
+ * call-seq:
+ *    conn.copy_stats -> Hash or nil
+ *
+ * Returns the COPY progress counters or +nil+ if they are not enabled by #enable_copy_stats .
+ *
+ * The Hash has the following keys:
+ * * +:rows+ : Number of rows sent by #put_copy_data and PG::CopyWriter or received by #get_copy_data, #get_copy_rows and #copy_to_io
+ * * +:bytes+ : Number of bytes of COPY data sent or received
+ * * +:encode_ns+ : Nanoseconds spent in the encoder (typically PG::TextEncoder::CopyRow or PG::BinaryEncoder::CopyRow)
+ * * +:decode_ns+ : Nanoseconds spent in the decoder
+ * * +:wait_ns+ : Nanoseconds spent in libpq's send and receive functions and waiting for the socket.
+ *   A large fraction of +wait_ns+ indicates backpressure of the server or network.
+ * * +:elapsed_ns+ : Nanoseconds since the counters were reset
+ *
+ * The counters can be read while the COPY is running.
+ * They are reset by #copy_data at the start of each COPY command.
+ */
+static VALUE
+pgconn_copy_stats(VALUE self)
+{
+	t_pg_connection *this = pg_get_connection( self );
+	struct pg_copy_stats *stats = this->copy_stats;
+	VALUE hash;
+
+	if( !stats ) return Qnil;
+	hash = rb_hash_new();
+	rb_hash_aset( hash, ID2SYM(rb_intern("rows")), ULL2NUM(stats->rows) );
+	rb_hash_aset( hash, ID2SYM(rb_intern("bytes")), ULL2NUM(stats->bytes) );
+	rb_hash_aset( hash, ID2SYM(rb_intern("encode_ns")), ULL2NUM(stats->encode_ns) );
+	rb_hash_aset( hash, ID2SYM(rb_intern("decode_ns")), ULL2NUM(stats->decode_ns) );
+	rb_hash_aset( hash, ID2SYM(rb_intern("wait_ns")), ULL2NUM(stats->wait_ns) );
+	rb_hash_aset( hash, ID2SYM(rb_intern("elapsed_ns")), ULL2NUM(pgconn_copy_stats_clock(this) - stats->start_ns) );
+	return hash;
+}
+
+/*
+ * Call the progress proc, if the number of rows passed the next multiple of progress_rows.
+ */
+static void
+pgconn_copy_stats_progress( VALUE self, t_pg_connection *this )
+{
+	struct pg_copy_stats *stats = this->copy_stats;
+
+	if( stats && stats->progress_rows && stats->rows >= stats->next_progress && !NIL_P(this->copy_progress) ){
+		stats->next_progress = (stats->rows / stats->progress_rows + 1) * stats->progress_rows;
+		rb_funcall( this->copy_progress, s_id_call, 1, pgconn_copy_stats(self) );
+	}
+}
+
+/*
+ * call-seq:
+ *    conn.reset_copy_stats -> nil
+ *
+ * Reset all COPY progress counters to zero.
+ * It does nothing if the counters are not enabled.
+ */
+static VALUE
+pgconn_reset_copy_stats(VALUE self)
+{
+	t_pg_connection *this = pg_get_connection( self );
+	struct pg_copy_stats *stats = this->copy_stats;
+
+	if( stats ){
+		uint64_t progress_rows = stats->progress_rows;
+		memset( stats, 0, sizeof(*stats) );
+		stats->progress_rows = progress_rows;
+		stats->next_progress = progress_rows;
+		stats->start_ns = pgconn_copy_stats_clock(this);
+	}
+	return Qnil;
+}
+
+/*
+ * call-seq:
+ *    conn.enable_copy_stats( progress_rows = nil ) -> nil
+ *    conn.enable_copy_stats( progress_rows ) { |stats| ... } -> nil
+ *
+ * Enable the COPY progress counters of this connection and reset them to zero.
+ * See #copy_stats for the available counters.
+ *
+ * If a block is given, it is called with the Hash of #copy_stats each time another +progress_rows+ rows are sent or received.
+ * The block is called from within the COPY methods, so that it should return quickly.
+ *
+ * Example:
+ *   conn.enable_copy_stats(100_000) do |stats|
+ *     puts "%d rows, %.0f rows/s, %.0f%% waiting" % [stats[:rows], stats[:rows] * 1e9 / stats[:elapsed_ns], stats[:wait_ns] * 100.0 / stats[:elapsed_ns]]
+ *   end
+ *
+ * The counters are disabled by default, since they cost two clock reads per call to the COPY methods.
+ */
+static VALUE
+pgconn_enable_copy_stats(int argc, VALUE *argv, VALUE self)
+{
+	t_pg_connection *this = pg_get_connection( self );
+	VALUE progress_rows;
+	VALUE proc;
+
+	rb_check_frozen(self);
+	rb_scan_args(argc, argv, "01&", &progress_rows, &proc);
+
+	if( !this->copy_stats ){
+		this->copy_stats = ALLOC( struct pg_copy_stats );
+		memset( this->copy_stats, 0, sizeof(*this->copy_stats) );
+	}
+	this->copy_stats->progress_rows = NIL_P(progress_rows) ? 0 : NUM2ULL(progress_rows);
+	RB_OBJ_WRITE(self, &this->copy_progress, proc);
+	pgconn_reset_copy_stats(self);
+	return Qnil;
+}
+
+/*
+ * call-seq:
+ *    conn.disable_copy_stats -> nil
+ *
+ * Disable the COPY progress counters and remove the progress block.
+ */
+static VALUE
+pgconn_disable_copy_stats(VALUE self)
+{
+	t_pg_connection *this = pg_get_connection( self );
+
+	rb_check_frozen(self);
+	xfree( this->copy_stats );
+	this->copy_stats = NULL;
+	RB_OBJ_WRITE(self, &this->copy_progress, Qnil);
+	return Qnil;
+}
+
+/*
+ * call-seq:
+ *    conn.add_copy_wait_ns( ns ) -> nil
+ *
+ * Account time spent in Ruby for waiting on COPY data to #copy_stats .
+ */
+static VALUE
+pgconn_add_copy_wait_ns(VALUE self, VALUE ns)
+{
+	t_pg_connection *this = pg_get_connection( self );
+
+	if( this->copy_stats ) this->copy_stats->wait_ns += NUM2ULL(ns);
+	return Qnil;
+}
+
 /*
  * call-seq:
  *    conn.flush() -> Boolean
@@ -2666,7 +2862,9 @@ pgconn_async_flush(VALUE self)
 		/* wait for the socket to become read- or write-ready */
 		int events;
 		VALUE socket_io = pgconn_socket_io(self);
+		uint64_t t0 = pgconn_copy_stats_clock( pg_get_connection(self) );
 		events = RB_NUM2INT(pg_rb_io_wait(socket_io, RB_INT2NUM(PG_RUBY_IO_READABLE | PG_RUBY_IO_WRITABLE), Qnil));
+		pgconn_copy_stats_wait( pg_get_connection(self), t0 );
 
 		if (events & PG_RUBY_IO_READABLE){
 			pgconn_consume_input(self);
@@ -2760,6 +2958,7 @@ pgconn_sync_put_copy_data(int argc, VALUE *argv, VALUE self)
 	VALUE encoder;
 	VALUE intermediate = Qnil;
 	t_pg_coder *p_coder = NULL;
+	uint64_t t0;
 
 	rb_scan_args( argc, argv, "11", &value, &encoder );
 
@@ -2774,6 +2973,7 @@ pgconn_sync_put_copy_data(int argc, VALUE *argv, VALUE self)
 		TypedData_Get_Struct(encoder, t_pg_coder, &pg_coder_type, p_coder);
 	}
 
+	t0 = pgconn_copy_stats_clock(this);
 	if( p_coder ){
 		t_pg_coder_enc_func enc_func;
 		int enc_idx = this->enc_idx;
@@ -2792,16 +2992,165 @@ pgconn_sync_put_copy_data(int argc, VALUE *argv, VALUE self)
 	}
 
 	Check_Type(buffer, T_STRING);
+	if( this->copy_stats ){
+		pgconn_copy_stats_add( this, 1, RSTRING_LEN(buffer), p_coder ? &this->copy_stats->encode_ns : NULL, t0 );
+		t0 = pgconn_copy_stats_clock(this);
+	}
 
 	ret = gvl_PQputCopyData(this->pgconn, RSTRING_PTR(buffer), RSTRING_LENINT(buffer));
+	pgconn_copy_stats_wait( this, t0 );
 	if(ret == -1)
 		pg_raise_conn_error( rb_ePGerror, self, "%s", PQerrorMessage(this->pgconn));
 
 	RB_GC_GUARD(buffer);
+	pgconn_copy_stats_progress( self, this );
 
 	return (ret) ? Qtrue : Qfalse;
 }
 
+/*
+ * Send the content of +buffer+ per one PQputCopyData call and truncate it afterwards.
+ */
+static void
+pgconn_flush_copy_buffer(VALUE self, VALUE buffer)
+{
+	t_pg_connection *this = pg_get_connection_safe( self );
+	int ret;
+
+	uint64_t t0;
+
+	if( RSTRING_LEN(buffer) == 0 ) return;
+	pgconn_copy_stats_add( this, 0, RSTRING_LEN(buffer), NULL, 0 );
+
+	/* PQputCopyData returns 0 in nonblocking mode, if the data couldn't be queued */
+	t0 = pgconn_copy_stats_clock(this);
+	while( (ret = gvl_PQputCopyData(this->pgconn, RSTRING_PTR(buffer), RSTRING_LENINT(buffer))) == 0 ){
+		pgconn_async_flush(self);
+	}
+	pgconn_copy_stats_wait( this, t0 );
+	if(ret == -1)
+		pg_raise_conn_error( rb_ePGerror, self, "%s", PQerrorMessage(this->pgconn));
+
+	/* Send the data before the next buffer is filled, to avoid memory bloat in libpq */
+	pgconn_async_flush(self);
+	rb_str_set_len( buffer, 0 );
+}
+
+/*
+ * Append one COPY row encoded by +p_coder+ to +buffer+.
+ * CopyRow encoders write directly into +buffer+, other encoders through their intermediate String.
+ * Already encoded rows are appended as is, if no coder is given.
+ */
+static void
+pgconn_encode_copy_row(t_pg_coder *p_coder, VALUE row, VALUE buffer, int enc_idx)
+{
+	if( p_coder ){
+		t_pg_coder_enc_func enc_func;
+		VALUE intermediate = Qnil;
+		int len;
+
+		if( pg_copycoder_enc_append( p_coder, row, buffer, enc_idx ) )
+			return;
+
+		enc_func = pg_coder_enc_func( p_coder );
+		len = enc_func( p_coder, row, NULL, &intermediate, enc_idx );
+		if( len == -1 ){
+			/* The intermediate value is a String that can be used directly. */
+			rb_str_cat( buffer, RSTRING_PTR(intermediate), RSTRING_LEN(intermediate) );
+		} else {
+			char *current_out = RSTRING_PTR(buffer) + RSTRING_LEN(buffer);
+			current_out = pg_rb_str_ensure_capa( buffer, len, current_out, NULL );
+			len = enc_func( p_coder, row, current_out, &intermediate, enc_idx );
+			rb_str_set_len( buffer, current_out + len - RSTRING_PTR(buffer) );
+		}
+		RB_GC_GUARD(intermediate);
+	} else {
+		StringValue(row);
+		rb_str_cat( buffer, RSTRING_PTR(row), RSTRING_LEN(row) );
+	}
+}
+
+struct copy_rows_buffered_args {
+	VALUE self;
+	t_pg_connection *this;
+	t_pg_coder *p_coder;
+	VALUE rows;
+	VALUE buffer;
+	long buffer_size;
+	/* Length of the buffer before the row in progress */
+	long row_start;
+};
+
+static VALUE
+pgconn_put_copy_rows_buffered_body(VALUE p_args)
+{
+	struct copy_rows_buffered_args *args = (struct copy_rows_buffered_args *)p_args;
+	t_pg_connection *this = args->this;
+	long i;
+
+	for( i=0; i<RARRAY_LEN(args->rows); i++ ){
+		uint64_t t0 = pgconn_copy_stats_clock(this);
+		args->row_start = RSTRING_LEN(args->buffer);
+		pgconn_encode_copy_row( args->p_coder, rb_ary_entry(args->rows, i), args->buffer, this->enc_idx );
+		if( this->copy_stats ){
+			/* bytes are counted when the buffer is sent */
+			pgconn_copy_stats_add( this, 1, 0, args->p_coder ? &this->copy_stats->encode_ns : NULL, t0 );
+		}
+
+		if( RSTRING_LEN(args->buffer) >= args->buffer_size ){
+			args->row_start = RSTRING_LEN(args->buffer);
+			pgconn_flush_copy_buffer( args->self, args->buffer );
+		}
+	}
+	return Qnil;
+}
+
+/*
+ * call-seq:
+ *    conn.put_copy_rows_buffered( rows, encoder, buffer, buffer_size, flush ) -> nil
+ *
+ * Encode all +rows+ by +encoder+ into +buffer+ and send the buffer content per one PQputCopyData call each time it exceeds +buffer_size+ bytes.
+ *
+ * This is the backend of PG::CopyWriter . The buffer String is reused, so that it keeps its capacity over all calls.
+ * If +flush+ is +true+ the remaining buffer content is sent as well.
+ * If a row fails to encode, its partially written data is removed from the buffer.
+ */
+static VALUE
+pgconn_put_copy_rows_buffered(VALUE self, VALUE rows, VALUE encoder, VALUE buffer, VALUE buffer_size_in, VALUE flush)
+{
+	t_pg_connection *this = pg_get_connection_safe( self );
+	struct copy_rows_buffered_args args;
+	int state;
+
+	Check_Type(rows, T_ARRAY);
+	Check_Type(buffer, T_STRING);
+	rb_str_modify(buffer);
+
+	args.self = self;
+	args.this = this;
+	args.p_coder = NULL;
+	args.rows = rows;
+	args.buffer = buffer;
+	args.buffer_size = NUM2LONG(buffer_size_in);
+	args.row_start = RSTRING_LEN(buffer);
+	if( !NIL_P(encoder) ){
+		TypedData_Get_Struct(encoder, t_pg_coder, &pg_coder_type, args.p_coder);
+	}
+
+	rb_protect( pgconn_put_copy_rows_buffered_body, (VALUE)&args, &state );
+	if( state ){
+		rb_str_set_len( buffer, args.row_start );
+		rb_jump_tag( state );
+	}
+
+	if( RTEST(flush) ){
+		pgconn_flush_copy_buffer( self, buffer );
+	}
+	pgconn_copy_stats_progress( self, this );
+
+	return Qnil;
+}
+
 static VALUE
 pgconn_sync_put_copy_end(int argc, VALUE *argv, VALUE self)
 {
@@ -2834,6 +3183,7 @@ pgconn_sync_get_copy_data(int argc, VALUE *argv, VALUE self )
 	VALUE decoder;
 	t_pg_coder *p_coder = NULL;
 	t_pg_connection *this = pg_get_connection_safe( self );
+	uint64_t t0;
 
 	rb_scan_args(argc, argv, "02", &async_in, &decoder);
 
@@ -2846,7 +3196,9 @@ pgconn_sync_get_copy_data(int argc, VALUE *argv, VALUE self )
 		TypedData_Get_Struct(decoder, t_pg_coder, &pg_coder_type, p_coder);
 	}
 
+	t0 = pgconn_copy_stats_clock(this);
 	ret = gvl_PQgetCopyData(this->pgconn, &buffer, RTEST(async_in));
+	pgconn_copy_stats_wait( this, t0 );
 	if(ret == -2){ /* error */
 		pg_raise_conn_error( rb_ePGerror, self, "%s", PQerrorMessage(this->pgconn));
 	}
@@ -2857,6 +3209,7 @@ pgconn_sync_get_copy_data(int argc, VALUE *argv, VALUE self )
 		return Qfalse;
 	}
 
+	t0 = pgconn_copy_stats_clock(this);
 	if( p_coder ){
 		t_pg_coder_dec_func dec_func = pg_coder_dec_func( p_coder, p_coder->format );
 		result =  dec_func( p_coder, buffer, ret, 0, 0, this->enc_idx );
@@ -2865,9 +3218,159 @@ pgconn_sync_get_copy_data(int argc, VALUE *argv, VALUE self )
 	}
 
 	PQfreemem(buffer);
+	if( this->copy_stats ){
+		pgconn_copy_stats_add( this, 1, ret, p_coder ? &this->copy_stats->decode_ns : NULL, t0 );
+		pgconn_copy_stats_progress( self, this );
+	}
 	return result;
 }
 
+/*
+ * call-seq:
+ *    conn.sync_get_copy_rows( max_rows = nil [, decoder = nil ] ) -> Array, false or nil
+ *
+ * Retrieve all rows of COPY data, which are already received from the server, in one call.
+ *
+ * At most _max_rows_ rows are returned per call if _max_rows_ is given.
+ * The rows are decoded by _decoder_ or by #decoder_for_get_copy_data like in #get_copy_data .
+ * If no decoder is set, each row is returned as binary String.
+ *
+ * Returns an Array of one or more rows, +false+ if no row is available without blocking and +nil+ if the COPY is done.
+ * Since libpq reports the end of the data only once, the end is remembered, when it was reached together with some rows.
+ * It is then reported by the next call.
+ *
+ * See also #get_copy_rows and #copy_each_batch .
+ */
+static VALUE
+pgconn_sync_get_copy_rows(int argc, VALUE *argv, VALUE self )
+{
+	VALUE max_rows_in;
+	VALUE decoder;
+	VALUE rows;
+	long max_rows;
+	t_pg_coder *p_coder = NULL;
+	t_pg_coder_dec_func dec_func = NULL;
+	t_pg_connection *this = pg_get_connection_safe( self );
+
+	rb_scan_args(argc, argv, "02", &max_rows_in, &decoder);
+
+	max_rows = NIL_P(max_rows_in) ? LONG_MAX : NUM2LONG(max_rows_in);
+	if( max_rows <= 0 )
+		rb_raise( rb_eArgError, "max_rows must be positive" );
+
+	if( NIL_P(decoder) ){
+		if( !NIL_P(this->decoder_for_get_copy_data) ){
+			p_coder = RTYPEDDATA_DATA( this->decoder_for_get_copy_data );
+		}
+	} else {
+		/* Check argument type and use argument decoder */
+		TypedData_Get_Struct(decoder, t_pg_coder, &pg_coder_type, p_coder);
+	}
+	if( p_coder ){
+		dec_func = pg_coder_dec_func( p_coder, p_coder->format );
+	}
+
+	if( this->copy_out_done ){
+		this->copy_out_done = 0;
+		return Qnil;
+	}
+
+	rows = rb_ary_new();
+	while( RARRAY_LEN(rows) < max_rows ){
+		char *buffer;
+		VALUE row;
+		int ret = gvl_PQgetCopyData(this->pgconn, &buffer, 1);
+		uint64_t t0 = pgconn_copy_stats_clock(this);
+
+		if(ret == -2){ /* error */
+			pg_raise_conn_error( rb_ePGerror, self, "%s", PQerrorMessage(this->pgconn));
+		}
+		if(ret == -1) { /* No data left */
+			if( RARRAY_LEN(rows) == 0 ) return Qnil;
+			this->copy_out_done = 1;
+			break;
+		}
+		if(ret == 0) { /* would block */
+			if( RARRAY_LEN(rows) == 0 ) return Qfalse;
+			break;
+		}
+
+		if( dec_func ){
+			row = dec_func( p_coder, buffer, ret, 0, 0, this->enc_idx );
+			PQfreemem(buffer);
+			if( NIL_P(row) ){
+				/* End marker of the decoder (the trailer of binary COPY data).
+				 * The final end of data is left to #get_copy_data like in #copy_data. */
+				if( RARRAY_LEN(rows) == 0 ) return Qnil;
+				this->copy_out_done = 1;
+				break;
+			}
+		} else {
+			row = rb_str_new(buffer, ret);
+			PQfreemem(buffer);
+		}
+		if( this->copy_stats ){
+			pgconn_copy_stats_add( this, 1, ret, dec_func ? &this->copy_stats->decode_ns : NULL, t0 );
+		}
+		rb_ary_push(rows, row);
+	}
+
+	pgconn_copy_stats_progress( self, this );
+	return rows;
+}
+
+/*
+ * call-seq:
+ *    conn.get_copy_chunk( buffer, max_bytes ) -> true, false or nil
+ *
+ * Store all COPY data, which is already received from the server, in +buffer+ without decoding.
+ *
+ * The previous content of +buffer+ is discarded, but its capacity is kept.
+ * Rows are appended until +buffer+ exceeds +max_bytes+ or no more data is available without blocking.
+ * This is the backend of #copy_to_io . The buffer String is reused, so that no String is allocated per row.
+ *
+ * Returns +true+ if some data was appended, +false+ if no data is available without blocking and +nil+ if the COPY is done.
+ */
+static VALUE
+pgconn_get_copy_chunk(VALUE self, VALUE buffer, VALUE max_bytes_in)
+{
+	t_pg_connection *this = pg_get_connection_safe( self );
+	long max_bytes = NUM2LONG(max_bytes_in);
+
+	Check_Type(buffer, T_STRING);
+	rb_str_modify(buffer);
+	rb_str_set_len(buffer, 0);
+
+	if( this->copy_out_done ){
+		this->copy_out_done = 0;
+		return Qnil;
+	}
+
+	while( RSTRING_LEN(buffer) < max_bytes ){
+		char *data;
+		int ret = gvl_PQgetCopyData(this->pgconn, &data, 1);
+
+		if(ret == -2){ /* error */
+			pg_raise_conn_error( rb_ePGerror, self, "%s", PQerrorMessage(this->pgconn));
+		}
+		if(ret == -1) { /* No data left */
+			if( RSTRING_LEN(buffer) == 0 ) return Qnil;
+			this->copy_out_done = 1;
+			break;
+		}
+		if(ret == 0) { /* would block */
+			break;
+		}
+
+		rb_str_cat(buffer, data, ret);
+		PQfreemem(data);
+		pgconn_copy_stats_add( this, 1, ret, NULL, 0 );
+	}
+	pgconn_copy_stats_progress( self, this );
+
+	return RSTRING_LEN(buffer) == 0 ? Qfalse : Qtrue;
+}
+
 /*
  * call-seq:
  *    conn.set_error_verbosity( verbosity ) -> Integer
@@ -3273,6 +3776,7 @@ pgconn_sync_get_last_result(VALUE self)
 	VALUE rb_pgresult = Qnil;
 	PGresult *cur, *prev;
 
+	pg_get_connection(self)->copy_out_done = 0;
 
 	cur = prev = NULL;
 	while ((cur = gvl_PQgetResult(conn)) != NULL) {
@@ -3294,38 +3798,169 @@ pgconn_sync_get_last_result(VALUE self)
 	return rb_pgresult;
 }
 
+static VALUE pgconn_discard_results(VALUE self);
+
+static VALUE
+pgconn_call_async_cancel(VALUE self)
+{
+	return rb_funcall(self, s_id_async_cancel, 0);
+}
+
 /*
- * call-seq:
- *    conn.get_last_result( ) -> PG::Result
+ * Discard the results of the canceled query, but wait at most +ptimeout+ for them.
  *
- * This function retrieves all available results
- * on the current connection (from previously issued
- * asynchronous commands like +send_query()+) and
- * returns the last non-NULL result, or +nil+ if no
- * results are available.
+ * Returns 0 if the server didn't finish the query in time.
+ */
+static int
+pgconn_discard_canceled_results(VALUE self, struct timeval *ptimeout)
+{
+	PGconn *conn = pg_get_pgconn(self);
+	struct timeval aborttime, currtime, waittime;
+
+	gettimeofday(&currtime, NULL);
+	timeradd(&currtime, ptimeout, &aborttime);
+
+	for(;;) {
+		PGresult *cur;
+		int status;
+
+		gettimeofday(&currtime, NULL);
+		timersub(&aborttime, &currtime, &waittime);
+		if ( !wait_socket_readable(self, &waittime, get_result_readable) )
+			return 0;
+
+		cur = gvl_PQgetResult(conn);
+		if (cur == NULL)
+			return 1;
+
+		status = PQresultStatus(cur);
+		PQclear(cur);
+		if (status == PGRES_COPY_OUT || status == PGRES_COPY_IN || status == PGRES_COPY_BOTH) {
+			/* COPY data is discarded until the server reports the cancellation. */
+			pgconn_discard_results(self);
+			return 1;
+		}
+	}
+}
+
+/*
+ * Cancel the running query after the +timeout+ of #exec and siblings expired.
  *
- * If the last result contains a bad result_status, an
- * appropriate exception is raised.
+ * The cancel request is sent per #async_cancel, which uses nonblocking IO, so that no thread is required.
+ * All pending results are then discarded and PG::QueryTimeout is raised.
  *
- * This function is similar to #get_result
- * except that it is designed to get one and only
- * one result and that it checks the result state.
+ * The server gets the same +timeout+ (but at least one second) to process the cancel request.
+ * If the cancel request fails or the server doesn't respond in time, the connection is reset per #reset .
+ * A failed cancel request is either raised or returned as error String by #async_cancel .
+ */
+static void
+pgconn_query_timeout(VALUE self, struct timeval *ptimeout)
+{
+	int state;
+	VALUE error;
+	struct timeval grace = *ptimeout;
+
+	if ( grace.tv_sec < 1 ) {
+		grace.tv_sec = 1;
+		grace.tv_usec = 0;
+	}
+
+	error = rb_protect(pgconn_call_async_cancel, self, &state);
+	if ( state ) {
+		rb_set_errinfo(Qnil);
+	}
+	if ( state || !NIL_P(error) || !pgconn_discard_canceled_results(self, &grace) ) {
+		rb_funcall(self, s_id_reset, 0);
+	}
+
+	pg_raise_conn_error( rb_eQueryTimeout, self, "query timeout of %.3f seconds expired",
+			(double)ptimeout->tv_sec + (double)ptimeout->tv_usec / 1000000.0);
+}
+
+/*
+ * call-seq:
+ *    conn.query_timeout( timeout )
+ *
+ * Cancel the running query after +timeout+ expired and raise PG::QueryTimeout .
+ * This is used by #get_result .
  */
 static VALUE
-pgconn_async_get_last_result(VALUE self)
+pgconn_query_timeout_m(VALUE self, VALUE timeout_in)
+{
+	struct timeval timeout;
+	double timeout_sec = NUM2DBL(timeout_in);
+
+	timeout.tv_sec = (time_t)timeout_sec;
+	timeout.tv_usec = (suseconds_t)((timeout_sec - (long)timeout_sec) * 1e6);
+	pgconn_query_timeout(self, &timeout);
+	return Qnil;
+}
+
+/*
+ * Extract the +timeout+ keyword argument of #exec and siblings.
+ *
+ * Returns the number of the remaining positional arguments.
+ * +ptimeout+ is set to NULL if no timeout is given.
+ */
+static int
+pgconn_scan_timeout(int argc, VALUE *argv, struct timeval *timeout, struct timeval **ptimeout)
+{
+	*ptimeout = NULL;
+
+	if( argc > 0 && rb_keyword_given_p() ){
+		VALUE timeout_in;
+		double timeout_sec;
+
+		rb_get_kwargs(argv[argc - 1], &s_id_timeout, 0, 1, &timeout_in);
+		argc--;
+
+		if( timeout_in != Qundef && !NIL_P(timeout_in) ){
+			timeout_sec = NUM2DBL( timeout_in );
+			if( timeout_sec < 0 )
+				rb_raise( rb_eArgError, "timeout must not be negative" );
+			timeout->tv_sec = (time_t)timeout_sec;
+			timeout->tv_usec = (suseconds_t)((timeout_sec - (long)timeout_sec) * 1e6);
+			*ptimeout = timeout;
+		}
+	}
+	return argc;
+}
+
+static VALUE
+pgconn_async_get_last_result_timeout(VALUE self, struct timeval *ptimeout)
 {
 	PGconn *conn = pg_get_pgconn(self);
 	VALUE rb_pgresult = Qnil;
 	PGresult *cur, *prev;
+	struct timeval aborttime={0,0}, currtime, waittime={0,0};
+
+	pg_get_connection(self)->copy_out_done = 0;
+
+	if ( ptimeout ) {
+		gettimeofday(&currtime, NULL);
+		timeradd(&currtime, ptimeout, &aborttime);
+	}
 
 	cur = prev = NULL;
 	for(;;) {
 		int status;
 
+		if ( ptimeout ) {
+			gettimeofday(&currtime, NULL);
+			timersub(&aborttime, &currtime, &waittime);
+			if ( waittime.tv_sec < 0 ) {
+				waittime.tv_sec = 0;
+				waittime.tv_usec = 0;
+			}
+		}
+
 		/* Wait for input before reading each result.
 		 * That way we support the ruby-3.x IO scheduler and don't block other ruby threads.
 		 */
-		wait_socket_readable(self, NULL, get_result_readable);
+		if ( !wait_socket_readable(self, ptimeout ? &waittime : NULL, get_result_readable) ) {
+			if (prev) PQclear(prev);
+			pgconn_query_timeout(self, ptimeout);
+		}
 
 		cur = gvl_PQgetResult(conn);
 		if (cur == NULL)
@@ -3347,6 +3982,29 @@ pgconn_async_get_last_result(VALUE self)
 	return rb_pgresult;
 }
 
+/*
+ * call-seq:
+ *    conn.get_last_result( ) -> PG::Result
+ *
+ * This function retrieves all available results
+ * on the current connection (from previously issued
+ * asynchronous commands like +send_query()+) and
+ * returns the last non-NULL result, or +nil+ if no
+ * results are available.
+ *
+ * If the last result contains a bad result_status, an
+ * appropriate exception is raised.
+ *
+ * This function is similar to #get_result
+ * except that it is designed to get one and only
+ * one result and that it checks the result state.
+ */
+static VALUE
+pgconn_async_get_last_result(VALUE self)
+{
+	return pgconn_async_get_last_result_timeout(self, NULL);
+}
+
 /*
  * call-seq:
  *    conn.discard_results()
@@ -3367,6 +4025,8 @@ pgconn_discard_results(VALUE self)
 	PGconn *conn = pg_get_pgconn(self);
 	VALUE socket_io;
 
+	pg_get_connection(self)->copy_out_done = 0;
+
 	switch( PQtransactionStatus(conn) ) {
 		case PQTRANS_IDLE:
 		case PQTRANS_INTRANS:
@@ -3441,8 +4101,8 @@ error:
 
 /*
  * call-seq:
- *    conn.exec(sql) -> PG::Result
- *    conn.exec(sql) {|pg_result| block }
+ *    conn.exec(sql [, timeout: nil ] ) -> PG::Result
+ *    conn.exec(sql [, timeout: nil ] ) {|pg_result| block }
  *
  * Sends SQL query request specified by _sql_ to PostgreSQL.
  * On success, it returns a PG::Result instance with all result rows and columns.
@@ -3465,16 +4125,23 @@ error:
  * This is most notably visible by a delayed reaction to Control+C.
  * It's not recommended to use explicit sync or async variants but #exec instead, unless you have a good reason to do so.
  *
+ * The optional +timeout+ is the maximum time in seconds (can be fractional) to wait for the query result.
+ * If it expires, the query is canceled per #cancel, all pending results are discarded and PG::QueryTimeout is raised.
+ * This avoids setting +statement_timeout+ per additional round trip to the server.
+ * The +timeout+ option is only supported by the async API (the default) but not by #sync_exec and siblings.
+ *
  * See also corresponding {libpq function}[https://www.postgresql.org/docs/current/libpq-exec.html#LIBPQ-PQEXEC].
  */
 static VALUE
 pgconn_async_exec(int argc, VALUE *argv, VALUE self)
 {
 	VALUE rb_pgresult = Qnil;
+	struct timeval timeout, *ptimeout;
 
+	argc = pgconn_scan_timeout( argc, argv, &timeout, &ptimeout );
 	pgconn_discard_results( self );
 	pgconn_send_query( argc, argv, self );
-	rb_pgresult = pgconn_async_get_last_result( self );
+	rb_pgresult = pgconn_async_get_last_result_timeout( self, ptimeout );
 
 	if ( rb_block_given_p() ) {
 		return rb_ensure( rb_yield, rb_pgresult, pg_result_clear, rb_pgresult );
@@ -3485,8 +4152,8 @@ pgconn_async_exec(int argc, VALUE *argv, VALUE self)
 
 /*
  * call-seq:
- *    conn.exec_params(sql, params [, result_format [, type_map ]] ) -> nil
- *    conn.exec_params(sql, params [, result_format [, type_map ]] ) {|pg_result| block }
+ *    conn.exec_params(sql, params [, result_format [, type_map ]] [, timeout: nil ] ) -> nil
+ *    conn.exec_params(sql, params [, result_format [, type_map ]] [, timeout: nil ] ) {|pg_result| block }
  *
  * Sends SQL query request specified by +sql+ to PostgreSQL using placeholders
  * for parameters.
@@ -3532,13 +4199,17 @@ pgconn_async_exec(int argc, VALUE *argv, VALUE self)
  * (There can be semicolons in it, but not more than one nonempty command.)
  * This is a limitation of the underlying protocol, but has some usefulness as an extra defense against SQL-injection attacks.
  *
+ * See #exec for the optional +timeout+ .
+ *
  * See also corresponding {libpq function}[https://www.postgresql.org/docs/current/libpq-exec.html#LIBPQ-PQEXECPARAMS].
  */
 static VALUE
 pgconn_async_exec_params(int argc, VALUE *argv, VALUE self)
 {
 	VALUE rb_pgresult = Qnil;
+	struct timeval timeout, *ptimeout;
 
+	argc = pgconn_scan_timeout( argc, argv, &timeout, &ptimeout );
 	pgconn_discard_results( self );
 	/* If called with no or nil parameters, use PQsendQuery for compatibility */
 	if ( argc == 1 || (argc >= 2 && argc <= 4 && NIL_P(argv[1]) )) {
@@ -3547,7 +4218,7 @@ pgconn_async_exec_params(int argc, VALUE *argv, VALUE self)
 	} else {
 		pgconn_send_query_params( argc, argv, self );
 	}
-	rb_pgresult = pgconn_async_get_last_result( self );
+	rb_pgresult = pgconn_async_get_last_result_timeout( self, ptimeout );
 
 	if ( rb_block_given_p() ) {
 		return rb_ensure( rb_yield, rb_pgresult, pg_result_clear, rb_pgresult );
@@ -3596,8 +4267,8 @@ pgconn_async_prepare(int argc, VALUE *argv, VALUE self)
 
 /*
  * call-seq:
- *    conn.exec_prepared(statement_name [, params, result_format[, type_map]] ) -> PG::Result
- *    conn.exec_prepared(statement_name [, params, result_format[, type_map]] ) {|pg_result| block }
+ *    conn.exec_prepared(statement_name [, params, result_format[, type_map]] [, timeout: nil ] ) -> PG::Result
+ *    conn.exec_prepared(statement_name [, params, result_format[, type_map]] [, timeout: nil ] ) {|pg_result| block }
  *
  * Execute prepared named statement specified by _statement_name_.
  * Returns a PG::Result instance on success.
@@ -3629,16 +4300,20 @@ pgconn_async_prepare(int argc, VALUE *argv, VALUE self)
  * and the PG::Result object will  automatically be cleared when the block terminates.
  * In this instance, <code>conn.exec_prepared</code> returns the value of the block.
  *
+ * See #exec for the optional +timeout+ .
+ *
  * See also corresponding {libpq function}[https://www.postgresql.org/docs/current/libpq-exec.html#LIBPQ-PQEXECPREPARED].
  */
 static VALUE
 pgconn_async_exec_prepared(int argc, VALUE *argv, VALUE self)
 {
 	VALUE rb_pgresult = Qnil;
+	struct timeval timeout, *ptimeout;
 
+	argc = pgconn_scan_timeout( argc, argv, &timeout, &ptimeout );
 	pgconn_discard_results( self );
 	pgconn_send_query_prepared( argc, argv, self );
-	rb_pgresult = pgconn_async_get_last_result( self );
+	rb_pgresult = pgconn_async_get_last_result_timeout( self, ptimeout );
 
 	if ( rb_block_given_p() ) {
 		return rb_ensure( rb_yield, rb_pgresult, pg_result_clear, rb_pgresult );
@@ -4736,6 +5411,10 @@ init_pg_connection(void)
 {
 	s_id_encode = rb_intern("encode");
 	s_id_autoclose_set = rb_intern("autoclose=");
+	s_id_timeout = rb_intern("timeout");
+	s_id_async_cancel = rb_intern("async_cancel");
+	s_id_reset = rb_intern("reset");
+	s_id_call = rb_intern("call");
 	sym_type = ID2SYM(rb_intern("type"));
 	sym_format = ID2SYM(rb_intern("format"));
 	sym_value = ID2SYM(rb_intern("value"));
@@ -4866,6 +5545,7 @@ init_pg_connection(void)
 	rb_define_method(rb_cPGconn, "flush", pgconn_async_flush, 0);
 	rb_define_alias(rb_cPGconn, "async_flush", "flush");
 	rb_define_method(rb_cPGconn, "discard_results", pgconn_discard_results, 0);
+	rb_define_private_method(rb_cPGconn, "query_timeout", pgconn_query_timeout_m, 1);
 
 	/******     PG::Connection INSTANCE METHODS: Cancelling Queries in Progress     ******/
 #ifndef LIBPQ_HAS_CHUNK_MODE
@@ -4877,8 +5557,16 @@ init_pg_connection(void)
 
 	/******     PG::Connection INSTANCE METHODS: COPY     ******/
 	rb_define_method(rb_cPGconn, "sync_put_copy_data", pgconn_sync_put_copy_data, -1);
+	rb_define_private_method(rb_cPGconn, "put_copy_rows_buffered", pgconn_put_copy_rows_buffered, 5);
 	rb_define_method(rb_cPGconn, "sync_put_copy_end", pgconn_sync_put_copy_end, -1);
 	rb_define_method(rb_cPGconn, "sync_get_copy_data", pgconn_sync_get_copy_data, -1);
+	rb_define_method(rb_cPGconn, "sync_get_copy_rows", pgconn_sync_get_copy_rows, -1);
+	rb_define_private_method(rb_cPGconn, "get_copy_chunk", pgconn_get_copy_chunk, 2);
+	rb_define_method(rb_cPGconn, "enable_copy_stats", pgconn_enable_copy_stats, -1);
+	rb_define_method(rb_cPGconn, "disable_copy_stats", pgconn_disable_copy_stats, 0);
+	rb_define_method(rb_cPGconn, "copy_stats", pgconn_copy_stats, 0);
+	rb_define_method(rb_cPGconn, "reset_copy_stats", pgconn_reset_copy_stats, 0);
+	rb_define_private_method(rb_cPGconn, "add_copy_wait_ns", pgconn_add_copy_wait_ns, 1);
 
 	/******     PG::Connection INSTANCE METHODS: Control Functions     ******/
 	rb_define_method(rb_cPGconn, "set_error_verbosity", pgconn_set_error_verbosity, 1);
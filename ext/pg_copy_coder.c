@@ -18,8 +18,22 @@ typedef struct {
 	VALUE typemap;
 	VALUE null_string;
 	char delimiter;
+	/* CSV format only */
+	char quote;
+	char escape;
+	VALUE force_quote;
+	/* PG_BIN_* or PG_TEXT_* kind per column of a PG::TypeMapByColumn as frozen String or nil */
+	VALUE plan;
+	/* The type map data the plan was compiled for */
+	t_tmbc *plan_tmbc;
+	/* The generation of plan_tmbc the plan was compiled for */
+	int plan_generation;
 } t_pg_copycoder;
 
+static int pg_bin_enc_copy_row(t_pg_coder *, VALUE, char *, VALUE *, int);
+static VALUE pg_bin_dec_copy_row(t_pg_coder *, const char *, int, int, int, int);
+static VALUE pg_text_dec_copy_row(t_pg_coder *, const char *, int, int, int, int);
+
 
 static void
 pg_copycoder_mark( void *_this )
@@ -27,6 +41,8 @@ pg_copycoder_mark( void *_this )
 	t_pg_copycoder *this = (t_pg_copycoder *)_this;
 	rb_gc_mark_movable(this->typemap);
 	rb_gc_mark_movable(this->null_string);
+	rb_gc_mark_movable(this->force_quote);
+	rb_gc_mark_movable(this->plan);
 }
 
 static size_t
@@ -43,6 +59,8 @@ pg_copycoder_compact( void *_this )
 	pg_coder_compact(&this->comp);
 	pg_gc_location(this->typemap);
 	pg_gc_location(this->null_string);
+	pg_gc_location(this->force_quote);
+	pg_gc_location(this->plan);
 }
 
 static const rb_data_type_t pg_copycoder_type = {
@@ -67,6 +85,10 @@ pg_copycoder_encoder_allocate( VALUE klass )
 	RB_OBJ_WRITE(self, &this->typemap, pg_typemap_all_strings);
 	this->delimiter = '\t';
 	RB_OBJ_WRITE(self, &this->null_string, rb_str_new_cstr("\\N"));
+	this->quote = '"';
+	this->escape = '"';
+	this->force_quote = Qfalse;
+	this->plan = Qnil;
 	return self;
 }
 
@@ -79,6 +101,30 @@ pg_copycoder_decoder_allocate( VALUE klass )
 	RB_OBJ_WRITE(self, &this->typemap, pg_typemap_all_strings);
 	this->delimiter = '\t';
 	RB_OBJ_WRITE(self, &this->null_string, rb_str_new_cstr("\\N"));
+	this->quote = '"';
+	this->escape = '"';
+	this->force_quote = Qfalse;
+	this->plan = Qnil;
+	return self;
+}
+
+static VALUE
+pg_copycoder_csv_encoder_allocate( VALUE klass )
+{
+	VALUE self = pg_copycoder_encoder_allocate( klass );
+	t_pg_copycoder *this = RTYPEDDATA_DATA( self );
+	this->delimiter = ',';
+	RB_OBJ_WRITE(self, &this->null_string, rb_str_new_cstr(""));
+	return self;
+}
+
+static VALUE
+pg_copycoder_csv_decoder_allocate( VALUE klass )
+{
+	VALUE self = pg_copycoder_decoder_allocate( klass );
+	t_pg_copycoder *this = RTYPEDDATA_DATA( self );
+	this->delimiter = ',';
+	RB_OBJ_WRITE(self, &this->null_string, rb_str_new_cstr(""));
 	return self;
 }
 
@@ -144,6 +190,181 @@ pg_copycoder_null_string_get(VALUE self)
 	return this->null_string;
 }
 
+/*
+ * call-seq:
+ *    coder.quote = String
+ *
+ * Specifies the quoting character to be used when a data value is quoted.
+ * The default is double-quote.
+ * This must be a single one-byte character.
+ *
+ * This option is available in CSV format only.
+ */
+static VALUE
+pg_copycoder_quote_set(VALUE self, VALUE quote)
+{
+	t_pg_copycoder *this = RTYPEDDATA_DATA(self);
+	rb_check_frozen(self);
+	StringValue(quote);
+	if(RSTRING_LEN(quote) != 1)
+		rb_raise( rb_eArgError, "quote size must be one byte");
+	this->quote = *RSTRING_PTR(quote);
+	return quote;
+}
+
+/*
+ * call-seq:
+ *    coder.quote -> String
+ *
+ * The quoting character used when a data value is quoted.
+ */
+static VALUE
+pg_copycoder_quote_get(VALUE self)
+{
+	t_pg_copycoder *this = RTYPEDDATA_DATA(self);
+	return rb_str_new(&this->quote, 1);
+}
+
+/*
+ * call-seq:
+ *    coder.escape = String
+ *
+ * Specifies the character that should appear before a data character that matches the #quote value.
+ * The default is the same as the #quote value (so that the quoting character is doubled if it appears in the data).
+ * This must be a single one-byte character.
+ *
+ * Note that #quote= doesn't change the escape character.
+ *
+ * This option is available in CSV format only.
+ */
+static VALUE
+pg_copycoder_escape_set(VALUE self, VALUE escape)
+{
+	t_pg_copycoder *this = RTYPEDDATA_DATA(self);
+	rb_check_frozen(self);
+	StringValue(escape);
+	if(RSTRING_LEN(escape) != 1)
+		rb_raise( rb_eArgError, "escape size must be one byte");
+	this->escape = *RSTRING_PTR(escape);
+	return escape;
+}
+
+/*
+ * call-seq:
+ *    coder.escape -> String
+ *
+ * The character that appears before a data character that matches the #quote value.
+ */
+static VALUE
+pg_copycoder_escape_get(VALUE self)
+{
+	t_pg_copycoder *this = RTYPEDDATA_DATA(self);
+	return rb_str_new(&this->escape, 1);
+}
+
+/*
+ * call-seq:
+ *    coder.force_quote = true, false or Array
+ *
+ * Forces quoting to be used for all non-NULL values (+true+) or for the values of the columns with the given indexes (Array of Integer).
+ * NULL output is never quoted.
+ * By default (+false+) values are quoted only when needed, that is when they contain the delimiter, the quote character, a newline or carriage return character or match the #null_string.
+ *
+ * This option is available in CSV encoder only.
+ */
+static VALUE
+pg_copycoder_force_quote_set(VALUE self, VALUE force_quote)
+{
+	t_pg_copycoder *this = RTYPEDDATA_DATA(self);
+	rb_check_frozen(self);
+	if( RB_TYPE_P(force_quote, T_ARRAY) ){
+		long i;
+		for( i=0; i<RARRAY_LEN(force_quote); i++ ){
+			Check_Type(rb_ary_entry(force_quote, i), T_FIXNUM);
+		}
+		force_quote = rb_obj_freeze(rb_ary_dup(force_quote));
+	} else {
+		force_quote = RTEST(force_quote) ? Qtrue : Qfalse;
+	}
+	RB_OBJ_WRITE(self, &this->force_quote, force_quote);
+	return force_quote;
+}
+
+/*
+ * call-seq:
+ *    coder.force_quote -> true, false or Array
+ *
+ * Whether all non-NULL values or the values of the given column indexes are quoted.
+ */
+static VALUE
+pg_copycoder_force_quote_get(VALUE self)
+{
+	t_pg_copycoder *this = RTYPEDDATA_DATA(self);
+	return this->force_quote;
+}
+
+/*
+ * Compile the coders of a PG::TypeMapByColumn into a per column plan for the binary COPY row coders
+ * and the text COPY row decoder.
+ *
+ * The plan stores the binary representation of each column, so that fixed width values
+ * are encoded and decoded inline instead of calling the coder per field.
+ * The text decoder parses integer columns in place.
+ * It is bound to the data of the type map and therefore ignored, when the type map is initialized again.
+ */
+static void
+pg_copycoder_compile_plan( VALUE self, t_pg_copycoder *this )
+{
+	t_typemap *p_typemap = RTYPEDDATA_DATA( this->typemap );
+	t_tmbc *p_tmbc = NULL;
+	VALUE plan = Qnil;
+
+	if( (this->comp.enc_func == pg_bin_enc_copy_row || this->comp.dec_func == pg_bin_dec_copy_row ||
+				this->comp.dec_func == pg_text_dec_copy_row) &&
+			p_typemap->funcs.typecast_copy_get == pg_tmbc_funcs.typecast_copy_get ){
+		int i;
+		char *kinds;
+
+		p_tmbc = (t_tmbc *)p_typemap;
+		plan = rb_str_new( NULL, p_tmbc->nfields );
+		kinds = RSTRING_PTR( plan );
+		for( i=0; i<p_tmbc->nfields; i++ ){
+			t_pg_coder *p_coder = p_tmbc->convs[i].cconv;
+
+			if( !p_coder ){
+				kinds[i] = PG_BIN_GENERIC;
+			} else if( this->comp.dec_func == pg_text_dec_copy_row ){
+				kinds[i] = pg_coder_dec_func(p_coder, 0) == pg_text_dec_integer ? PG_TEXT_INTEGER : PG_BIN_GENERIC;
+			} else if( this->comp.enc_func ){
+				kinds[i] = pg_bin_enc_kind( pg_coder_enc_func(p_coder) );
+			} else {
+				kinds[i] = pg_bin_dec_kind( pg_coder_dec_func(p_coder, 1) );
+			}
+		}
+		rb_obj_freeze( plan );
+	}
+
+	this->plan_tmbc = p_tmbc;
+	this->plan_generation = p_tmbc ? p_tmbc->generation : 0;
+	RB_OBJ_WRITE(self, &this->plan, plan);
+}
+
+/*
+ * Return the per column kinds of the plan or NULL, if the plan doesn't fit to the current data of the type map.
+ *
+ * The type map data can be at the same address after the type map was initialized again,
+ * so that the generation is compared as well.
+ */
+static const char *
+pg_copycoder_plan_kinds( t_pg_copycoder *this, t_typemap *p_typemap )
+{
+	if( this->plan_tmbc == (t_tmbc *)p_typemap && !NIL_P(this->plan) &&
+			this->plan_tmbc->generation == this->plan_generation ){
+		return RSTRING_PTR( this->plan );
+	}
+	return NULL;
+}
+
 /*
  * call-seq:
  *    coder.type_map = map
@@ -154,6 +375,11 @@ pg_copycoder_null_string_get(VALUE self)
  * Defaults to a PG::TypeMapAllStrings , so that PG::TextEncoder::String respectively
  * PG::TextDecoder::String is used for encoding/decoding of each column.
  *
+ * A PG::TypeMapByColumn assigned to PG::BinaryEncoder::CopyRow or PG::BinaryDecoder::CopyRow
+ * is compiled into a per column plan.
+ * Columns with a boolean, integer or float coder are then processed without calling the coder.
+ * Similarly PG::TextDecoder::CopyRow parses columns with a PG::TextDecoder::Integer in place.
+ *
  */
 static VALUE
 pg_copycoder_type_map_set(VALUE self, VALUE type_map)
@@ -166,6 +392,7 @@ pg_copycoder_type_map_set(VALUE self, VALUE type_map)
 				rb_obj_classname( type_map ) );
 	}
 	RB_OBJ_WRITE(self, &this->typemap, type_map);
+	pg_copycoder_compile_plan(self, this);
 
 	return type_map;
 }
@@ -214,8 +441,11 @@ pg_copycoder_type_map_get(VALUE self)
  * PG::Connection#get_copy_data .
  * And see PG::BinaryEncoder::CopyRow for an encoder of the COPY binary format.
  */
-static int
-pg_text_enc_copy_row(t_pg_coder *conv, VALUE value, char *out, VALUE *intermediate, int enc_idx)
+/*
+ * Append one row in COPY text format to the String +str+.
+ */
+static void
+pg_text_enc_copy_row_append(t_pg_coder *conv, VALUE value, VALUE str, int enc_idx)
 {
 	t_pg_copycoder *this = (t_pg_copycoder *)conv;
 	t_pg_coder_enc_func enc_func;
@@ -229,13 +459,12 @@ pg_text_enc_copy_row(t_pg_coder *conv, VALUE value, char *out, VALUE *intermedia
 	p_typemap = RTYPEDDATA_DATA( rb_typemap );
 	p_typemap->funcs.fit_to_query( rb_typemap, value );
 
-	/* Allocate a new string with embedded capacity and realloc exponential when needed. */
-	PG_RB_STR_NEW( *intermediate, current_out, end_capa_ptr );
-	PG_ENCODING_SET_NOCHECK(*intermediate, enc_idx);
+	/* Write behind the current content and realloc exponential when needed. */
+	current_out = end_capa_ptr = RSTRING_PTR(str) + RSTRING_LEN(str);
 
 	for( i=0; i<RARRAY_LENINT(value); i++){
-		char *ptr1;
-		char *ptr2;
+		const char *ptr1;
+		const char *ptr2;
 		int strlen;
 		int backslashes;
 		VALUE subint;
@@ -244,13 +473,13 @@ pg_text_enc_copy_row(t_pg_coder *conv, VALUE value, char *out, VALUE *intermedia
 		entry = rb_ary_entry(value, i);
 
 		if( i > 0 ){
-			PG_RB_STR_ENSURE_CAPA( *intermediate, 1, current_out, end_capa_ptr );
+			PG_RB_STR_ENSURE_CAPA( str, 1, current_out, end_capa_ptr );
 			*current_out++ = this->delimiter;
 		}
 
 		switch(TYPE(entry)){
 			case T_NIL:
-				PG_RB_STR_ENSURE_CAPA( *intermediate, RSTRING_LEN(this->null_string), current_out, end_capa_ptr );
+				PG_RB_STR_ENSURE_CAPA( str, RSTRING_LEN(this->null_string), current_out, end_capa_ptr );
 				memcpy( current_out, RSTRING_PTR(this->null_string), RSTRING_LEN(this->null_string) );
 				current_out += RSTRING_LEN(this->null_string);
 				break;
@@ -266,20 +495,26 @@ pg_text_enc_copy_row(t_pg_coder *conv, VALUE value, char *out, VALUE *intermedia
 					strlen = RSTRING_LENINT(subint);
 
 					/* size of string assuming the worst case, that every character must be escaped. */
-					PG_RB_STR_ENSURE_CAPA( *intermediate, (size_t)strlen * 2, current_out, end_capa_ptr );
+					PG_RB_STR_ENSURE_CAPA( str, (size_t)strlen * 2, current_out, end_capa_ptr );
 
-					/* Copy string from subint with backslash escaping */
-					for(ptr1 = RSTRING_PTR(subint); ptr1 < RSTRING_PTR(subint) + strlen; ptr1++) {
+					/* Copy string from subint with backslash escaping.
+					 * Runs of characters without escaping are copied at once. */
+					ptr1 = RSTRING_PTR(subint);
+					ptr2 = ptr1 + strlen;
+					for(;;) {
 						/* Escape backslash itself, newline, carriage return, and the current delimiter character. */
-						if(*ptr1 == '\\' || *ptr1 == '\n' || *ptr1 == '\r' || *ptr1 == this->delimiter){
-							*current_out++ = '\\';
-						}
-						*current_out++ = *ptr1;
+						const char *special = rbpg_find_any4(ptr1, ptr2, '\\', '\n', '\r', this->delimiter);
+						memcpy( current_out, ptr1, special - ptr1 );
+						current_out += special - ptr1;
+						if( special == ptr2 ) break;
+						*current_out++ = '\\';
+						*current_out++ = *special;
+						ptr1 = special + 1;
 					}
 				} else {
 					/* 2nd pass for writing the data to prepared buffer */
 					/* size of string assuming the worst case, that every character must be escaped. */
-					PG_RB_STR_ENSURE_CAPA( *intermediate, (size_t)strlen * 2, current_out, end_capa_ptr );
+					PG_RB_STR_ENSURE_CAPA( str, (size_t)strlen * 2, current_out, end_capa_ptr );
 
 					/* Place the unescaped string at current output position. */
 					strlen = enc_func(p_elem_coder, entry, current_out, &subint, enc_idx);
@@ -288,38 +523,270 @@ pg_text_enc_copy_row(t_pg_coder *conv, VALUE value, char *out, VALUE *intermedia
 					ptr2 = current_out + strlen;
 
 					/* count required backlashs */
-					for(backslashes = 0; ptr1 != ptr2; ptr1++) {
+					for(backslashes = 0; ; backslashes++) {
 						/* Escape backslash itself, newline, carriage return, and the current delimiter character. */
-						if(*ptr1 == '\\' || *ptr1 == '\n' || *ptr1 == '\r' || *ptr1 == this->delimiter){
-							backslashes++;
+						ptr1 = rbpg_find_any4(ptr1, ptr2, '\\', '\n', '\r', this->delimiter);
+						if( ptr1 == ptr2 ) break;
+						ptr1++;
+					}
+
+					if( backslashes == 0 ){
+						/* Fast path: the string is already at its final position */
+						current_out += strlen;
+					} else {
+						char *ptr3 = current_out + strlen + backslashes;
+						char *ptr4 = current_out + strlen;
+						current_out = ptr3;
+
+						/* Then store the escaped string on the final position, walking
+						 * right to left, until all backslashes are placed. */
+						while( ptr4 != ptr3 ) {
+							*--ptr3 = *--ptr4;
+							if(*ptr4 == '\\' || *ptr4 == '\n' || *ptr4 == '\r' || *ptr4 == this->delimiter){
+								*--ptr3 = '\\';
+							}
 						}
 					}
+				}
+		}
+	}
+	PG_RB_STR_ENSURE_CAPA( str, 1, current_out, end_capa_ptr );
+	*current_out++ = '\n';
 
-					ptr1 = current_out + strlen;
-					ptr2 = current_out + strlen + backslashes;
-					current_out = ptr2;
+	rb_str_set_len( str, current_out - RSTRING_PTR(str) );
 
-					/* Then store the escaped string on the final position, walking
-					 * right to left, until all backslashes are placed. */
-					while( ptr1 != ptr2 ) {
-						*--ptr2 = *--ptr1;
-						if(*ptr1 == '\\' || *ptr1 == '\n' || *ptr1 == '\r' || *ptr1 == this->delimiter){
-							*--ptr2 = '\\';
-						}
+	RB_GC_GUARD(rb_typemap);
+}
+
+static int
+pg_text_enc_copy_row(t_pg_coder *conv, VALUE value, char *out, VALUE *intermediate, int enc_idx)
+{
+	*intermediate = rb_str_new( NULL, 0 );
+	PG_ENCODING_SET_NOCHECK(*intermediate, enc_idx);
+	pg_text_enc_copy_row_append( conv, value, *intermediate, enc_idx );
+	return -1;
+}
+
+
+/*
+ * Document-class: PG::TextEncoder::CopyCsvRow < PG::CopyEncoder
+ *
+ * This class encodes one row of arbitrary columns for transmission as COPY data in CSV format.
+ * See the {COPY command}[http://www.postgresql.org/docs/current/static/sql-copy.html]
+ * for description of the format.
+ *
+ * It is intended to be used in conjunction with PG::Connection#put_copy_data .
+ * The COPY command must be started with the same options, that are set on the encoder.
+ *
+ * The columns are expected as Array of values. The single values are encoded as defined
+ * in the assigned #type_map. If no type_map was assigned, all values are converted to
+ * strings by PG::TextEncoder::String.
+ *
+ * The defaults are the defaults of PostgreSQL's CSV format:
+ * #delimiter is a comma, #null_string is an empty string, #quote and #escape are a double-quote.
+ * Values are quoted if needed or as specified by #force_quote .
+ *
+ * Example:
+ *   conn.exec "create table my_table (a text,b int,c bool)"
+ *   enco = PG::TextEncoder::CopyCsvRow.new
+ *   conn.copy_data "COPY my_table FROM STDIN (FORMAT csv)", enco do
+ *     conn.put_copy_data ["a string, with comma", 7, false]
+ *     conn.put_copy_data ["", nil, true]
+ *   end
+ * This creates +my_table+ and inserts two rows.
+ * The empty string is sent as <tt>""</tt> to distinguish it from NULL.
+ *
+ * See also PG::TextDecoder::CopyCsvRow for the decoding direction with
+ * PG::Connection#get_copy_data .
+ */
+/*
+ * Append one row in COPY CSV format to the String +str+.
+ */
+static void
+pg_text_enc_copy_csv_row_append(t_pg_coder *conv, VALUE value, VALUE str, int enc_idx)
+{
+	t_pg_copycoder *this = (t_pg_copycoder *)conv;
+	t_pg_coder_enc_func enc_func;
+	t_pg_coder *p_elem_coder;
+	int i;
+	VALUE rb_typemap = this->typemap;
+	t_typemap *p_typemap;
+	char *current_out;
+	char *end_capa_ptr;
+	int nfields = RARRAY_LENINT(value);
+
+	p_typemap = RTYPEDDATA_DATA( rb_typemap );
+	p_typemap->funcs.fit_to_query( rb_typemap, value );
+
+	/* Write behind the current content and realloc exponential when needed. */
+	current_out = end_capa_ptr = RSTRING_PTR(str) + RSTRING_LEN(str);
+
+	for( i=0; i<nfields; i++){
+		char *field_ptr;
+		const char *ptr1;
+		const char *ptr2;
+		int strlen;
+		int use_quote;
+		VALUE subint;
+		VALUE entry;
+
+		entry = rb_ary_entry(value, i);
+
+		if( i > 0 ){
+			PG_RB_STR_ENSURE_CAPA( str, 1, current_out, end_capa_ptr );
+			*current_out++ = this->delimiter;
+		}
+
+		if( NIL_P(entry) ){
+			/* NULL is never quoted */
+			PG_RB_STR_ENSURE_CAPA( str, RSTRING_LEN(this->null_string), current_out, end_capa_ptr );
+			memcpy( current_out, RSTRING_PTR(this->null_string), RSTRING_LEN(this->null_string) );
+			current_out += RSTRING_LEN(this->null_string);
+			continue;
+		}
+
+		p_elem_coder = p_typemap->funcs.typecast_query_param(p_typemap, entry, i);
+		enc_func = pg_coder_enc_func(p_elem_coder);
+
+		/* 1st pass for retiving the required memory space */
+		strlen = enc_func(p_elem_coder, entry, NULL, &subint, enc_idx);
+
+		/* The unquoted value is placed behind the opening quote.
+		 * Size of string assuming the worst case, that every character must be escaped plus two quotes. */
+		if( strlen == -1 ){
+			/* we can directly use String value in subint */
+			strlen = RSTRING_LENINT(subint);
+			PG_RB_STR_ENSURE_CAPA( str, (size_t)strlen * 2 + 2, current_out, end_capa_ptr );
+			field_ptr = current_out + 1;
+			memcpy( field_ptr, RSTRING_PTR(subint), strlen );
+		} else {
+			PG_RB_STR_ENSURE_CAPA( str, (size_t)strlen * 2 + 2, current_out, end_capa_ptr );
+			field_ptr = current_out + 1;
+			/* 2nd pass for writing the data to prepared buffer */
+			strlen = enc_func(p_elem_coder, entry, field_ptr, &subint, enc_idx);
+		}
+
+		if( this->force_quote == Qtrue ){
+			use_quote = 1;
+		} else if( RB_TYPE_P(this->force_quote, T_ARRAY) && RTEST(rb_ary_includes(this->force_quote, INT2FIX(i))) ){
+			use_quote = 1;
+		} else if( strlen == RSTRING_LEN(this->null_string) && memcmp(field_ptr, RSTRING_PTR(this->null_string), strlen) == 0 ){
+			/* Make sure the value is distinguishable from NULL */
+			use_quote = 1;
+		} else if( nfields == 1 && strlen == 2 && field_ptr[0] == '\\' && field_ptr[1] == '.' ){
+			/* Because \. can be a data value, quote it if it appears alone on a line */
+			use_quote = 1;
+		} else {
+			use_quote = rbpg_find_any4(field_ptr, field_ptr + strlen, this->delimiter, this->quote, '\n', '\r') != field_ptr + strlen;
+		}
+
+		if( !use_quote ){
+			memmove( current_out, field_ptr, strlen );
+			current_out += strlen;
+		} else {
+			int escapes = 0;
+			char *ptr3;
+
+			/* count required escape characters */
+			ptr1 = field_ptr;
+			ptr2 = field_ptr + strlen;
+			for(;;) {
+				ptr1 = rbpg_find_any4(ptr1, ptr2, this->quote, this->escape, this->quote, this->escape);
+				if( ptr1 == ptr2 ) break;
+				escapes++;
+				ptr1++;
+			}
+
+			/* Then store the escaped string on the final position, walking
+			 * right to left, until all escape characters are placed. */
+			ptr3 = current_out + strlen + escapes + 1;
+			*ptr3 = this->quote;
+			if( escapes ){
+				char *ptr4 = field_ptr + strlen;
+				while( ptr4 != ptr3 ) {
+					*--ptr3 = *--ptr4;
+					if(*ptr4 == this->quote || *ptr4 == this->escape){
+						*--ptr3 = this->escape;
 					}
 				}
+			}
+			*current_out = this->quote;
+			current_out += strlen + escapes + 2;
 		}
 	}
-	PG_RB_STR_ENSURE_CAPA( *intermediate, 1, current_out, end_capa_ptr );
+	PG_RB_STR_ENSURE_CAPA( str, 1, current_out, end_capa_ptr );
 	*current_out++ = '\n';
 
-	rb_str_set_len( *intermediate, current_out - RSTRING_PTR(*intermediate) );
+	rb_str_set_len( str, current_out - RSTRING_PTR(str) );
 
 	RB_GC_GUARD(rb_typemap);
+}
+
+static int
+pg_text_enc_copy_csv_row(t_pg_coder *conv, VALUE value, char *out, VALUE *intermediate, int enc_idx)
+{
+	*intermediate = rb_str_new( NULL, 0 );
+	PG_ENCODING_SET_NOCHECK(*intermediate, enc_idx);
+	pg_text_enc_copy_csv_row_append( conv, value, *intermediate, enc_idx );
 	return -1;
 }
 
 
+/*
+ * Write length and data of a fixed width column of the plan.
+ *
+ * Returns the number of bytes written (at most 12) or 0 if the value must be encoded by the coder.
+ */
+static inline int
+pg_bin_enc_copy_field(int kind, VALUE value, char *out)
+{
+	union {
+		float f;
+		int32_t i;
+	} swap4;
+	union {
+		double f;
+		int64_t i;
+	} swap8;
+
+	switch(kind){
+		case PG_BIN_BOOLEAN:
+			if( value != Qtrue && value != Qfalse ) return 0;
+			write_nbo32(1, out);
+			out[4] = value == Qtrue;
+			return 5;
+		case PG_BIN_INT2:
+			if( !FIXNUM_P(value) ) return 0;
+			write_nbo32(2, out);
+			write_nbo16(NUM2INT(value), out + 4);
+			return 6;
+		case PG_BIN_INT4:
+			if( !FIXNUM_P(value) ) return 0;
+			write_nbo32(4, out);
+			write_nbo32(NUM2LONG(value), out + 4);
+			return 8;
+		case PG_BIN_INT8:
+			if( !FIXNUM_P(value) ) return 0;
+			write_nbo32(8, out);
+			write_nbo64(NUM2LL(value), out + 4);
+			return 12;
+		case PG_BIN_FLOAT4:
+			if( !RB_FLOAT_TYPE_P(value) ) return 0;
+			swap4.f = RFLOAT_VALUE(value);
+			write_nbo32(4, out);
+			write_nbo32(swap4.i, out + 4);
+			return 8;
+		case PG_BIN_FLOAT8:
+			if( !RB_FLOAT_TYPE_P(value) ) return 0;
+			swap8.f = RFLOAT_VALUE(value);
+			write_nbo32(8, out);
+			write_nbo64(swap8.i, out + 4);
+			return 12;
+		default:
+			return 0;
+	}
+}
+
 /*
  * Document-class: PG::BinaryEncoder::CopyRow < PG::CopyEncoder
  *
@@ -363,13 +830,18 @@ pg_text_enc_copy_row(t_pg_coder *conv, VALUE value, char *out, VALUE *intermedia
  * PG::Connection#get_copy_data .
  * And see PG::TextEncoder::CopyRow for an encoder of the COPY text format.
  */
-static int
-pg_bin_enc_copy_row(t_pg_coder *conv, VALUE value, char *out, VALUE *intermediate, int enc_idx)
+/*
+ * Append one row in COPY binary format to the String +str+.
+ */
+static void
+pg_bin_enc_copy_row_append(t_pg_coder *conv, VALUE value, VALUE str, int enc_idx)
 {
 	t_pg_copycoder *this = (t_pg_copycoder *)conv;
 	int i;
 	VALUE rb_typemap = this->typemap;
+	VALUE plan = this->plan;
 	t_typemap *p_typemap;
+	const char *kinds = NULL;
 	char *current_out;
 	char *end_capa_ptr;
 
@@ -379,13 +851,14 @@ pg_bin_enc_copy_row(t_pg_coder *conv, VALUE value, char *out, VALUE *intermediat
 
 	p_typemap = RTYPEDDATA_DATA( rb_typemap );
 	p_typemap->funcs.fit_to_query( rb_typemap, value );
+	/* The number of columns of the plan equals the array length after fit_to_query() */
+	kinds = pg_copycoder_plan_kinds( this, p_typemap );
 
-	/* Allocate a new string with embedded capacity and realloc exponential when needed. */
-	PG_RB_STR_NEW( *intermediate, current_out, end_capa_ptr );
-	PG_ENCODING_SET_NOCHECK(*intermediate, enc_idx);
+	/* Write behind the current content and realloc exponential when needed. */
+	current_out = end_capa_ptr = RSTRING_PTR(str) + RSTRING_LEN(str);
 
 	/* 2 bytes for number of fields */
-	PG_RB_STR_ENSURE_CAPA( *intermediate, 2, current_out, end_capa_ptr );
+	PG_RB_STR_ENSURE_CAPA( str, 2, current_out, end_capa_ptr );
 	write_nbo16(RARRAY_LEN(value), current_out);
 	current_out += 2;
 
@@ -398,10 +871,20 @@ pg_bin_enc_copy_row(t_pg_coder *conv, VALUE value, char *out, VALUE *intermediat
 
 		entry = rb_ary_entry(value, i);
 
+		if( kinds && kinds[i] != PG_BIN_GENERIC ){
+			/* 4 bytes length and up to 8 bytes fixed width data */
+			PG_RB_STR_ENSURE_CAPA( str, 12, current_out, end_capa_ptr );
+			strlen = pg_bin_enc_copy_field(kinds[i], entry, current_out);
+			if( strlen ){
+				current_out += strlen;
+				continue;
+			}
+		}
+
 		switch(TYPE(entry)){
 			case T_NIL:
 				/* 4 bytes for -1 indicating a NULL value */
-				PG_RB_STR_ENSURE_CAPA( *intermediate, 4, current_out, end_capa_ptr );
+				PG_RB_STR_ENSURE_CAPA( str, 4, current_out, end_capa_ptr );
 				write_nbo32(-1, current_out);
 				current_out += 4;
 				break;
@@ -416,7 +899,7 @@ pg_bin_enc_copy_row(t_pg_coder *conv, VALUE value, char *out, VALUE *intermediat
 					/* we can directly use String value in subint */
 					strlen = RSTRING_LENINT(subint);
 
-					PG_RB_STR_ENSURE_CAPA( *intermediate, (size_t)4 + strlen, current_out, end_capa_ptr );
+					PG_RB_STR_ENSURE_CAPA( str, (size_t)4 + strlen, current_out, end_capa_ptr );
 					/* 4 bytes length */
 					write_nbo32(strlen, current_out);
 					current_out += 4;
@@ -425,7 +908,7 @@ pg_bin_enc_copy_row(t_pg_coder *conv, VALUE value, char *out, VALUE *intermediat
 					current_out += strlen;
 				} else {
 					/* 2nd pass for writing the data to prepared buffer */
-					PG_RB_STR_ENSURE_CAPA( *intermediate, (size_t)4 + strlen, current_out, end_capa_ptr );
+					PG_RB_STR_ENSURE_CAPA( str, (size_t)4 + strlen, current_out, end_capa_ptr );
 					/* 4 bytes length */
 					write_nbo32(strlen, current_out);
 					current_out += 4;
@@ -437,12 +920,44 @@ pg_bin_enc_copy_row(t_pg_coder *conv, VALUE value, char *out, VALUE *intermediat
 		}
 	}
 
-	rb_str_set_len( *intermediate, current_out - RSTRING_PTR(*intermediate) );
+	rb_str_set_len( str, current_out - RSTRING_PTR(str) );
 
 	RB_GC_GUARD(rb_typemap);
+	RB_GC_GUARD(plan);
+}
+
+static int
+pg_bin_enc_copy_row(t_pg_coder *conv, VALUE value, char *out, VALUE *intermediate, int enc_idx)
+{
+	*intermediate = rb_str_new( NULL, 0 );
+	PG_ENCODING_SET_NOCHECK(*intermediate, enc_idx);
+	pg_bin_enc_copy_row_append( conv, value, *intermediate, enc_idx );
 	return -1;
 }
 
+/*
+ * Append one row encoded by the CopyRow encoder +conv+ to the String +str+, without an intermediate String.
+ *
+ * Returns 0 if +conv+ is no PG::TextEncoder::CopyRow, PG::TextEncoder::CopyCsvRow or PG::BinaryEncoder::CopyRow .
+ * The content of +str+ behind its length is undefined, if an exception is raised.
+ */
+int
+pg_copycoder_enc_append(t_pg_coder *conv, VALUE value, VALUE str, int enc_idx)
+{
+	t_pg_coder_enc_func enc_func = pg_coder_enc_func( conv );
+
+	if( enc_func == pg_text_enc_copy_row ){
+		pg_text_enc_copy_row_append( conv, value, str, enc_idx );
+	} else if( enc_func == pg_text_enc_copy_csv_row ){
+		pg_text_enc_copy_csv_row_append( conv, value, str, enc_idx );
+	} else if( enc_func == pg_bin_enc_copy_row ){
+		pg_bin_enc_copy_row_append( conv, value, str, enc_idx );
+	} else {
+		return 0;
+	}
+	return 1;
+}
+
 
 /*
  *	Return decimal value for a hexadecimal digit
@@ -539,10 +1054,13 @@ pg_text_dec_copy_row(t_pg_coder *conv, const char *input_line, int len, int _tup
 	const char *line_end_ptr;
 	char *end_capa_ptr;
 	VALUE rb_typemap = this->typemap;
+	VALUE plan = this->plan;
 	t_typemap *p_typemap;
+	const char *kinds = NULL;
 
 	p_typemap = RTYPEDDATA_DATA( rb_typemap );
 	expected_fields = p_typemap->funcs.fit_to_copy_get( rb_typemap );
+	kinds = pg_copycoder_plan_kinds( this, p_typemap );
 
 	/* The received input string will probably have this->nfields fields. */
 	array = rb_ary_new2(expected_fields);
@@ -567,6 +1085,30 @@ pg_text_dec_copy_row(t_pg_coder *conv, const char *input_line, int len, int _tup
 		/* Remember start of field on input side */
 		start_ptr = cur_ptr;
 
+		/* Parse integer columns of the plan in place, if the field doesn't need de-escaping. */
+		if( kinds && fieldno < RSTRING_LEN(plan) && kinds[fieldno] == PG_TEXT_INTEGER ){
+			const char *field_end = rbpg_find_any4(cur_ptr, line_end_ptr, delimc, '\n', '\\', delimc);
+			int64_t i;
+
+			if( (field_end >= line_end_ptr || *field_end != '\\') &&
+					!(field_end - cur_ptr == RSTRING_LEN(this->null_string) &&
+						strncmp(cur_ptr, RSTRING_PTR(this->null_string), field_end - cur_ptr) == 0) &&
+					rbpg_parse_int64(cur_ptr, field_end, &i) ){
+				rb_ary_push(array, LL2NUM(i));
+				fieldno++;
+				cur_ptr = field_end;
+				if( cur_ptr < line_end_ptr && *cur_ptr == delimc ){
+					cur_ptr++;
+					continue;
+				}
+				/* Skip the linefeed */
+				if( cur_ptr < line_end_ptr ) cur_ptr++;
+				if( cur_ptr < line_end_ptr )
+					rb_raise( rb_eArgError, "trailing data after linefeed at position: %ld", (long)(cur_ptr - input_line) + 1 );
+				break;
+			}
+		}
+
 		/*
 		 * Scan data for field.
 		 *
@@ -582,6 +1124,15 @@ pg_text_dec_copy_row(t_pg_coder *conv, const char *input_line, int len, int _tup
 		{
 			/* The current character in the input string. */
 			char c;
+			/* Find the next special character and copy the characters before at once. */
+			const char *special_ptr = rbpg_find_any4(cur_ptr, line_end_ptr, delimc, '\n', '\\', delimc);
+
+			if (special_ptr > cur_ptr){
+				PG_RB_STR_ENSURE_CAPA( field_str, special_ptr - cur_ptr, output_ptr, end_capa_ptr );
+				memcpy(output_ptr, cur_ptr, special_ptr - cur_ptr);
+				output_ptr += special_ptr - cur_ptr;
+				cur_ptr = special_ptr;
+			}
 
 			end_ptr = cur_ptr;
 			if (cur_ptr >= line_end_ptr)
@@ -723,6 +1274,222 @@ pg_text_dec_copy_row(t_pg_coder *conv, const char *input_line, int len, int _tup
 			break;
 	}
 
+	RB_GC_GUARD(rb_typemap);
+	RB_GC_GUARD(plan);
+
+	return array;
+}
+
+
+/*
+ * Document-class: PG::TextDecoder::CopyCsvRow < PG::CopyDecoder
+ *
+ * This class decodes one row of arbitrary columns received as COPY data in CSV format.
+ * See the {COPY command}[http://www.postgresql.org/docs/current/static/sql-copy.html]
+ * for description of the format.
+ *
+ * It is intended to be used in conjunction with PG::Connection#get_copy_data .
+ * The COPY command must be started with the same options, that are set on the decoder.
+ *
+ * The columns are retrieved as Array of values. The single values are decoded as defined
+ * in the assigned #type_map. If no type_map was assigned, all values are converted to
+ * strings by PG::TextDecoder::String.
+ *
+ * The defaults are the defaults of PostgreSQL's CSV format:
+ * #delimiter is a comma, #null_string is an empty string, #quote and #escape are a double-quote.
+ * A value is decoded as +nil+ only if it matches #null_string and is not quoted.
+ *
+ * Example:
+ *   deco = PG::TextDecoder::CopyCsvRow.new
+ *   conn.copy_data "COPY my_table TO STDOUT (FORMAT csv)", deco do
+ *     while row=conn.get_copy_data
+ *       p row
+ *     end
+ *   end
+ *
+ * See also PG::TextEncoder::CopyCsvRow for the encoding direction with
+ * PG::Connection#put_copy_data .
+ */
+/*
+ * Parse the current CSV line into separate attributes (fields),
+ * performing de-quoting as needed.
+ *
+ * The parser follows CopyReadAttributesCSV() of the PostgreSQL sources:
+ * src/backend/commands/copyfromparse.c
+ */
+static VALUE
+pg_text_dec_copy_csv_row(t_pg_coder *conv, const char *input_line, int len, int _tuple, int _field, int enc_idx)
+{
+	t_pg_copycoder *this = (t_pg_copycoder *)conv;
+
+	/* Return value: array */
+	VALUE array;
+
+	/* Current field */
+	VALUE field_str;
+
+	char delimc = this->delimiter;
+	char quotec = this->quote;
+	char escapec = this->escape;
+	int fieldno;
+	int expected_fields;
+	char *output_ptr;
+	const char *cur_ptr;
+	const char *line_end_ptr;
+	char *end_capa_ptr;
+	VALUE rb_typemap = this->typemap;
+	t_typemap *p_typemap;
+
+	p_typemap = RTYPEDDATA_DATA( rb_typemap );
+	expected_fields = p_typemap->funcs.fit_to_copy_get( rb_typemap );
+
+	/* The received input string will probably have this->nfields fields. */
+	array = rb_ary_new2(expected_fields);
+
+	/* Allocate a new string with embedded capacity and realloc later with
+	 * exponential growing size when needed. */
+	PG_RB_STR_NEW( field_str, output_ptr, end_capa_ptr );
+
+	/* set pointer variables for loop */
+	cur_ptr = input_line;
+	line_end_ptr = input_line + len;
+
+	/* Strip the line end, which is either LF or CR LF. */
+	if( line_end_ptr > cur_ptr && line_end_ptr[-1] == '\n' ) line_end_ptr--;
+	if( line_end_ptr > cur_ptr && line_end_ptr[-1] == '\r' ) line_end_ptr--;
+
+	/* Outer loop iterates over fields */
+	fieldno = 0;
+	for (;;)
+	{
+		int found_delim = 0;
+		int saw_quote = 0;
+		const char *start_ptr;
+		const char *end_ptr;
+		size_t input_len;
+
+		/* Remember start of field on input side */
+		start_ptr = cur_ptr;
+
+		/*
+		 * Scan data for field,
+		 *
+		 * The loop starts in "not quote" mode and then toggles between that
+		 * and "in quote" mode. The loop exits normally if it is in "not
+		 * quote" mode and a delimiter or line end is seen.
+		 */
+		for (;;)
+		{
+			char c;
+
+			/* Not in quote */
+			for (;;)
+			{
+				/* Find the next special character and copy the characters before at once. */
+				const char *special_ptr = rbpg_find_any4(cur_ptr, line_end_ptr, delimc, quotec, '\n', '\r');
+
+				if (special_ptr > cur_ptr){
+					PG_RB_STR_ENSURE_CAPA( field_str, special_ptr - cur_ptr, output_ptr, end_capa_ptr );
+					memcpy(output_ptr, cur_ptr, special_ptr - cur_ptr);
+					output_ptr += special_ptr - cur_ptr;
+					cur_ptr = special_ptr;
+				}
+
+				end_ptr = cur_ptr;
+				if (cur_ptr >= line_end_ptr)
+					goto endfield;
+				c = *cur_ptr++;
+				/* unquoted field delimiter */
+				if (c == delimc){
+					found_delim = 1;
+					goto endfield;
+				}
+				/* start of quoted field (or part of field) */
+				if (c == quotec){
+					saw_quote = 1;
+					break;
+				}
+				rb_raise( rb_eArgError, "unquoted %s in CSV data at position: %ld", c == '\n' ? "newline" : "carriage return", (long)(cur_ptr - input_line) );
+			}
+
+			/* In quote */
+			for (;;)
+			{
+				const char *special_ptr = rbpg_find_any4(cur_ptr, line_end_ptr, quotec, escapec, quotec, escapec);
+
+				if (special_ptr > cur_ptr){
+					PG_RB_STR_ENSURE_CAPA( field_str, special_ptr - cur_ptr, output_ptr, end_capa_ptr );
+					memcpy(output_ptr, cur_ptr, special_ptr - cur_ptr);
+					output_ptr += special_ptr - cur_ptr;
+					cur_ptr = special_ptr;
+				}
+
+				if (cur_ptr >= line_end_ptr)
+					rb_raise( rb_eArgError, "unterminated CSV quoted field" );
+
+				c = *cur_ptr++;
+
+				/* escape within a quoted field */
+				if (c == escapec){
+					/*
+					 * peek at the next char if available, and escape it if it
+					 * is an escape char or a quote char
+					 */
+					if (cur_ptr < line_end_ptr){
+						char nextc = *cur_ptr;
+
+						if (nextc == escapec || nextc == quotec){
+							PG_RB_STR_ENSURE_CAPA( field_str, 1, output_ptr, end_capa_ptr );
+							*output_ptr++ = nextc;
+							cur_ptr++;
+							continue;
+						}
+					}
+				}
+
+				/*
+				 * end of quoted field. Must do this test after testing for
+				 * escape in case quote char and escape char are the same
+				 * (which is the common case).
+				 */
+				if (c == quotec)
+					break;
+
+				/* Add c to output string */
+				PG_RB_STR_ENSURE_CAPA( field_str, 1, output_ptr, end_capa_ptr );
+				*output_ptr++ = c;
+			}
+		}
+endfield:
+
+		/* Check whether raw input matched null marker */
+		input_len = end_ptr - start_ptr;
+		if (!saw_quote && input_len == (size_t)RSTRING_LEN(this->null_string) &&
+					strncmp(start_ptr, RSTRING_PTR(this->null_string), input_len) == 0) {
+			rb_ary_push(array, Qnil);
+		} else {
+			VALUE field_value;
+
+			rb_str_set_len( field_str, output_ptr - RSTRING_PTR(field_str) );
+			field_value = p_typemap->funcs.typecast_copy_get( p_typemap, field_str, fieldno, 0, enc_idx );
+
+			rb_ary_push(array, field_value);
+
+			if( field_value == field_str ){
+				/* Our output string will be send to the user, so we can not reuse
+				 * it for the next field. */
+				PG_RB_STR_NEW( field_str, output_ptr, end_capa_ptr );
+			}
+		}
+		/* Reset the pointer to the start of the output/buffer string. */
+		output_ptr = RSTRING_PTR(field_str);
+
+		fieldno++;
+		/* Done if we hit EOL instead of a delim */
+		if (!found_delim)
+			break;
+	}
+
 	RB_GC_GUARD(rb_typemap);
 
 	return array;
@@ -731,6 +1498,50 @@ pg_text_dec_copy_row(t_pg_coder *conv, const char *input_line, int len, int _tup
 
 static const char BinarySignature[11] = {'P','G','C','O','P','Y','\n','\377','\r','\n','\0'};
 
+/*
+ * Decode a field of a column of the plan directly from the COPY data.
+ */
+static inline VALUE
+pg_bin_dec_copy_field(int kind, t_pg_coder *p_coder, const char *val, int len, int fieldno, int enc_idx)
+{
+	union {
+		float f;
+		int32_t i;
+	} swap4;
+	union {
+		double f;
+		int64_t i;
+	} swap8;
+
+	switch(kind){
+		case PG_BIN_BOOLEAN:
+			if( len == 1 ) return *val == 0 ? Qfalse : Qtrue;
+			break;
+		case PG_BIN_INTEGER:
+			switch( len ){
+				case 2:
+					return INT2NUM(read_nbo16(val));
+				case 4:
+					return LONG2NUM(read_nbo32(val));
+				case 8:
+					return LL2NUM(read_nbo64(val));
+			}
+			break;
+		case PG_BIN_FLOAT:
+			switch( len ){
+				case 4:
+					swap4.i = read_nbo32(val);
+					return rb_float_new(swap4.f);
+				case 8:
+					swap8.i = read_nbo64(val);
+					return rb_float_new(swap8.f);
+			}
+			break;
+	}
+	/* PG_BIN_DIRECT or unexpected length -> the decoder reads the data in place or raises the error */
+	return pg_coder_dec_func(p_coder, 1)(p_coder, val, len, 0, fieldno, enc_idx);
+}
+
 /*
  * Document-class: PG::BinaryDecoder::CopyRow < PG::CopyDecoder
  *
@@ -798,10 +1609,13 @@ pg_bin_dec_copy_row(t_pg_coder *conv, const char *input_line, int len, int _tupl
 	const char *line_end_ptr;
 	char *end_capa_ptr;
 	VALUE rb_typemap = this->typemap;
+	VALUE plan = this->plan;
 	t_typemap *p_typemap;
+	const char *kinds = NULL;
 
 	p_typemap = RTYPEDDATA_DATA( rb_typemap );
 	expected_fields = p_typemap->funcs.fit_to_copy_get( rb_typemap );
+	kinds = pg_copycoder_plan_kinds( this, p_typemap );
 
 	/* Allocate a new string with embedded capacity and realloc later with
 	 * exponential growing size when needed. */
@@ -857,6 +1671,14 @@ pg_bin_dec_copy_row(t_pg_coder *conv, const char *input_line, int len, int _tupl
 				VALUE field_value;
 				if (line_end_ptr - cur_ptr < input_len ) goto length_error;
 
+				if( kinds && fieldno < RSTRING_LEN(plan) && kinds[fieldno] != PG_BIN_GENERIC ){
+					/* decode without copying the data into field_str */
+					field_value = pg_bin_dec_copy_field( kinds[fieldno], this->plan_tmbc->convs[fieldno].cconv, cur_ptr, input_len, fieldno, enc_idx );
+					cur_ptr += input_len;
+					rb_ary_push(array, field_value);
+					continue;
+				}
+
 				/* copy input data to field_str */
 				PG_RB_STR_ENSURE_CAPA( field_str, input_len, output_ptr, end_capa_ptr );
 				memcpy(output_ptr, cur_ptr, input_len);
@@ -884,6 +1706,7 @@ pg_bin_dec_copy_row(t_pg_coder *conv, const char *input_line, int len, int _tupl
 		rb_raise( rb_eArgError, "trailing data after row data at position: %ld", (long)(cur_ptr - input_line) + 1 );
 
 	RB_GC_GUARD(rb_typemap);
+	RB_GC_GUARD(plan);
 	return array;
 
 length_error:
@@ -931,4 +1754,27 @@ init_pg_copycoder(void)
 	/* rb_mPG_BinaryDecoder = rb_define_module_under( rb_mPG, "BinaryDecoder" ); */
 	/* dummy = rb_define_class_under( rb_mPG_BinaryDecoder, "CopyRow", rb_cPG_CopyDecoder ); */
 	pg_define_coder( "CopyRow", pg_bin_dec_copy_row, rb_cPG_CopyDecoder, rb_mPG_BinaryDecoder );
+
+	/* rb_mPG_TextEncoder = rb_define_module_under( rb_mPG, "TextEncoder" ); */
+	/* dummy = rb_define_class_under( rb_mPG_TextEncoder, "CopyCsvRow", rb_cPG_CopyEncoder ); */
+	coder = pg_define_coder( "CopyCsvRow", pg_text_enc_copy_csv_row, rb_cPG_CopyEncoder, rb_mPG_TextEncoder );
+	rb_define_alloc_func( coder, pg_copycoder_csv_encoder_allocate );
+	rb_include_module( coder, rb_mPG_BinaryFormatting );
+	rb_define_method( coder, "quote=", pg_copycoder_quote_set, 1 );
+	rb_define_method( coder, "quote", pg_copycoder_quote_get, 0 );
+	rb_define_method( coder, "escape=", pg_copycoder_escape_set, 1 );
+	rb_define_method( coder, "escape", pg_copycoder_escape_get, 0 );
+	rb_define_method( coder, "force_quote=", pg_copycoder_force_quote_set, 1 );
+	rb_define_method( coder, "force_quote", pg_copycoder_force_quote_get, 0 );
+
+	/* rb_mPG_TextDecoder = rb_define_module_under( rb_mPG, "TextDecoder" ); */
+	/* dummy = rb_define_class_under( rb_mPG_TextDecoder, "CopyCsvRow", rb_cPG_CopyDecoder ); */
+	coder = pg_define_coder( "CopyCsvRow", pg_text_dec_copy_csv_row, rb_cPG_CopyDecoder, rb_mPG_TextDecoder );
+	rb_define_alloc_func( coder, pg_copycoder_csv_decoder_allocate );
+	/* CSV data can contain zero bytes and are not zero terminated. So format is set to 1 (binary). */
+	rb_include_module( coder, rb_mPG_BinaryFormatting );
+	rb_define_method( coder, "quote=", pg_copycoder_quote_set, 1 );
+	rb_define_method( coder, "quote", pg_copycoder_quote_get, 0 );
+	rb_define_method( coder, "escape=", pg_copycoder_escape_set, 1 );
+	rb_define_method( coder, "escape", pg_copycoder_escape_get, 0 );
 }
@@ -13,6 +13,7 @@ VALUE rb_eConnectionBad;
 VALUE rb_eInvalidResultStatus;
 VALUE rb_eNoResultError;
 VALUE rb_eInvalidChangeOfResultFields;
+VALUE rb_eQueryTimeout;
 
 static VALUE
 define_error_class(const char *name, const char *baseclass_code)
@@ -92,4 +93,8 @@ init_pg_errors(void)
 	rb_eInvalidChangeOfResultFields = rb_define_class_under( rb_mPG, "InvalidChangeOfResultFields", rb_ePGerror );
 
 	#include "errorcodes.def"
+
+	/* Raised when the +timeout+ of PG::Connection#exec and siblings expired.
+	 * It is derived from PG::QueryCanceled, which is raised for an expired +statement_timeout+ on the server side. */
+	rb_eQueryTimeout = rb_define_class_under( rb_mPG, "QueryTimeout", rb_hash_aref(rb_hErrors, rb_str_new2("57014")) );
 }
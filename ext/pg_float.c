@@ -0,0 +1,427 @@
+/*
+ * pg_float.c - Conversion between double and decimal strings for ruby-pg
+ * $Id$
+ *
+ */
+
+/*
+ * Decimal strings are parsed by the Eisel-Lemire algorithm as described in
+ *   Daniel Lemire, "Number Parsing at a Gigabyte per Second", Software: Practice and Experience 51 (8), 2021
+ * and as implemented in the fast_float library.
+ *
+ * Doubles are formatted to the shortest representation that reads back to the same value by the Ryu algorithm:
+ *   Ulf Adams, "Ryū: fast float-to-string conversion", PLDI 2018
+ *
+ * Both return 0 in rare cases that are not handled, so that the caller falls back to the slower ruby functions.
+ */
+
+#include "pg.h"
+#include "pg_util.h"
+#include <float.h>
+#include "pg_float_tables.h"
+
+typedef struct {
+	uint64_t high;
+	uint64_t low;
+} t_uint128;
+
+static inline t_uint128
+full_multiplication(uint64_t a, uint64_t b)
+{
+	t_uint128 r;
+#if defined(__SIZEOF_INT128__)
+	__uint128_t p = (__uint128_t)a * b;
+	r.high = (uint64_t)(p >> 64);
+	r.low = (uint64_t)p;
+#else
+	uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+	uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+	uint64_t lo_lo = a_lo * b_lo;
+	uint64_t hi_lo = a_hi * b_lo;
+	uint64_t lo_hi = a_lo * b_hi;
+	uint64_t hi_hi = a_hi * b_hi;
+	uint64_t cross = (lo_lo >> 32) + (uint32_t)hi_lo + lo_hi;
+	r.high = (hi_lo >> 32) + (cross >> 32) + hi_hi;
+	r.low = (cross << 32) | (uint32_t)lo_lo;
+#endif
+	return r;
+}
+
+static inline int
+leading_zeros64(uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __builtin_clzll(x);
+#else
+	int n = 0;
+	while( !(x & (UINT64_C(1) << 63)) ){
+		x <<= 1;
+		n++;
+	}
+	return n;
+#endif
+}
+
+static inline double
+double_from_bits(uint64_t bits)
+{
+	double d;
+	memcpy(&d, &bits, sizeof(d));
+	return d;
+}
+
+/*
+ * Compute the double nearest to w * 10^q by the Eisel-Lemire algorithm.
+ * w must not be zero and must not be truncated.
+ * Returns 0 for results which are subnormal or underflow to zero, so that the caller falls back to strtod.
+ */
+static int
+eisel_lemire(uint64_t w, int q, int neg, double *out)
+{
+	t_uint128 product;
+	int lz, upperbit, shift, power2;
+	uint64_t mantissa;
+	long index;
+
+	if( q < RBPG_SMALLEST_POWER_OF_FIVE ){
+		/* Underflow to zero */
+		return 0;
+	}
+	if( q > RBPG_LARGEST_POWER_OF_FIVE ){
+		*out = neg ? -HUGE_VAL : HUGE_VAL;
+		return 1;
+	}
+
+	lz = leading_zeros64(w);
+	w <<= lz;
+
+	index = 2 * (long)(q - RBPG_SMALLEST_POWER_OF_FIVE);
+	product = full_multiplication(w, rbpg_power_of_five_128[index]);
+	/* The lower 9 bits of the 55 bits needed for the mantissa and the rounding are all set,
+	 * so that the product could be off by one. Use the lower half of the 128 bit power. */
+	if( (product.high & 0x1FF) == 0x1FF ){
+		t_uint128 second = full_multiplication(w, rbpg_power_of_five_128[index + 1]);
+		product.low += second.high;
+		if( second.high > product.low ) product.high++;
+		if( product.low == UINT64_MAX && (product.high & 0x1FF) == 0x1FF ) return 0;
+	}
+
+	upperbit = (int)(product.high >> 63);
+	shift = upperbit + 64 - 52 - 3;
+	mantissa = product.high >> shift;
+	/* power(q) = floor(q * log2(10)) + 63 and the IEEE bias */
+	power2 = (int)((((152170 + 65536) * (int64_t)q) >> 16) + 63) + upperbit - lz + 1023;
+	if( power2 <= 0 ) return 0;
+
+	/* The value is exactly in the middle between two doubles: round to even */
+	if( product.low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 ){
+		if( (mantissa << shift) == product.high ) mantissa &= ~UINT64_C(1);
+	}
+	mantissa += mantissa & 1;
+	mantissa >>= 1;
+	if( mantissa >= (UINT64_C(2) << 52) ){
+		mantissa = UINT64_C(1) << 52;
+		power2++;
+	}
+	mantissa &= ~(UINT64_C(1) << 52);
+
+	if( power2 >= 0x7FF ){
+		*out = neg ? -HUGE_VAL : HUGE_VAL;
+		return 1;
+	}
+	*out = double_from_bits(mantissa | ((uint64_t)power2 << 52) | ((uint64_t)neg << 63));
+	return 1;
+}
+
+/*
+ * Parse a decimal floating point number in the memory range from _s_ to _end_.
+ *
+ * The accepted format is an optional sign, digits with an optional decimal point and an optional exponent.
+ * Returns 1 and stores the nearest double in _out_ if the whole range was parsed.
+ * Returns 0 for other notations, for numbers with more than 19 significant digits
+ * and for non-zero numbers which are subnormal or underflow to zero as double,
+ * so that the caller can fall back to rb_cstr_to_dbl().
+ */
+int
+rbpg_parse_double(const char *s, const char *end, double *out)
+{
+	uint64_t w = 0;
+	int neg = 0;
+	int ndigits = 0;
+	int any_digit = 0;
+	long exp10 = 0;
+
+	if( s < end && (*s == '-' || *s == '+') ){
+		neg = *s == '-';
+		s++;
+	}
+	/* Leading zeros are not significant */
+	while( s < end && *s == '0' ){
+		s++;
+		any_digit = 1;
+	}
+	for( ; s < end && (unsigned char)(*s - '0') <= 9; s++ ){
+		if( ++ndigits > 19 ) return 0;
+		w = w * 10 + (*s - '0');
+		any_digit = 1;
+	}
+	if( s < end && *s == '.' ){
+		s++;
+		if( w == 0 ){
+			/* 0.000123 */
+			while( s < end && *s == '0' ){
+				s++;
+				exp10--;
+				any_digit = 1;
+			}
+		}
+		for( ; s < end && (unsigned char)(*s - '0') <= 9; s++ ){
+			if( ++ndigits > 19 ) return 0;
+			w = w * 10 + (*s - '0');
+			exp10--;
+			any_digit = 1;
+		}
+	}
+	if( !any_digit ) return 0;
+
+	if( s < end && (*s == 'e' || *s == 'E') ){
+		int exp_neg = 0;
+		long e = 0;
+		s++;
+		if( s < end && (*s == '-' || *s == '+') ){
+			exp_neg = *s == '-';
+			s++;
+		}
+		if( s >= end ) return 0;
+		for( ; s < end && (unsigned char)(*s - '0') <= 9; s++ ){
+			if( e < 100000 ) e = e * 10 + (*s - '0');
+		}
+		exp10 += exp_neg ? -e : e;
+	}
+	if( s != end ) return 0;
+
+	if( w == 0 ){
+		*out = neg ? -0.0 : 0.0;
+		return 1;
+	}
+
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+	/* Clinger's fast path: both w and 10^exp10 are exact doubles, so that a single rounding is done */
+	if( exp10 >= -22 && exp10 <= 22 && w <= (UINT64_C(1) << 53) ){
+		static const double powers_of_ten[] = {
+			1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
+		double d = (double)w;
+		d = exp10 < 0 ? d / powers_of_ten[-exp10] : d * powers_of_ten[exp10];
+		*out = neg ? -d : d;
+		return 1;
+	}
+#endif
+
+	return eisel_lemire(w, (int)(exp10 < -100000 ? -100000 : exp10 > 100000 ? 100000 : exp10), neg, out);
+}
+
+
+/* ceil(log2(5^e)) for 0 <= e <= 3528 */
+static inline int
+pow5bits(int e)
+{
+	return (int)((((uint32_t)e * 1217359) >> 19) + 1);
+}
+
+/* floor(log10(2^e)) for 0 <= e <= 1650 */
+static inline int
+log10_pow2(int e)
+{
+	return (int)(((uint32_t)e * 78913) >> 18);
+}
+
+/* floor(log10(5^e)) for 0 <= e <= 2620 */
+static inline int
+log10_pow5(int e)
+{
+	return (int)(((uint32_t)e * 732923) >> 20);
+}
+
+static inline int
+pow5_factor(uint64_t value)
+{
+	int count = 0;
+	while( value % 5 == 0 ){
+		value /= 5;
+		count++;
+	}
+	return count;
+}
+
+static inline int
+multiple_of_pow5(uint64_t value, int p)
+{
+	return pow5_factor(value) >= p;
+}
+
+static inline int
+multiple_of_pow2(uint64_t value, int p)
+{
+	return (value & ((UINT64_C(1) << p) - 1)) == 0;
+}
+
+/* (m * mul) >> j with a 128 bit multiplicator and 64 <= j */
+static inline uint64_t
+mul_shift64(uint64_t m, const uint64_t *mul, int j)
+{
+	t_uint128 b0 = full_multiplication(m, mul[0]);
+	t_uint128 b2 = full_multiplication(m, mul[1]);
+	uint64_t low = b0.high + b2.low;
+	uint64_t high = b2.high + (low < b0.high);
+	j -= 64;
+	return j == 0 ? low : (high << (64 - j)) | (low >> j);
+}
+
+/*
+ * Write the shortest decimal digits of the positive finite double _d_ that read back to the same value.
+ * The digits are written to _digits_ (at most 17 bytes) and the decimal exponent is stored in _exp10_,
+ * so that d == digits * 10^exp10.
+ * Returns the number of digits.
+ */
+int
+rbpg_dtoa_shortest(double d, char *digits, int *exp10)
+{
+	uint64_t bits, ieee_mantissa, m2, mv, vr, vp, vm, output;
+	int ieee_exponent, e2, e10, removed = 0, mm_shift, accept_bounds;
+	int vm_trailing_zeros = 0, vr_trailing_zeros = 0;
+	int last_removed_digit = 0;
+	int len, i;
+
+	memcpy(&bits, &d, sizeof(bits));
+	ieee_mantissa = bits & ((UINT64_C(1) << 52) - 1);
+	ieee_exponent = (int)((bits >> 52) & 0x7FF);
+
+	if( ieee_exponent == 0 ){
+		e2 = 1 - 1023 - 52 - 2;
+		m2 = ieee_mantissa;
+	} else {
+		e2 = ieee_exponent - 1023 - 52 - 2;
+		m2 = (UINT64_C(1) << 52) | ieee_mantissa;
+	}
+	accept_bounds = (m2 & 1) == 0;
+
+	/* The interval of values that read back to d is (vm, vp) around vr, scaled by 4 */
+	mv = 4 * m2;
+	mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+
+	if( e2 >= 0 ){
+		int q = log10_pow2(e2) - (e2 > 3);
+		int k = RBPG_POW5_INV_BITCOUNT + pow5bits(q) - 1;
+		int j = -e2 + q + k;
+		e10 = q;
+		vr = mul_shift64(4 * m2, rbpg_pow5_inv_split[q], j);
+		vp = mul_shift64(4 * m2 + 2, rbpg_pow5_inv_split[q], j);
+		vm = mul_shift64(4 * m2 - 1 - mm_shift, rbpg_pow5_inv_split[q], j);
+		if( q <= 21 ){
+			/* Only one of mp, mv, and mm can be a multiple of 5, if any */
+			if( mv % 5 == 0 ){
+				vr_trailing_zeros = multiple_of_pow5(mv, q);
+			} else if( accept_bounds ){
+				vm_trailing_zeros = multiple_of_pow5(mv - 1 - mm_shift, q);
+			} else {
+				vp -= multiple_of_pow5(mv + 2, q);
+			}
+		}
+	} else {
+		int q = log10_pow5(-e2) - (-e2 > 1);
+		int i5 = -e2 - q;
+		int k = pow5bits(i5) - RBPG_POW5_BITCOUNT;
+		int j = q - k;
+		e10 = q + e2;
+		vr = mul_shift64(4 * m2, rbpg_pow5_split[i5], j);
+		vp = mul_shift64(4 * m2 + 2, rbpg_pow5_split[i5], j);
+		vm = mul_shift64(4 * m2 - 1 - mm_shift, rbpg_pow5_split[i5], j);
+		if( q <= 1 ){
+			/* mv has at least q trailing 0 bits, so that vr has at least q trailing zeros */
+			vr_trailing_zeros = 1;
+			if( accept_bounds ){
+				vm_trailing_zeros = mm_shift == 1;
+			} else {
+				--vp;
+			}
+		} else if( q < 63 ){
+			vr_trailing_zeros = multiple_of_pow2(mv, q);
+		}
+	}
+
+	/* Remove digits as long as the interval contains a shorter number */
+	if( vm_trailing_zeros || vr_trailing_zeros ){
+		for(;;){
+			uint64_t vp_div10 = vp / 10;
+			uint64_t vm_div10 = vm / 10;
+			int vm_mod10, vr_mod10;
+			if( vp_div10 <= vm_div10 ) break;
+			vm_mod10 = (int)(vm % 10);
+			vr_mod10 = (int)(vr % 10);
+			vm_trailing_zeros &= vm_mod10 == 0;
+			vr_trailing_zeros &= last_removed_digit == 0;
+			last_removed_digit = vr_mod10;
+			vr /= 10;
+			vp = vp_div10;
+			vm = vm_div10;
+			removed++;
+		}
+		if( vm_trailing_zeros ){
+			while( vm % 10 == 0 ){
+				vr_trailing_zeros &= last_removed_digit == 0;
+				last_removed_digit = (int)(vr % 10);
+				vr /= 10;
+				vp /= 10;
+				vm /= 10;
+				removed++;
+			}
+		}
+		if( vr_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0 ){
+			/* Round even if the exact number is .....50..0 */
+			last_removed_digit = 4;
+		}
+		output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) || last_removed_digit >= 5);
+	} else {
+		/* Common case: vm and vr have no trailing zeros */
+		int round_up = 0;
+		if( vp / 100 > vm / 100 ){
+			round_up = vr % 100 >= 50;
+			vr /= 100;
+			vp /= 100;
+			vm /= 100;
+			removed += 2;
+		}
+		while( vp / 10 > vm / 10 ){
+			round_up = vr % 10 >= 5;
+			vr /= 10;
+			vp /= 10;
+			vm /= 10;
+			removed++;
+		}
+		output = vr + (vr == vm || round_up);
+	}
+
+	/* Strip trailing zeros of exact powers of ten */
+	while( output >= 10 && output % 10 == 0 ){
+		output /= 10;
+		removed++;
+	}
+
+	/* Write the digits from right to left */
+	len = 1;
+	{
+		uint64_t o = output;
+		while( o >= 10 ){
+			o /= 10;
+			len++;
+		}
+	}
+	for( i = len - 1; i >= 0; i-- ){
+		digits[i] = (char)('0' + output % 10);
+		output /= 10;
+	}
+	*exp10 = e10 + removed;
+	return len;
+}
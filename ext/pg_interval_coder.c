@@ -0,0 +1,571 @@
+/*
+ * pg_interval_coder.c - PG::TextDecoder::Interval, PG::TextEncoder::Interval and their binary variants
+ *
+ */
+
+/*
+ *
+ * Type casts between PostgreSQL interval values and Ruby objects.
+ *
+ * An interval consists of months, days and microseconds, which are kept separately by PostgreSQL,
+ * since the length of a month and of a day varies.
+ * The decoders return the triple <tt>[months, days, microseconds]</tt> or the number of seconds as Float.
+ * The encoders accept the triple or Numeric seconds.
+ *
+ * The binary format is a 64 bit microseconds value followed by 32 bit days and 32 bit months.
+ * The text decoder reads the interval styles +postgres+, +postgres_verbose+ and +iso_8601+.
+ * Values of other styles are returned as String.
+ *
+ */
+
+#include "pg.h"
+#include "pg_util.h"
+#include <string.h>
+#include <math.h>
+
+#define USECS_PER_SEC   INT64_C(1000000)
+#define USECS_PER_MINUTE (INT64_C(60) * USECS_PER_SEC)
+#define USECS_PER_HOUR  (INT64_C(3600) * USECS_PER_SEC)
+#define SECS_PER_DAY    INT64_C(86400)
+#define MONTHS_PER_YEAR 12
+/* Per EXTRACT(epoch FROM interval) a year has 365.25 days and a remaining month has 30 days */
+#define SECS_PER_YEAR   INT64_C(31557600)
+#define SECS_PER_MONTH  (INT64_C(30) * SECS_PER_DAY)
+
+/* All fields of an infinite interval are set to the maximum or minimum value */
+#define PG_INT32_MIN    (-0x7FFFFFFF-1)
+#define PG_INT32_MAX    (0x7FFFFFFF)
+#define PG_INT64_MIN    (-INT64_C(0x7FFFFFFFFFFFFFFF) - 1)
+#define PG_INT64_MAX    INT64_C(0x7FFFFFFFFFFFFFFF)
+
+/* Largest number of hours and minutes that fits into the microseconds field */
+#define MAX_INTERVAL_HOURS (PG_INT64_MAX / USECS_PER_HOUR)
+#define MAX_INTERVAL_MINUTES (PG_INT64_MAX / USECS_PER_MINUTE)
+/* Limit of the summands of the months and days fields, so that no int64_t overflow can happen before the range check */
+#define MAX_INTERVAL_FIELD (INT64_C(1) << 40)
+
+typedef struct {
+	int64_t months;
+	int64_t days;
+	int64_t usecs;
+} t_interval;
+
+static VALUE s_str_infinity;
+static VALUE s_str_minus_infinity;
+static ID s_id_mul;
+static ID s_id_round;
+
+
+/*
+ * Parse an optionally signed integer.
+ * Returns the position behind the digits or NULL if there is no number or it's too big.
+ */
+static const char *
+interval_parse_int(const char *p, const char *end, int64_t *out)
+{
+	int neg = 0;
+	uint64_t v = 0;
+	const char *start;
+
+	if( p < end && (*p == '-' || *p == '+') ){
+		neg = *p == '-';
+		p++;
+	}
+	start = p;
+	for( ; p < end && (unsigned char)(*p - '0') <= 9; p++ ){
+		if( v >= UINT64_C(100000000000000000) ) return NULL;
+		v = v * 10 + (*p - '0');
+	}
+	if( p == start ) return NULL;
+	*out = neg ? -(int64_t)v : (int64_t)v;
+	return p;
+}
+
+/*
+ * Parse the decimal point and fractional digits to microseconds.
+ * Digits behind the 6th are ignored.
+ */
+static const char *
+interval_parse_frac(const char *p, const char *end, int64_t *usecs)
+{
+	int64_t f = 0;
+	int i = 0;
+
+	*usecs = 0;
+	if( p >= end || *p != '.' ) return p;
+	for( p++; p < end && (unsigned char)(*p - '0') <= 9; p++, i++ ){
+		if( i < 6 ) f = f * 10 + (*p - '0');
+	}
+	for( ; i < 6; i++ ) f *= 10;
+	*usecs = f;
+	return p;
+}
+
+/*
+ * Parse ":NN" with exactly two digits below 60.
+ */
+static const char *
+interval_parse_2digits(const char *p, const char *end, int64_t *out)
+{
+	if( end - p < 3 || p[0] != ':' || (unsigned char)(p[1] - '0') > 5 || (unsigned char)(p[2] - '0') > 9 ) return NULL;
+	*out = (p[1] - '0') * 10 + (p[2] - '0');
+	return p + 3;
+}
+
+/*
+ * Add to the fields of the interval and check the range.
+ * The summands of months and days are limited by the callers, so that there's no overflow.
+ * The microseconds are checked against the whole int64_t range like the binary format allows.
+ */
+static int
+interval_add(t_interval *iv, int64_t months, int64_t days, int64_t usecs)
+{
+	if( usecs > 0 ? iv->usecs > PG_INT64_MAX - usecs : iv->usecs < PG_INT64_MIN - usecs ) return 0;
+	iv->months += months;
+	iv->days += days;
+	iv->usecs += usecs;
+	return iv->months >= PG_INT32_MIN && iv->months <= PG_INT32_MAX &&
+			iv->days >= PG_INT32_MIN && iv->days <= PG_INT32_MAX;
+}
+
+static int
+interval_unit_is(const char *p, const char *end, const char *unit)
+{
+	size_t len = strlen(unit);
+	size_t n = end - p;
+	/* singular or plural */
+	return (n == len || (n == len + 1 && p[len] == 's')) && memcmp(p, unit, len) == 0;
+}
+
+/*
+ * Parse the interval styles postgres and postgres_verbose like
+ *   "-1 years +2 mons 3 days -04:05:06.789"
+ *   "@ 1 year 2 mons -3 days 4 hours 5 mins 6.789 secs ago"
+ */
+static int
+interval_parse_postgres(const char *p, const char *end, t_interval *iv)
+{
+	int any = 0;
+
+	if( p < end && *p == '@' ) p++;
+	while( 1 ){
+		const char *num;
+		int64_t n, frac;
+		int neg;
+
+		while( p < end && *p == ' ' ) p++;
+		if( p == end ) break;
+		if( any && end - p == 3 && memcmp(p, "ago", 3) == 0 ){
+			if( iv->months == PG_INT32_MIN || iv->days == PG_INT32_MIN || iv->usecs == PG_INT64_MIN ) return 0;
+			iv->months = -iv->months;
+			iv->days = -iv->days;
+			iv->usecs = -iv->usecs;
+			break;
+		}
+
+		num = p;
+		neg = *num == '-';
+		p = interval_parse_int(p, end, &n);
+		if( !p ) return 0;
+
+		if( p < end && *p == ':' ){
+			/* time field [-]HH:MM:SS[.ffffff] */
+			int64_t minutes, seconds;
+			uint64_t usecs;
+
+			p = interval_parse_2digits(p, end, &minutes);
+			if( !p ) return 0;
+			seconds = 0;
+			if( p < end && *p == ':' ){
+				p = interval_parse_2digits(p, end, &seconds);
+				if( !p ) return 0;
+			}
+			p = interval_parse_frac(p, end, &frac);
+			if( n < 0 ) n = -n;
+			if( n > MAX_INTERVAL_HOURS ) return 0;
+			/* Unsigned, since the time of the smallest interval is one more than INT64_MAX */
+			usecs = (uint64_t)n * USECS_PER_HOUR + minutes * USECS_PER_MINUTE + seconds * USECS_PER_SEC + frac;
+			if( usecs > (uint64_t)PG_INT64_MAX + neg ) return 0;
+			if( !interval_add(iv, 0, 0, neg ? (int64_t)(0 - usecs) : (int64_t)usecs) ) return 0;
+		} else if( p == end && !any && n == 0 ){
+			/* zero interval "@ 0" of postgres_verbose style */
+		} else {
+			const char *unit;
+
+			p = interval_parse_frac(p, end, &frac);
+			if( p >= end || *p != ' ' ) return 0;
+			unit = ++p;
+			while( p < end && *p != ' ' ) p++;
+
+			if( n > MAX_INTERVAL_FIELD || n < -MAX_INTERVAL_FIELD ) return 0;
+			if( frac != 0 && !interval_unit_is(unit, p, "sec") ) return 0;
+
+			if( interval_unit_is(unit, p, "year") ){
+				if( !interval_add(iv, n * MONTHS_PER_YEAR, 0, 0) ) return 0;
+			} else if( interval_unit_is(unit, p, "mon") ){
+				if( !interval_add(iv, n, 0, 0) ) return 0;
+			} else if( interval_unit_is(unit, p, "day") ){
+				if( !interval_add(iv, 0, n, 0) ) return 0;
+			} else if( interval_unit_is(unit, p, "hour") ){
+				if( n > MAX_INTERVAL_HOURS || n < -MAX_INTERVAL_HOURS ) return 0;
+				if( !interval_add(iv, 0, 0, n * USECS_PER_HOUR) ) return 0;
+			} else if( interval_unit_is(unit, p, "min") ){
+				if( n > MAX_INTERVAL_MINUTES || n < -MAX_INTERVAL_MINUTES ) return 0;
+				if( !interval_add(iv, 0, 0, n * USECS_PER_MINUTE) ) return 0;
+			} else if( interval_unit_is(unit, p, "sec") ){
+				if( !interval_add(iv, 0, 0, n * USECS_PER_SEC + (neg ? -frac : frac)) ) return 0;
+			} else {
+				return 0;
+			}
+		}
+		any = 1;
+	}
+	return any;
+}
+
+/*
+ * Parse the interval style iso_8601 like
+ *   "P-1Y2M3DT-4H5M6.789S"
+ */
+static int
+interval_parse_iso8601(const char *p, const char *end, t_interval *iv)
+{
+	int in_time = 0;
+
+	if( end - p < 3 || *p != 'P' ) return 0;
+	for( p++; p < end; ){
+		const char *num;
+		int64_t n, frac;
+
+		if( *p == 'T' && !in_time ){
+			in_time = 1;
+			p++;
+			continue;
+		}
+		num = p;
+		p = interval_parse_int(p, end, &n);
+		if( !p ) return 0;
+		p = interval_parse_frac(p, end, &frac);
+		if( p >= end ) return 0;
+		if( n > MAX_INTERVAL_FIELD || n < -MAX_INTERVAL_FIELD ) return 0;
+		/* PostgreSQL writes fractions for seconds only */
+		if( frac != 0 && !(in_time && *p == 'S') ) return 0;
+
+		switch( in_time ? *p | 0x100 : *p ){
+			case 'Y':
+				if( !interval_add(iv, n * MONTHS_PER_YEAR, 0, 0) ) return 0;
+				break;
+			case 'M':
+				if( !interval_add(iv, n, 0, 0) ) return 0;
+				break;
+			case 'W':
+				if( !interval_add(iv, 0, n * 7, 0) ) return 0;
+				break;
+			case 'D':
+				if( !interval_add(iv, 0, n, 0) ) return 0;
+				break;
+			case 'H' | 0x100:
+				if( n > MAX_INTERVAL_HOURS || n < -MAX_INTERVAL_HOURS ) return 0;
+				if( !interval_add(iv, 0, 0, n * USECS_PER_HOUR) ) return 0;
+				break;
+			case 'M' | 0x100:
+				if( n > MAX_INTERVAL_MINUTES || n < -MAX_INTERVAL_MINUTES ) return 0;
+				if( !interval_add(iv, 0, 0, n * USECS_PER_MINUTE) ) return 0;
+				break;
+			case 'S' | 0x100:
+				if( !interval_add(iv, 0, 0, n * USECS_PER_SEC + (*num == '-' ? -frac : frac)) ) return 0;
+				break;
+			default:
+				return 0;
+		}
+		p++;
+	}
+	return 1;
+}
+
+static VALUE
+interval_to_ruby(t_pg_coder *conv, int32_t months, int32_t days, int64_t usecs)
+{
+	if( conv->flags & PG_CODER_INTERVAL_TO_SECONDS ){
+		int64_t secs = SECS_PER_YEAR * (months / MONTHS_PER_YEAR) + SECS_PER_MONTH * (months % MONTHS_PER_YEAR) + SECS_PER_DAY * days;
+		return rb_float_new( (double)secs + (double)usecs / USECS_PER_SEC );
+	}
+	return rb_ary_new3( 3, INT2NUM(months), INT2NUM(days), LL2NUM(usecs) );
+}
+
+static VALUE
+interval_infinity(t_pg_coder *conv, int neg)
+{
+	if( conv->flags & PG_CODER_INTERVAL_TO_SECONDS ){
+		return rb_float_new( neg ? -HUGE_VAL : HUGE_VAL );
+	}
+	return rb_str_new_cstr( neg ? "-infinity" : "infinity" );
+}
+
+/*
+ * Document-class: PG::TextDecoder::Interval < PG::SimpleDecoder
+ *
+ * This is a decoder class for conversion of PostgreSQL interval values
+ * to the Array <tt>[months, days, microseconds]</tt> of Integers.
+ *
+ * The following flag can be used to get a different representation:
+ * * +PG::Coder::INTERVAL_TO_SECONDS+ : Return the number of seconds as Float.
+ *   Like <tt>EXTRACT(epoch FROM interval)</tt> a year is counted as 365.25 days,
+ *   a remaining month as 30 days and a day as 24 hours.
+ *
+ * The flag can be set per #to_seconds= as well.
+ *
+ * The interval styles +postgres+ (default), +postgres_verbose+ and +iso_8601+ are supported.
+ * Values in +sql_standard+ style are returned as String.
+ * The infinite intervals of PostgreSQL-17+ are returned as String "infinity" and "-infinity"
+ * or as Float::INFINITY in seconds mode.
+ *
+ * Example:
+ *   deco = PG::TextDecoder::Interval.new
+ *   deco.decode("1 year 2 mons -3 days +04:05:06.5")  # => [14, -3, 14706500000]
+ *   deco = PG::TextDecoder::Interval.new(to_seconds: true)
+ *   deco.decode("1 day 00:00:01.5")                   # => 86401.5
+ *
+ */
+static VALUE
+pg_text_dec_interval(t_pg_coder *conv, const char *val, int len, int tuple, int field, int enc_idx)
+{
+	t_interval iv = { 0, 0, 0 };
+	const char *end = val + len;
+
+	if( len == 8 && memcmp(val, "infinity", 8) == 0 ) return interval_infinity(conv, 0);
+	if( len == 9 && memcmp(val, "-infinity", 9) == 0 ) return interval_infinity(conv, 1);
+
+	if( (len > 0 && val[0] == 'P') ? interval_parse_iso8601(val, end, &iv) : interval_parse_postgres(val, end, &iv) ){
+		return interval_to_ruby(conv, (int32_t)iv.months, (int32_t)iv.days, iv.usecs);
+	}
+	return pg_text_dec_string(conv, val, len, tuple, field, enc_idx);
+}
+
+/*
+ * Document-class: PG::BinaryDecoder::Interval < PG::SimpleDecoder
+ *
+ * This is a decoder class for conversion of PostgreSQL binary interval values
+ * to the Array <tt>[months, days, microseconds]</tt> of Integers.
+ *
+ * The same flag as with PG::TextDecoder::Interval can be used.
+ *
+ */
+static VALUE
+pg_bin_dec_interval(t_pg_coder *conv, const char *val, int len, int tuple, int field, int enc_idx)
+{
+	int64_t usecs;
+	int32_t days, months;
+
+	if( len != 16 ){
+		rb_raise( rb_eTypeError, "wrong data for binary interval converter in tuple %d field %d", tuple, field);
+	}
+	usecs = read_nbo64(val);
+	days = read_nbo32(val + 8);
+	months = read_nbo32(val + 12);
+
+	if( months == PG_INT32_MAX && days == PG_INT32_MAX && usecs == PG_INT64_MAX ) return interval_infinity(conv, 0);
+	if( months == PG_INT32_MIN && days == PG_INT32_MIN && usecs == PG_INT64_MIN ) return interval_infinity(conv, 1);
+	return interval_to_ruby(conv, months, days, usecs);
+}
+
+
+/*
+ * Convert the value given to an encoder into months, days and microseconds.
+ * Returns 1 for +infinity, -1 for -infinity and 0 for finite values.
+ */
+static int
+interval_from_value(VALUE value, t_interval *iv)
+{
+	iv->months = iv->days = iv->usecs = 0;
+
+	if( RB_TYPE_P(value, T_ARRAY) ){
+		if( RARRAY_LEN(value) != 3 ){
+			rb_raise( rb_eArgError, "interval Array must have 3 elements [months, days, microseconds] but has %ld", RARRAY_LEN(value) );
+		}
+		iv->months = NUM2INT(rb_ary_entry(value, 0));
+		iv->days = NUM2INT(rb_ary_entry(value, 1));
+		iv->usecs = NUM2LL(rb_ary_entry(value, 2));
+	} else if( RB_FLOAT_TYPE_P(value) ){
+		double d = RFLOAT_VALUE(value);
+		if( isinf(d) ) return d < 0 ? -1 : 1;
+		d = round(d * USECS_PER_SEC);
+		if( !(d > -9.2e18 && d < 9.2e18) ){
+			rb_raise( rb_eRangeError, "interval out of range: %+"PRIsVALUE, value );
+		}
+		iv->usecs = (int64_t)d;
+	} else if( RB_INTEGER_TYPE_P(value) ){
+		LONG_LONG secs = NUM2LL(value);
+		if( secs > PG_INT64_MAX / USECS_PER_SEC || secs < PG_INT64_MIN / USECS_PER_SEC ){
+			rb_raise( rb_eRangeError, "interval out of range: %+"PRIsVALUE, value );
+		}
+		iv->usecs = secs * USECS_PER_SEC;
+	} else if( rb_obj_is_kind_of(value, rb_cNumeric) ){
+		/* Rational, BigDecimal, ... */
+		iv->usecs = NUM2LL(rb_funcall(rb_funcall(value, s_id_mul, 1, LL2NUM(USECS_PER_SEC)), s_id_round, 0));
+	} else {
+		rb_raise( rb_eTypeError, "wrong data for interval encoder: %+"PRIsVALUE" (expected [months, days, microseconds] or Numeric seconds)", value );
+	}
+
+	/* The infinity sentinels of the binary format are sent as infinity.
+	 * Otherwise the server rejects the smallest microseconds value. */
+	if( iv->months == PG_INT32_MAX && iv->days == PG_INT32_MAX && iv->usecs == PG_INT64_MAX ) return 1;
+	if( iv->usecs == PG_INT64_MIN ){
+		if( iv->months == PG_INT32_MIN && iv->days == PG_INT32_MIN ) return -1;
+		rb_raise( rb_eRangeError, "interval out of range: %+"PRIsVALUE, value );
+	}
+	return 0;
+}
+
+/* Numeric values other than Integer and Float are converted to the Array form in the first encoder pass */
+static VALUE
+interval_intermediate(VALUE value, t_interval *iv)
+{
+	if( RB_TYPE_P(value, T_ARRAY) || RB_FLOAT_TYPE_P(value) || RB_INTEGER_TYPE_P(value) ){
+		return value;
+	}
+	return rb_ary_new3( 3, INT2NUM(0), INT2NUM(0), LL2NUM(iv->usecs) );
+}
+
+/*
+ * Document-class: PG::TextEncoder::Interval < PG::SimpleEncoder
+ *
+ * This is the encoder class for the PostgreSQL interval type.
+ *
+ * It accepts the Array <tt>[months, days, microseconds]</tt> of Integers and Numeric seconds.
+ * Float::INFINITY and the infinity triples of PG::BinaryDecoder::Interval are sent as +infinity+ .
+ * A value of -2**63 microseconds is not accepted by the server otherwise and raises a RangeError.
+ * Strings are sent unchanged.
+ *
+ */
+static int
+pg_text_enc_interval(t_pg_coder *conv, VALUE value, char *out, VALUE *intermediate, int enc_idx)
+{
+	t_interval iv;
+	int inf;
+
+	if(out){
+		char *start = out;
+		uint64_t usecs;
+
+		inf = interval_from_value(*intermediate, &iv);
+		if( inf ){
+			VALUE str = inf < 0 ? s_str_minus_infinity : s_str_infinity;
+			memcpy(out, RSTRING_PTR(str), RSTRING_LEN(str));
+			return (int)RSTRING_LEN(str);
+		}
+		/* All fields are signed, so that the sql_standard style doesn't apply the sign of the first field to the others */
+		out += sprintf(out, "%+d mons %+d days ", (int)iv.months, (int)iv.days);
+		*out++ = iv.usecs < 0 ? '-' : '+';
+		usecs = iv.usecs < 0 ? -(uint64_t)iv.usecs : (uint64_t)iv.usecs;
+		out += sprintf(out, "%02llu:%02d:%02d.%06d", (unsigned long long)(usecs / USECS_PER_HOUR),
+				(int)(usecs / USECS_PER_MINUTE % 60), (int)(usecs / USECS_PER_SEC % 60), (int)(usecs % USECS_PER_SEC));
+		return (int)(out - start);
+	} else {
+		if( RB_TYPE_P(value, T_STRING) ){
+			return pg_coder_enc_to_s(conv, value, NULL, intermediate, enc_idx);
+		}
+		interval_from_value(value, &iv);
+		*intermediate = interval_intermediate(value, &iv);
+		/* "-2147483648 mons -2147483648 days -2562047788:00:54.775807" */
+		return 64;
+	}
+}
+
+/*
+ * Document-class: PG::BinaryEncoder::Interval < PG::SimpleEncoder
+ *
+ * This is the binary encoder class for the PostgreSQL interval type.
+ *
+ * It accepts the Array <tt>[months, days, microseconds]</tt> of Integers and Numeric seconds.
+ * Float::INFINITY is sent as +infinity+ which requires PostgreSQL-17+.
+ *
+ */
+static int
+pg_bin_enc_interval(t_pg_coder *conv, VALUE value, char *out, VALUE *intermediate, int enc_idx)
+{
+	t_interval iv;
+
+	if(out){
+		int inf = interval_from_value(*intermediate, &iv);
+		if( inf ){
+			write_nbo64(inf < 0 ? PG_INT64_MIN : PG_INT64_MAX, out);
+			write_nbo32(inf < 0 ? PG_INT32_MIN : PG_INT32_MAX, out + 8);
+			write_nbo32(inf < 0 ? PG_INT32_MIN : PG_INT32_MAX, out + 12);
+		} else {
+			write_nbo64(iv.usecs, out);
+			write_nbo32(iv.days, out + 8);
+			write_nbo32(iv.months, out + 12);
+		}
+	} else {
+		interval_from_value(value, &iv);
+		*intermediate = interval_intermediate(value, &iv);
+	}
+	return 16;
+}
+
+static void
+interval_init_common(void)
+{
+	if( !s_str_infinity ){
+		rb_gc_register_address(&s_str_infinity);
+		rb_gc_register_address(&s_str_minus_infinity);
+		s_str_infinity = rb_str_freeze(rb_str_new_cstr("infinity"));
+		s_str_minus_infinity = rb_str_freeze(rb_str_new_cstr("-infinity"));
+		s_id_mul = rb_intern("*");
+		s_id_round = rb_intern("round");
+	}
+}
+
+/* called per autoload when TextDecoder::Interval is used */
+static VALUE
+init_pg_text_decoder_interval(VALUE rb_mPG_TextDecoder)
+{
+	/* dummy = rb_define_class_under( rb_mPG_TextDecoder, "Interval", rb_cPG_SimpleDecoder ); */
+	pg_define_coder( "Interval", pg_text_dec_interval, rb_cPG_SimpleDecoder, rb_mPG_TextDecoder );
+
+	return Qnil;
+}
+
+/* called per autoload when TextEncoder::Interval is used */
+static VALUE
+init_pg_text_encoder_interval(VALUE rb_mPG_TextEncoder)
+{
+	interval_init_common();
+
+	/* dummy = rb_define_class_under( rb_mPG_TextEncoder, "Interval", rb_cPG_SimpleEncoder ); */
+	pg_define_coder( "Interval", pg_text_enc_interval, rb_cPG_SimpleEncoder, rb_mPG_TextEncoder );
+
+	return Qnil;
+}
+
+/* called per autoload when BinaryDecoder::Interval is used */
+static VALUE
+init_pg_bin_decoder_interval(VALUE rb_mPG_BinaryDecoder)
+{
+	/* dummy = rb_define_class_under( rb_mPG_BinaryDecoder, "Interval", rb_cPG_SimpleDecoder ); */
+	pg_define_coder( "Interval", pg_bin_dec_interval, rb_cPG_SimpleDecoder, rb_mPG_BinaryDecoder );
+
+	return Qnil;
+}
+
+/* called per autoload when BinaryEncoder::Interval is used */
+static VALUE
+init_pg_bin_encoder_interval(VALUE rb_mPG_BinaryEncoder)
+{
+	interval_init_common();
+
+	/* dummy = rb_define_class_under( rb_mPG_BinaryEncoder, "Interval", rb_cPG_SimpleEncoder ); */
+	pg_define_coder( "Interval", pg_bin_enc_interval, rb_cPG_SimpleEncoder, rb_mPG_BinaryEncoder );
+
+	return Qnil;
+}
+
+void
+init_pg_intervalcoder(void)
+{
+	rb_define_private_method(rb_singleton_class(rb_mPG_TextDecoder), "init_interval", init_pg_text_decoder_interval, 0);
+	rb_define_private_method(rb_singleton_class(rb_mPG_TextEncoder), "init_interval", init_pg_text_encoder_interval, 0);
+	rb_define_private_method(rb_singleton_class(rb_mPG_BinaryDecoder), "init_interval", init_pg_bin_decoder_interval, 0);
+	rb_define_private_method(rb_singleton_class(rb_mPG_BinaryEncoder), "init_interval", init_pg_bin_encoder_interval, 0);
+}
@@ -0,0 +1,872 @@
+/*
+ * pg_json_coder.c - PG::TextDecoder::JSON, PG::TextEncoder::JSON and their binary variants
+ *
+ */
+
+/*
+ *
+ * Type casts between PostgreSQL json and jsonb values and Ruby objects.
+ *
+ * The JSON text is parsed straight from the result memory, so that the values
+ * don't need to be copied into an intermediate Ruby String first.
+ * The parser follows the behavior of ::JSON.parse of the ruby standard library
+ * and raises ::JSON::ParserError on invalid input.
+ *
+ * The encoder writes Hash, Array, String, Symbol, Integer, Float, true, false and nil
+ * directly into the buffer of the caller per the two-pass encoder protocol.
+ * All other objects are passed to ::JSON.generate , so that the result equals to it.
+ *
+ * The binary format of json is the JSON text and the binary format of jsonb is
+ * a version byte followed by the JSON text.
+ *
+ */
+
+#include "pg.h"
+#include "pg_util.h"
+#include "ruby/util.h"
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include <float.h>
+
+/* JSON nesting depth of ::JSON.parse */
+#define PG_JSON_MAX_NESTING 100
+
+static VALUE s_cJSON_ParserError;
+static VALUE s_cJSON_NestingError;
+static VALUE s_mJSON;
+static ID s_id_BigDecimal;
+static ID s_id_generate;
+
+typedef struct {
+	const char *start;
+	const char *p;
+	const char *end;
+	int enc_idx;
+	rb_encoding *enc;
+	int flags;
+	int depth;
+	/* Ruby Array used as stack for the elements of all open arrays and objects */
+	VALUE stack;
+} t_json_parser;
+
+static VALUE json_parse_value( t_json_parser *jp );
+
+static void
+json_raise_unexpected( t_json_parser *jp )
+{
+	long rest = jp->end - jp->p;
+	rb_raise( s_cJSON_ParserError, "unexpected token at '%.*s'", (int)(rest > 32 ? 32 : rest), jp->p );
+}
+
+static inline void
+json_skip_ws( t_json_parser *jp )
+{
+	while( jp->p < jp->end && (*jp->p == ' ' || *jp->p == '\n' || *jp->p == '\t' || *jp->p == '\r') ){
+		jp->p++;
+	}
+}
+
+static VALUE
+json_new_string( t_json_parser *jp, const char *ptr, long len, int is_key )
+{
+	if( is_key || (jp->flags & PG_CODER_JSON_DEEP_FREEZE) ){
+		/* Hash keys are deduplicated by ruby anyway, but without allocating an intermediate String here */
+#ifdef HAVE_RB_ENC_INTERNED_STR
+		VALUE str = rb_enc_interned_str( ptr, len, jp->enc );
+#else
+		VALUE str = rb_funcall( rb_enc_str_new(ptr, len, jp->enc), rb_intern("-@"), 0 );
+#endif
+		if( is_key && (jp->flags & PG_CODER_JSON_SYMBOLIZE_NAMES) ){
+			return rb_str_intern( str );
+		}
+		return str;
+	}
+	return rb_enc_str_new( ptr, len, jp->enc );
+}
+
+static int
+json_hex4( const char *p )
+{
+	int i, v = 0;
+	for( i=0; i<4; i++ ){
+		char c = p[i];
+		v <<= 4;
+		if( c >= '0' && c <= '9' ) v |= c - '0';
+		else if( c >= 'a' && c <= 'f' ) v |= c - 'a' + 10;
+		else if( c >= 'A' && c <= 'F' ) v |= c - 'A' + 10;
+		else return -1;
+	}
+	return v;
+}
+
+static char *
+json_write_utf8( char *out, unsigned long cp )
+{
+	if( cp < 0x80 ){
+		*out++ = (char)cp;
+	} else if( cp < 0x800 ){
+		*out++ = (char)(0xc0 | (cp >> 6));
+		*out++ = (char)(0x80 | (cp & 0x3f));
+	} else if( cp < 0x10000 ){
+		*out++ = (char)(0xe0 | (cp >> 12));
+		*out++ = (char)(0x80 | ((cp >> 6) & 0x3f));
+		*out++ = (char)(0x80 | (cp & 0x3f));
+	} else {
+		*out++ = (char)(0xf0 | (cp >> 18));
+		*out++ = (char)(0x80 | ((cp >> 12) & 0x3f));
+		*out++ = (char)(0x80 | ((cp >> 6) & 0x3f));
+		*out++ = (char)(0x80 | (cp & 0x3f));
+	}
+	return out;
+}
+
+/*
+ * Returns nonzero if the memory range contains an ASCII control character, which must be escaped in JSON strings.
+ */
+static inline int
+json_has_ctrl_char( const char *s, const char *e )
+{
+	unsigned char bad = 0;
+	for( ; s < e; s++ ){
+		bad |= (unsigned char)*s < 0x20;
+	}
+	return bad;
+}
+
+static VALUE
+json_parse_string( t_json_parser *jp, int is_key )
+{
+	const char *s = jp->p + 1;
+	const char *q;
+	VALUE str;
+
+	/* Most strings don't contain escapes, so that the end of the string is searched in blocks. */
+	q = rbpg_find_any4( s, jp->end, '"', '\\', '"', '\\' );
+	if( q == jp->end || json_has_ctrl_char(s, q) ){
+		json_raise_unexpected( jp );
+	}
+	if( *q == '"' ){
+		jp->p = q + 1;
+		return json_new_string( jp, s, q - s, is_key );
+	}
+
+	str = rb_str_buf_new( q - s + 16 );
+	rb_str_buf_cat( str, s, q - s );
+
+	while( *q != '"' ){
+		/* *q is a backslash */
+		char buf[4];
+		char *out = buf;
+
+		if( q + 1 >= jp->end ) json_raise_unexpected( jp );
+		switch( q[1] ){
+			case 'b': *out++ = '\b'; q += 2; break;
+			case 'f': *out++ = '\f'; q += 2; break;
+			case 'n': *out++ = '\n'; q += 2; break;
+			case 'r': *out++ = '\r'; q += 2; break;
+			case 't': *out++ = '\t'; q += 2; break;
+			case 'u': {
+				long cp;
+				if( jp->end - q < 6 || (cp = json_hex4(q + 2)) < 0 ) json_raise_unexpected( jp );
+				q += 6;
+				if( cp >= 0xd800 && cp <= 0xdbff ){
+					long lo;
+					if( jp->end - q < 6 || q[0] != '\\' || q[1] != 'u' || (lo = json_hex4(q + 2)) < 0xdc00 || lo > 0xdfff ){
+						rb_raise( s_cJSON_ParserError, "incomplete surrogate pair at '%.*s'", (int)(jp->end - q > 26 ? 32 : jp->end - q + 6), q - 6 );
+					}
+					cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+					q += 6;
+				}
+				out = json_write_utf8( out, cp );
+				break;
+			}
+			default:
+				/* \" \\ \/ and any other escaped character is taken as is, like ::JSON.parse does */
+				*out++ = q[1];
+				q += 2;
+				break;
+		}
+		rb_str_buf_cat( str, buf, out - buf );
+
+		s = q;
+		q = rbpg_find_any4( s, jp->end, '"', '\\', '"', '\\' );
+		if( q == jp->end || json_has_ctrl_char(s, q) ){
+			json_raise_unexpected( jp );
+		}
+		rb_str_buf_cat( str, s, q - s );
+	}
+
+	jp->p = q + 1;
+	rb_enc_associate_index( str, jp->enc_idx );
+	if( is_key || (jp->flags & PG_CODER_JSON_DEEP_FREEZE) ){
+		/* Dedup the decoded String */
+		return json_new_string( jp, RSTRING_PTR(str), RSTRING_LEN(str), is_key );
+	}
+	return str;
+}
+
+static VALUE
+json_parse_number( t_json_parser *jp )
+{
+	const char *s = jp->p;
+	const char *p = s;
+	const char *end = jp->end;
+	const char *digits;
+	int is_float = 0;
+
+	if( p < end && *p == '-' ) p++;
+	digits = p;
+	if( p < end && *p == '0' ){
+		p++;
+	} else {
+		while( p < end && *p >= '0' && *p <= '9' ) p++;
+	}
+	if( p == digits ) json_raise_unexpected( jp );
+
+	if( p < end && *p == '.' ){
+		const char *frac = ++p;
+		while( p < end && *p >= '0' && *p <= '9' ) p++;
+		if( p == frac ){
+			jp->p = frac - 1;
+			json_raise_unexpected( jp );
+		}
+		is_float = 1;
+	}
+	if( p < end && (*p == 'e' || *p == 'E') ){
+		const char *exp;
+		p++;
+		if( p < end && (*p == '+' || *p == '-') ) p++;
+		exp = p;
+		while( p < end && *p >= '0' && *p <= '9' ) p++;
+		if( p == exp ) json_raise_unexpected( jp );
+		is_float = 1;
+	}
+	jp->p = p;
+
+	if( !is_float ){
+		if( p - digits <= 18 ){
+			/* Fits into int64 */
+			int64_t v = 0;
+			const char *d;
+			for( d = digits; d < p; d++ ) v = v * 10 + (*d - '0');
+			return LL2NUM( *s == '-' ? -v : v );
+		}
+		return rb_str_to_inum( rb_str_new(s, p - s), 10, 0 );
+	}
+
+	if( jp->flags & PG_CODER_JSON_BIGDECIMAL ){
+		return rb_funcall( rb_cObject, s_id_BigDecimal, 1, rb_str_new(s, p - s) );
+	} else {
+		char buf[64];
+		double d;
+		if( rbpg_parse_double(s, p, &d) ){
+			return DBL2NUM( d );
+		}
+		/* The number is followed by other JSON text, which must not be read by strtod */
+		if( p - s < (long)sizeof(buf) ){
+			memcpy( buf, s, p - s );
+			buf[p - s] = 0;
+			return DBL2NUM( ruby_strtod(buf, NULL) );
+		}
+		else {
+			VALUE str = rb_str_new(s, p - s);
+			return DBL2NUM( rb_cstr_to_dbl(StringValueCStr(str), 0) );
+		}
+	}
+}
+
+static void
+json_enter( t_json_parser *jp )
+{
+	if( ++jp->depth > PG_JSON_MAX_NESTING ){
+		rb_raise( s_cJSON_NestingError, "nesting of %d is too deep", jp->depth );
+	}
+	if( NIL_P(jp->stack) ){
+		jp->stack = rb_ary_new_capa( 16 );
+	}
+}
+
+static VALUE
+json_parse_array( t_json_parser *jp )
+{
+	long base;
+	VALUE ary;
+
+	json_enter( jp );
+	base = RARRAY_LEN( jp->stack );
+	jp->p++;
+	json_skip_ws( jp );
+	if( jp->p < jp->end && *jp->p == ']' ){
+		jp->p++;
+	} else {
+		for(;;){
+			rb_ary_push( jp->stack, json_parse_value(jp) );
+			json_skip_ws( jp );
+			if( jp->p >= jp->end ) json_raise_unexpected( jp );
+			if( *jp->p == ',' ){
+				jp->p++;
+				continue;
+			}
+			if( *jp->p == ']' ){
+				jp->p++;
+				break;
+			}
+			json_raise_unexpected( jp );
+		}
+	}
+
+	ary = rb_ary_new_from_values( RARRAY_LEN(jp->stack) - base, RARRAY_CONST_PTR(jp->stack) + base );
+	rb_ary_resize( jp->stack, base );
+	jp->depth--;
+	if( jp->flags & PG_CODER_JSON_DEEP_FREEZE ) rb_obj_freeze( ary );
+	return ary;
+}
+
+static VALUE
+json_parse_object( t_json_parser *jp )
+{
+	long base, count;
+	VALUE hash;
+
+	json_enter( jp );
+	base = RARRAY_LEN( jp->stack );
+	jp->p++;
+	json_skip_ws( jp );
+	if( jp->p < jp->end && *jp->p == '}' ){
+		jp->p++;
+	} else {
+		for(;;){
+			json_skip_ws( jp );
+			if( jp->p >= jp->end || *jp->p != '"' ) json_raise_unexpected( jp );
+			rb_ary_push( jp->stack, json_parse_string(jp, 1) );
+			json_skip_ws( jp );
+			if( jp->p >= jp->end || *jp->p != ':' ) json_raise_unexpected( jp );
+			jp->p++;
+			rb_ary_push( jp->stack, json_parse_value(jp) );
+			json_skip_ws( jp );
+			if( jp->p >= jp->end ) json_raise_unexpected( jp );
+			if( *jp->p == ',' ){
+				jp->p++;
+				continue;
+			}
+			if( *jp->p == '}' ){
+				jp->p++;
+				break;
+			}
+			json_raise_unexpected( jp );
+		}
+	}
+
+	count = RARRAY_LEN(jp->stack) - base;
+#ifdef HAVE_RB_HASH_NEW_CAPA
+	hash = rb_hash_new_capa( count / 2 );
+#else
+	hash = rb_hash_new();
+#endif
+	/* Later values of duplicated keys win */
+	rb_hash_bulk_insert( count, RARRAY_CONST_PTR(jp->stack) + base, hash );
+	rb_ary_resize( jp->stack, base );
+	jp->depth--;
+	if( jp->flags & PG_CODER_JSON_DEEP_FREEZE ) rb_obj_freeze( hash );
+	return hash;
+}
+
+static int
+json_match( t_json_parser *jp, const char *word, size_t len )
+{
+	if( (size_t)(jp->end - jp->p) >= len && memcmp(jp->p, word, len) == 0 ){
+		jp->p += len;
+		return 1;
+	}
+	return 0;
+}
+
+static VALUE
+json_parse_value( t_json_parser *jp )
+{
+	json_skip_ws( jp );
+	if( jp->p >= jp->end ) json_raise_unexpected( jp );
+
+	switch( *jp->p ){
+		case '"': return json_parse_string( jp, 0 );
+		case '{': return json_parse_object( jp );
+		case '[': return json_parse_array( jp );
+		case 't': if( json_match(jp, "true", 4) ) return Qtrue; break;
+		case 'f': if( json_match(jp, "false", 5) ) return Qfalse; break;
+		case 'n': if( json_match(jp, "null", 4) ) return Qnil; break;
+		case '-':
+		case '0': case '1': case '2': case '3': case '4':
+		case '5': case '6': case '7': case '8': case '9':
+			return json_parse_number( jp );
+	}
+	json_raise_unexpected( jp );
+	return Qnil;
+}
+
+/*
+ * Document-class: PG::TextDecoder::JSON < PG::SimpleDecoder
+ *
+ * This is a decoder class for conversion of PostgreSQL JSON/JSONB type to Ruby Hash, Array, String, Numeric, nil values.
+ *
+ * The JSON text is parsed in C directly from the received data.
+ * The result equals to <tt>::JSON.parse</tt> with the given options and invalid input raises <tt>::JSON::ParserError</tt>.
+ *
+ * Options:
+ * * +symbolize_names+ : Return Hash keys as Symbols instead of Strings.
+ * * +deep_freeze+ : Freeze all returned Arrays and Hashes and return deduplicated Strings.
+ * * +decimal_class+ : Set to +BigDecimal+ to decode numbers with fraction or exponent as BigDecimal instead of Float.
+ *
+ * Hash keys are always frozen and deduplicated Strings.
+ *
+ * As soon as this class is used, it requires the ruby standard library 'json'.
+ */
+static VALUE
+pg_text_dec_json(t_pg_coder *conv, const char *val, int len, int tuple, int field, int enc_idx)
+{
+	t_json_parser jp;
+	VALUE result;
+
+	jp.start = jp.p = val;
+	jp.end = val + len;
+	jp.enc_idx = enc_idx;
+	jp.enc = rb_enc_from_index( enc_idx );
+	jp.flags = conv->flags;
+	jp.depth = 0;
+	jp.stack = Qnil;
+
+	result = json_parse_value( &jp );
+	json_skip_ws( &jp );
+	if( jp.p != jp.end ) json_raise_unexpected( &jp );
+
+	RB_GC_GUARD(jp.stack);
+	return result;
+}
+
+
+typedef struct {
+	/* NULL in the first pass, which computes the output size */
+	char *out;
+	long size;
+	int enc_idx;
+	int depth;
+	/* Set in the first pass, if the value must be encoded by ::JSON.generate */
+	int fallback;
+} t_json_gen;
+
+/* Length of the JSON escape sequence per byte within a string */
+static const unsigned char json_escape_len[256] = {
+	6, 6, 6, 6, 6, 6, 6, 6, 2, 2, 2, 6, 2, 2, 6, 6,
+	6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+	1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+};
+
+static void json_gen_value( t_json_gen *g, VALUE value );
+
+static inline void
+json_gen_raw( t_json_gen *g, const char *ptr, long len )
+{
+	if( g->out ){
+		memcpy( g->out, ptr, len );
+		g->out += len;
+	} else {
+		g->size += len;
+	}
+}
+
+static void
+json_gen_string( t_json_gen *g, VALUE str )
+{
+	const unsigned char *p = (const unsigned char *)RSTRING_PTR(str);
+	const unsigned char *end = p + RSTRING_LEN(str);
+	int str_enc_idx = ENCODING_GET(str);
+
+	if( !g->out ){
+		long size = 2;
+		rb_encoding *enc = rb_enc_from_index(g->enc_idx);
+
+		/* Only ASCII strings and strings in the UTF-8 output encoding can be escaped byte by byte.
+		 * Everything else is converted by ::JSON.generate */
+		if( !( (rb_enc_asciicompat(enc) && rb_enc_str_asciionly_p(str)) ||
+				(str_enc_idx == g->enc_idx && str_enc_idx == rb_utf8_encindex() && rb_enc_str_coderange(str) == ENC_CODERANGE_VALID) ) ){
+			g->fallback = 1;
+			return;
+		}
+		for( ; p < end; p++ ) size += json_escape_len[*p];
+		g->size += size;
+		return;
+	}
+
+	*g->out++ = '"';
+	while( p < end ){
+		const unsigned char *s = p;
+		while( p < end && json_escape_len[*p] == 1 ) p++;
+		memcpy( g->out, s, p - s );
+		g->out += p - s;
+		if( p == end ) break;
+
+		*g->out++ = '\\';
+		switch( *p ){
+			case '"': *g->out++ = '"'; break;
+			case '\\': *g->out++ = '\\'; break;
+			case '\b': *g->out++ = 'b'; break;
+			case '\f': *g->out++ = 'f'; break;
+			case '\n': *g->out++ = 'n'; break;
+			case '\r': *g->out++ = 'r'; break;
+			case '\t': *g->out++ = 't'; break;
+			default:
+				*g->out++ = 'u';
+				*g->out++ = '0';
+				*g->out++ = '0';
+				*g->out++ = "0123456789abcdef"[*p >> 4];
+				*g->out++ = "0123456789abcdef"[*p & 0xf];
+				break;
+		}
+		p++;
+	}
+	*g->out++ = '"';
+}
+
+/*
+ * Write the shortest representation of _d_ that reads back to the same value, in the format of Float#to_s .
+ * Returns the length, which is at most 24 bytes.
+ */
+static int
+json_format_float( char *out, double d )
+{
+	char digits[17];
+	char *p = out;
+	int ndigits, exp10, decpt, i;
+
+	if( signbit(d) ){
+		*p++ = '-';
+		d = -d;
+	}
+	if( d == 0 ){
+		memcpy( p, "0.0", 3 );
+		return (int)(p - out) + 3;
+	}
+	ndigits = rbpg_dtoa_shortest( d, digits, &exp10 );
+	decpt = ndigits + exp10;
+
+	if( decpt > 0 && (decpt <= 15 || ndigits > decpt) ){
+		/* 123.45 */
+		for( i = 0; i < decpt; i++ ) *p++ = i < ndigits ? digits[i] : '0';
+		*p++ = '.';
+		if( ndigits > decpt ){
+			memcpy( p, digits + decpt, ndigits - decpt );
+			p += ndigits - decpt;
+		} else {
+			*p++ = '0';
+		}
+	} else if( decpt <= 0 && decpt > -4 ){
+		/* 0.00123 */
+		*p++ = '0';
+		*p++ = '.';
+		for( i = decpt; i < 0; i++ ) *p++ = '0';
+		memcpy( p, digits, ndigits );
+		p += ndigits;
+	} else {
+		/* 1.23e+45 */
+		*p++ = digits[0];
+		*p++ = '.';
+		if( ndigits > 1 ){
+			memcpy( p, digits + 1, ndigits - 1 );
+			p += ndigits - 1;
+		} else {
+			*p++ = '0';
+		}
+		p += sprintf( p, "e%+03d", decpt - 1 );
+	}
+	return (int)(p - out);
+}
+
+static void
+json_gen_number( t_json_gen *g, VALUE value )
+{
+	if( FIXNUM_P(value) ){
+		if( g->out ){
+			long v = FIX2LONG(value);
+			unsigned long u = v < 0 ? -(unsigned long)v : (unsigned long)v;
+			char buf[24];
+			char *e = buf + sizeof(buf), *b = e;
+			do { *--b = '0' + (char)(u % 10); u /= 10; } while( u );
+			if( v < 0 ) *--b = '-';
+			json_gen_raw( g, b, e - b );
+		} else {
+			g->size += 21;
+		}
+	} else if( RB_FLOAT_TYPE_P(value) ){
+		double d = RFLOAT_VALUE(value);
+		if( isnan(d) || isinf(d) ){
+			/* ::JSON.generate raises GeneratorError */
+			g->fallback = 1;
+		} else if( g->out ){
+			g->out += json_format_float( g->out, d );
+		} else {
+			g->size += 24;
+		}
+	} else {
+		VALUE str = rb_big2str( value, 10 );
+		json_gen_raw( g, RSTRING_PTR(str), RSTRING_LEN(str) );
+	}
+}
+
+struct json_gen_hash_ctx {
+	t_json_gen *g;
+	int first;
+};
+
+static int
+json_gen_hash_pair( VALUE key, VALUE val, VALUE _ctx )
+{
+	struct json_gen_hash_ctx *ctx = (struct json_gen_hash_ctx *)_ctx;
+	t_json_gen *g = ctx->g;
+
+	if( !ctx->first ) json_gen_raw( g, ",", 1 );
+	ctx->first = 0;
+
+	if( RB_TYPE_P(key, T_SYMBOL) ){
+		key = rb_sym2str( key );
+	} else if( !(RB_TYPE_P(key, T_STRING) && RBASIC_CLASS(key) == rb_cString) ){
+		/* Keys are converted by to_s */
+		g->fallback = 1;
+		return ST_STOP;
+	}
+	json_gen_string( g, key );
+	json_gen_raw( g, ":", 1 );
+	json_gen_value( g, val );
+
+	return g->fallback ? ST_STOP : ST_CONTINUE;
+}
+
+static void
+json_gen_value( t_json_gen *g, VALUE value )
+{
+	switch( TYPE(value) ){
+		case T_NIL: json_gen_raw( g, "null", 4 ); return;
+		case T_TRUE: json_gen_raw( g, "true", 4 ); return;
+		case T_FALSE: json_gen_raw( g, "false", 5 ); return;
+		case T_FIXNUM: json_gen_number( g, value ); return;
+		case T_FLOAT: json_gen_number( g, value ); return;
+		case T_BIGNUM: json_gen_number( g, value ); return;
+		case T_SYMBOL: json_gen_string( g, rb_sym2str(value) ); return;
+		case T_STRING:
+			if( RBASIC_CLASS(value) != rb_cString ) break;
+			json_gen_string( g, value );
+			return;
+		case T_ARRAY: {
+			long i;
+			/* Subclasses may define to_json and ::JSON.generate raises NestingError on deep nesting */
+			if( RBASIC_CLASS(value) != rb_cArray || g->depth >= PG_JSON_MAX_NESTING - 1 ) break;
+			g->depth++;
+			json_gen_raw( g, "[", 1 );
+			for( i=0; i<RARRAY_LEN(value) && !g->fallback; i++ ){
+				if( i ) json_gen_raw( g, ",", 1 );
+				json_gen_value( g, RARRAY_AREF(value, i) );
+			}
+			json_gen_raw( g, "]", 1 );
+			g->depth--;
+			return;
+		}
+		case T_HASH: {
+			struct json_gen_hash_ctx ctx = { g, 1 };
+			if( RBASIC_CLASS(value) != rb_cHash || g->depth >= PG_JSON_MAX_NESTING - 1 ) break;
+			g->depth++;
+			json_gen_raw( g, "{", 1 );
+			rb_hash_foreach( value, json_gen_hash_pair, (VALUE)&ctx );
+			json_gen_raw( g, "}", 1 );
+			g->depth--;
+			return;
+		}
+		default:
+			break;
+	}
+	g->fallback = 1;
+}
+
+/*
+ * Document-class: PG::TextEncoder::JSON < PG::SimpleEncoder
+ *
+ * This is a encoder class for conversion of Ruby Hash, Array, String, Numeric, nil values to PostgreSQL JSON/JSONB type.
+ *
+ * Hash, Array, String, Symbol, Integer, Float, true, false and nil are written in C directly into the query parameter or COPY buffer.
+ * Other objects and subclasses are encoded by <tt>::JSON.generate</tt>, so that their +to_json+ method is respected.
+ * The output equals to <tt>::JSON.generate</tt> in either case.
+ *
+ * The encoder can be used as element coder of PG::TextEncoder::Array and PG::TextEncoder::Record as well.
+ *
+ * As soon as this class is used, it requires the ruby standard library 'json'.
+ */
+static int
+pg_text_enc_json(t_pg_coder *this, VALUE value, char *out, VALUE *intermediate, int enc_idx)
+{
+	t_json_gen g;
+
+	g.out = out;
+	g.size = 0;
+	g.enc_idx = enc_idx;
+	g.depth = 0;
+	g.fallback = 0;
+
+	json_gen_value( &g, value );
+
+	if( out ){
+		return (int)(g.out - out);
+	} else if( g.fallback || g.size > INT_MAX ){
+		VALUE str = rb_funcall( s_mJSON, s_id_generate, 1, value );
+		if( ENCODING_GET(str) != enc_idx ){
+			str = rb_str_export_to_enc( str, rb_enc_from_index(enc_idx) );
+		}
+		*intermediate = str;
+		return -1;
+	}
+	return (int)g.size;
+}
+
+/*
+ * Document-class: PG::BinaryDecoder::JSON < PG::SimpleDecoder
+ *
+ * This is a decoder class for conversion of PostgreSQL JSON/JSONB type in binary format to Ruby Hash, Array, String, Numeric, nil values.
+ *
+ * The version byte of the jsonb binary format is verified and skipped, so that the same decoder can be used for both types.
+ * Parsing and options are the same as PG::TextDecoder::JSON .
+ *
+ * As soon as this class is used, it requires the ruby standard library 'json'.
+ */
+static VALUE
+pg_bin_dec_json(t_pg_coder *conv, const char *val, int len, int tuple, int field, int enc_idx)
+{
+	/* JSON text can not start with a control character other than whitespace */
+	if( len > 0 && (unsigned char)val[0] < 0x20 && val[0] != ' ' && val[0] != '\t' && val[0] != '\n' && val[0] != '\r' ){
+		if( val[0] != 1 ){
+			rb_raise( rb_eArgError, "unsupported jsonb version number %d", val[0] );
+		}
+		val++;
+		len--;
+	}
+	return pg_text_dec_json( conv, val, len, tuple, field, enc_idx );
+}
+
+/*
+ * Document-class: PG::BinaryEncoder::JSON < PG::SimpleEncoder
+ *
+ * This is the encoder class for the PostgreSQL JSON type in binary format.
+ *
+ * The binary format of json equals to the text format, so that it encodes exactly like PG::TextEncoder::JSON .
+ * Use PG::BinaryEncoder::JSONB for the jsonb type.
+ *
+ * As soon as this class is used, it requires the ruby standard library 'json'.
+ */
+
+/*
+ * Document-class: PG::BinaryEncoder::JSONB < PG::BinaryEncoder::JSON
+ *
+ * This is the encoder class for the PostgreSQL JSONB type in binary format.
+ *
+ * It writes the jsonb version byte followed by the JSON text of PG::TextEncoder::JSON .
+ *
+ * As soon as this class is used, it requires the ruby standard library 'json'.
+ */
+static int
+pg_bin_enc_jsonb(t_pg_coder *this, VALUE value, char *out, VALUE *intermediate, int enc_idx)
+{
+	int len;
+
+	if( out ){
+		*out = 1;
+		return pg_text_enc_json( this, value, out + 1, intermediate, enc_idx ) + 1;
+	}
+
+	len = pg_text_enc_json( this, value, NULL, intermediate, enc_idx );
+	if( len == -1 ){
+		VALUE str = rb_str_buf_new( RSTRING_LEN(*intermediate) + 1 );
+		rb_str_buf_cat( str, "\x01", 1 );
+		rb_str_buf_append( str, *intermediate );
+		*intermediate = str;
+		return -1;
+	}
+	return len + 1;
+}
+
+/* called per autoload when TextDecoder::JSON is used */
+static VALUE
+init_pg_text_decoder_json(VALUE rb_mPG_TextDecoder)
+{
+	rb_require("json");
+	rb_gc_register_address(&s_cJSON_ParserError);
+	rb_gc_register_address(&s_cJSON_NestingError);
+	s_cJSON_ParserError = rb_path2class("JSON::ParserError");
+	s_cJSON_NestingError = rb_path2class("JSON::NestingError");
+	s_id_BigDecimal = rb_intern("BigDecimal");
+
+	/* dummy = rb_define_class_under( rb_mPG_TextDecoder, "JSON", rb_cPG_SimpleDecoder ); */
+	pg_define_coder( "JSON", pg_text_dec_json, rb_cPG_SimpleDecoder, rb_mPG_TextDecoder );
+
+	return Qnil;
+}
+
+/* called per autoload when TextEncoder::JSON is used */
+static VALUE
+init_pg_text_encoder_json(VALUE rb_mPG_TextEncoder)
+{
+	rb_require("json");
+	rb_gc_register_address(&s_mJSON);
+	s_mJSON = rb_const_get(rb_cObject, rb_intern("JSON"));
+	s_id_generate = rb_intern("generate");
+
+	/* dummy = rb_define_class_under( rb_mPG_TextEncoder, "JSON", rb_cPG_SimpleEncoder ); */
+	pg_define_coder( "JSON", pg_text_enc_json, rb_cPG_SimpleEncoder, rb_mPG_TextEncoder );
+
+	return Qnil;
+}
+
+/* called per autoload when BinaryDecoder::JSON is used */
+static VALUE
+init_pg_bin_decoder_json(VALUE rb_mPG_BinaryDecoder)
+{
+	rb_funcall(rb_mPG_TextDecoder, rb_intern("const_get"), 1, rb_str_new2("JSON"));
+
+	/* dummy = rb_define_class_under( rb_mPG_BinaryDecoder, "JSON", rb_cPG_SimpleDecoder ); */
+	pg_define_coder( "JSON", pg_bin_dec_json, rb_cPG_SimpleDecoder, rb_mPG_BinaryDecoder );
+
+	return Qnil;
+}
+
+/* called per autoload when BinaryEncoder::JSON is used */
+static VALUE
+init_pg_bin_encoder_json(VALUE rb_mPG_BinaryEncoder)
+{
+	VALUE klass;
+
+	rb_funcall(rb_mPG_TextEncoder, rb_intern("const_get"), 1, rb_str_new2("JSON"));
+
+	/* dummy = rb_define_class_under( rb_mPG_BinaryEncoder, "JSON", rb_cPG_SimpleEncoder ); */
+	klass = pg_define_coder( "JSON", pg_text_enc_json, rb_cPG_SimpleEncoder, rb_mPG_BinaryEncoder );
+	/* dummy = rb_define_class_under( rb_mPG_BinaryEncoder, "JSONB", klass ); */
+	pg_define_coder( "JSONB", pg_bin_enc_jsonb, klass, rb_mPG_BinaryEncoder );
+
+	return Qnil;
+}
+
+void
+init_pg_jsoncoder(void)
+{
+	rb_define_private_method(rb_singleton_class(rb_mPG_TextDecoder), "init_json", init_pg_text_decoder_json, 0);
+	rb_define_private_method(rb_singleton_class(rb_mPG_TextEncoder), "init_json", init_pg_text_encoder_json, 0);
+	rb_define_private_method(rb_singleton_class(rb_mPG_BinaryDecoder), "init_json", init_pg_bin_decoder_json, 0);
+	rb_define_private_method(rb_singleton_class(rb_mPG_BinaryEncoder), "init_json", init_pg_bin_encoder_json, 0);
+}
@@ -0,0 +1,617 @@
+/*
+ * pg_replication.c - PG::ReplicationStream class extension
+ *
+ */
+
+#include "pg.h"
+#include "pg_util.h"
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+
+/* Seconds between the Unix epoch and the PostgreSQL epoch 2000-01-01 */
+#define PG_EPOCH_OFFSET ((int64_t)10957 * 24 * 3600)
+
+static VALUE rb_cPG_ReplicationStream;
+static VALUE rb_cKeepalive;
+static VALUE rb_cXLogData;
+static VALUE rb_cBegin;
+static VALUE rb_cCommit;
+static VALUE rb_cRelation;
+static VALUE rb_cColumn;
+static VALUE rb_cInsert;
+static VALUE rb_cUpdate;
+static VALUE rb_cDelete;
+static VALUE rb_cTruncate;
+static VALUE rb_cOther;
+static VALUE s_sym_unchanged_toast;
+
+/* Index of PG::ReplicationStream::Relation#type_map */
+#define RELATION_TYPE_MAP 5
+
+typedef struct {
+	/* The PG::Connection in replication mode */
+	VALUE connection;
+	/* Hash of relation OID => PG::ReplicationStream::Relation received so far */
+	VALUE relations;
+	/* WAL positions reported in standby status updates */
+	uint64_t received_lsn;
+	uint64_t flushed_lsn;
+	uint64_t applied_lsn;
+	/* Decode XLogData as pgoutput messages */
+	int logical;
+} t_pg_replstream;
+
+/* Read position in a CopyData message */
+typedef struct {
+	const char *ptr;
+	const char *end;
+	int enc_idx;
+} t_msg_reader;
+
+
+static void
+pg_replstream_gc_mark( void *_this )
+{
+	t_pg_replstream *this = (t_pg_replstream *)_this;
+	rb_gc_mark_movable( this->connection );
+	rb_gc_mark_movable( this->relations );
+}
+
+static void
+pg_replstream_gc_compact( void *_this )
+{
+	t_pg_replstream *this = (t_pg_replstream *)_this;
+	pg_gc_location( this->connection );
+	pg_gc_location( this->relations );
+}
+
+static size_t
+pg_replstream_memsize( const void *_this )
+{
+	const t_pg_replstream *this = (const t_pg_replstream *)_this;
+	return sizeof(*this);
+}
+
+static const rb_data_type_t pg_replstream_type = {
+	"PG::ReplicationStream",
+	{
+		pg_replstream_gc_mark,
+		RUBY_TYPED_DEFAULT_FREE,
+		pg_replstream_memsize,
+		pg_replstream_gc_compact,
+	},
+	0, 0,
+	RUBY_TYPED_FREE_IMMEDIATELY | RUBY_TYPED_WB_PROTECTED,
+};
+
+static VALUE
+pg_replstream_s_allocate( VALUE klass )
+{
+	t_pg_replstream *this;
+	VALUE self = TypedData_Make_Struct( klass, t_pg_replstream, &pg_replstream_type, this );
+
+	this->connection = Qnil;
+	this->relations = Qnil;
+	return self;
+}
+
+static t_pg_replstream *
+pg_replstream_get_this( VALUE self )
+{
+	t_pg_replstream *this;
+	TypedData_Get_Struct( self, t_pg_replstream, &pg_replstream_type, this );
+
+	if( NIL_P(this->connection) )
+		rb_raise( rb_eArgError, "replication stream is not initialized" );
+	return this;
+}
+
+/*
+ * call-seq:
+ *    stream.init_stream( connection, logical )
+ *
+ * Bind the stream to a PG::Connection .
+ * If +logical+ is true, XLogData messages are decoded as pgoutput messages.
+ */
+static VALUE
+pg_replstream_init_stream( VALUE self, VALUE connection, VALUE logical )
+{
+	t_pg_replstream *this;
+	TypedData_Get_Struct( self, t_pg_replstream, &pg_replstream_type, this );
+
+	/* Check argument type */
+	pg_get_connection( connection );
+	RB_OBJ_WRITE( self, &this->connection, connection );
+	RB_OBJ_WRITE( self, &this->relations, rb_hash_new() );
+	this->logical = RTEST(logical);
+	return self;
+}
+
+
+static void
+pg_replstream_need( t_msg_reader *r, long len )
+{
+	if( r->end - r->ptr < len )
+		rb_raise( rb_eArgError, "premature end of replication message" );
+}
+
+static int
+pg_replstream_read8( t_msg_reader *r )
+{
+	pg_replstream_need( r, 1 );
+	return (unsigned char)*r->ptr++;
+}
+
+static int
+pg_replstream_read16( t_msg_reader *r )
+{
+	int val;
+	pg_replstream_need( r, 2 );
+	val = read_nbo16( r->ptr );
+	r->ptr += 2;
+	return val;
+}
+
+static int32_t
+pg_replstream_read32( t_msg_reader *r )
+{
+	int32_t val;
+	pg_replstream_need( r, 4 );
+	val = read_nbo32( r->ptr );
+	r->ptr += 4;
+	return val;
+}
+
+static int64_t
+pg_replstream_read64( t_msg_reader *r )
+{
+	int64_t val;
+	pg_replstream_need( r, 8 );
+	val = read_nbo64( r->ptr );
+	r->ptr += 8;
+	return val;
+}
+
+/* Read a NUL terminated string */
+static VALUE
+pg_replstream_read_string( t_msg_reader *r )
+{
+	const char *nul = memchr( r->ptr, 0, r->end - r->ptr );
+	VALUE str;
+
+	if( !nul )
+		rb_raise( rb_eArgError, "unterminated string in replication message" );
+	str = rb_str_new( r->ptr, nul - r->ptr );
+	PG_ENCODING_SET_NOCHECK( str, r->enc_idx );
+	r->ptr = nul + 1;
+	return str;
+}
+
+/* Convert microseconds since 2000-01-01 to a Time object */
+static VALUE
+pg_replstream_time( int64_t timestamp )
+{
+	int64_t sec = timestamp / 1000000;
+	int64_t usec = timestamp % 1000000;
+
+	if( usec < 0 ){
+		sec -= 1;
+		usec += 1000000;
+	}
+	return rb_time_nano_new( sec + PG_EPOCH_OFFSET, usec * 1000 );
+}
+
+static VALUE
+pg_replstream_read_relation( t_pg_replstream *this, t_msg_reader *r )
+{
+	uint32_t oid = (uint32_t)pg_replstream_read32( r );
+	VALUE relation = rb_hash_lookup( this->relations, UINT2NUM(oid) );
+
+	if( NIL_P(relation) )
+		rb_raise( rb_eArgError, "unknown relation OID %u in replication message", oid );
+	return relation;
+}
+
+/*
+ * Decode a TupleData part of a pgoutput message through the type map of the relation.
+ */
+static VALUE
+pg_replstream_read_tuple( t_msg_reader *r, VALUE relation )
+{
+	VALUE rb_typemap = RSTRUCT_GET( relation, RELATION_TYPE_MAP );
+	t_typemap *p_typemap;
+	VALUE array;
+	VALUE field_str = Qnil;
+	int ncols;
+	int fieldno;
+
+	if( NIL_P(rb_typemap) ){
+		rb_typemap = pg_typemap_all_strings;
+	} else if ( !rb_obj_is_kind_of(rb_typemap, rb_cTypeMap) ){
+		rb_raise( rb_eTypeError, "wrong type map type %s (expected some kind of PG::TypeMap)",
+				rb_obj_classname( rb_typemap ) );
+	}
+	p_typemap = RTYPEDDATA_DATA( rb_typemap );
+	p_typemap->funcs.fit_to_copy_get( rb_typemap );
+
+	ncols = pg_replstream_read16( r );
+	array = rb_ary_new2( ncols );
+
+	for( fieldno = 0; fieldno < ncols; fieldno++ ){
+		int kind = pg_replstream_read8( r );
+		int32_t len;
+		VALUE field_value;
+
+		switch( kind ){
+			case 'n':
+				rb_ary_push( array, Qnil );
+				break;
+			case 'u':
+				/* TOASTed value, which was not changed and is therefore not sent */
+				rb_ary_push( array, s_sym_unchanged_toast );
+				break;
+			case 't':
+			case 'b':
+				len = pg_replstream_read32( r );
+				if( len < 0 ) rb_raise( rb_eArgError, "invalid field length in replication message" );
+				pg_replstream_need( r, len );
+
+				if( NIL_P(field_str) ){
+					field_str = rb_str_new( r->ptr, len );
+				} else {
+					/* reuse the string of the previous field */
+					rb_str_resize( field_str, len );
+					memcpy( RSTRING_PTR(field_str), r->ptr, len );
+				}
+				r->ptr += len;
+
+				field_value = p_typemap->funcs.typecast_copy_get( p_typemap, field_str, fieldno, kind == 'b', r->enc_idx );
+				rb_ary_push( array, field_value );
+				if( field_value == field_str ){
+					/* The string is returned to the user, so that it can not be reused. */
+					field_str = Qnil;
+				}
+				break;
+			default:
+				rb_raise( rb_eArgError, "unknown tuple data type %d in replication message", kind );
+		}
+	}
+
+	RB_GC_GUARD(rb_typemap);
+	return array;
+}
+
+/*
+ * Decode one message of the pgoutput logical decoding plugin.
+ */
+static VALUE
+pg_replstream_decode_pgoutput( t_pg_replstream *this, t_msg_reader *r )
+{
+	int type = pg_replstream_read8( r );
+	VALUE event;
+
+	switch( type ){
+		case 'B': {
+			int64_t final_lsn = pg_replstream_read64( r );
+			int64_t commit_time = pg_replstream_read64( r );
+			uint32_t xid = (uint32_t)pg_replstream_read32( r );
+			event = rb_struct_new( rb_cBegin, ULL2NUM(final_lsn), pg_replstream_time(commit_time), UINT2NUM(xid) );
+			break;
+		}
+		case 'C': {
+			int flags = pg_replstream_read8( r );
+			int64_t commit_lsn = pg_replstream_read64( r );
+			int64_t end_lsn = pg_replstream_read64( r );
+			int64_t commit_time = pg_replstream_read64( r );
+			event = rb_struct_new( rb_cCommit, ULL2NUM(commit_lsn), ULL2NUM(end_lsn), pg_replstream_time(commit_time), INT2FIX(flags) );
+			break;
+		}
+		case 'R': {
+			uint32_t oid = (uint32_t)pg_replstream_read32( r );
+			VALUE namespace = pg_replstream_read_string( r );
+			VALUE name = pg_replstream_read_string( r );
+			char replica_identity = (char)pg_replstream_read8( r );
+			int ncols = pg_replstream_read16( r );
+			VALUE columns = rb_ary_new2( ncols );
+			int i;
+
+			for( i = 0; i < ncols; i++ ){
+				int flags = pg_replstream_read8( r );
+				VALUE col_name = pg_replstream_read_string( r );
+				uint32_t type_oid = (uint32_t)pg_replstream_read32( r );
+				int32_t type_modifier = pg_replstream_read32( r );
+				rb_ary_push( columns, rb_struct_new( rb_cColumn, col_name, UINT2NUM(type_oid), INT2NUM(type_modifier), (flags & 1) ? Qtrue : Qfalse ) );
+			}
+			event = rb_struct_new( rb_cRelation, UINT2NUM(oid), namespace, name,
+					rb_usascii_str_new( &replica_identity, 1 ), columns, Qnil );
+			rb_hash_aset( this->relations, UINT2NUM(oid), event );
+			break;
+		}
+		case 'I': {
+			VALUE relation = pg_replstream_read_relation( this, r );
+			if( pg_replstream_read8( r ) != 'N' )
+				rb_raise( rb_eArgError, "unexpected tuple type in insert message" );
+			event = rb_struct_new( rb_cInsert, relation, pg_replstream_read_tuple( r, relation ) );
+			break;
+		}
+		case 'U': {
+			VALUE relation = pg_replstream_read_relation( this, r );
+			VALUE old_tuple = Qnil;
+			int tuple_type = pg_replstream_read8( r );
+
+			/* The old tuple is sent with the key columns only ('K') or with all columns ('O') */
+			if( tuple_type == 'K' || tuple_type == 'O' ){
+				old_tuple = pg_replstream_read_tuple( r, relation );
+				tuple_type = pg_replstream_read8( r );
+			}
+			if( tuple_type != 'N' )
+				rb_raise( rb_eArgError, "unexpected tuple type in update message" );
+			event = rb_struct_new( rb_cUpdate, relation, old_tuple, pg_replstream_read_tuple( r, relation ) );
+			break;
+		}
+		case 'D': {
+			VALUE relation = pg_replstream_read_relation( this, r );
+			int tuple_type = pg_replstream_read8( r );
+
+			if( tuple_type != 'K' && tuple_type != 'O' )
+				rb_raise( rb_eArgError, "unexpected tuple type in delete message" );
+			event = rb_struct_new( rb_cDelete, relation, pg_replstream_read_tuple( r, relation ) );
+			break;
+		}
+		case 'T': {
+			int nrelations = pg_replstream_read32( r );
+			int options = pg_replstream_read8( r );
+			VALUE relations = rb_ary_new2( nrelations );
+			int i;
+
+			for( i = 0; i < nrelations; i++ ){
+				rb_ary_push( relations, pg_replstream_read_relation( this, r ) );
+			}
+			event = rb_struct_new( rb_cTruncate, relations, (options & 1) ? Qtrue : Qfalse, (options & 2) ? Qtrue : Qfalse );
+			break;
+		}
+		default: {
+			char type_char = (char)type;
+			/* Origin, Type, logical decoding message or a message of a newer protocol version */
+			event = rb_struct_new( rb_cOther, rb_usascii_str_new( &type_char, 1 ), rb_str_new( r->ptr, r->end - r->ptr ) );
+			r->ptr = r->end;
+		}
+	}
+
+	if( r->ptr != r->end )
+		rb_raise( rb_eArgError, "trailing data after replication message of type '%c'", type );
+
+	return event;
+}
+
+/*
+ * call-seq:
+ *    stream.decode_message( data ) -> Struct
+ *
+ * Decode one CopyData message received from the server.
+ *
+ * Returns a PG::ReplicationStream::Keepalive for a primary keepalive message.
+ * XLogData messages are returned as PG::ReplicationStream::XLogData or, on a logical stream,
+ * as the decoded pgoutput message.
+ */
+static VALUE
+pg_replstream_decode_message( VALUE self, VALUE data )
+{
+	t_pg_replstream *this = pg_replstream_get_this( self );
+	t_msg_reader r;
+	VALUE event;
+	int type;
+
+	Check_Type( data, T_STRING );
+	r.ptr = RSTRING_PTR( data );
+	r.end = r.ptr + RSTRING_LEN( data );
+	r.enc_idx = pg_get_connection( this->connection )->enc_idx;
+
+	type = pg_replstream_read8( &r );
+	switch( type ){
+		case 'k': {
+			int64_t wal_end = pg_replstream_read64( &r );
+			int64_t send_time = pg_replstream_read64( &r );
+			int reply_requested = pg_replstream_read8( &r );
+
+			if( (uint64_t)wal_end > this->received_lsn )
+				this->received_lsn = (uint64_t)wal_end;
+			event = rb_struct_new( rb_cKeepalive, ULL2NUM(wal_end), pg_replstream_time(send_time), reply_requested ? Qtrue : Qfalse );
+			break;
+		}
+		case 'w': {
+			int64_t wal_start = pg_replstream_read64( &r );
+			int64_t wal_end = pg_replstream_read64( &r );
+			int64_t send_time = pg_replstream_read64( &r );
+
+			if( (uint64_t)wal_start > this->received_lsn )
+				this->received_lsn = (uint64_t)wal_start;
+			if( this->logical ){
+				event = pg_replstream_decode_pgoutput( this, &r );
+			} else {
+				VALUE wal_data = rb_str_new( r.ptr, r.end - r.ptr );
+				event = rb_struct_new( rb_cXLogData, ULL2NUM(wal_start), ULL2NUM(wal_end), pg_replstream_time(send_time), wal_data );
+			}
+			break;
+		}
+		default:
+			rb_raise( rb_eArgError, "unknown replication message type %d", type );
+	}
+
+	RB_GC_GUARD(data);
+	return event;
+}
+
+/*
+ * call-seq:
+ *    stream.send_status_update( reply_requested ) -> nil
+ *
+ * Queue a standby status update with the current WAL positions for sending to the server.
+ *
+ * The message is built on the stack, so that no Ruby objects are allocated.
+ * The data is sent by the next PG::Connection#flush .
+ */
+static VALUE
+pg_replstream_send_status_update( VALUE self, VALUE reply_requested )
+{
+	t_pg_replstream *this = pg_replstream_get_this( self );
+	PGconn *conn = pg_get_pgconn( this->connection );
+	char msg[34];
+	struct timeval tv;
+	int64_t now;
+
+	gettimeofday( &tv, NULL );
+	now = ((int64_t)tv.tv_sec - PG_EPOCH_OFFSET) * 1000000 + tv.tv_usec;
+
+	msg[0] = 'r';
+	write_nbo64( this->received_lsn, msg + 1 );
+	write_nbo64( this->flushed_lsn, msg + 9 );
+	write_nbo64( this->applied_lsn, msg + 17 );
+	write_nbo64( now, msg + 25 );
+	msg[33] = RTEST(reply_requested) ? 1 : 0;
+
+	if( gvl_PQputCopyData( conn, msg, sizeof(msg) ) == -1 )
+		pg_raise_conn_error( rb_ePGerror, this->connection, "%s", PQerrorMessage(conn) );
+
+	return Qnil;
+}
+
+/*
+ * call-seq:
+ *    stream.connection -> PG::Connection
+ *
+ * The connection the stream is received from.
+ */
+static VALUE
+pg_replstream_connection( VALUE self )
+{
+	return pg_replstream_get_this( self )->connection;
+}
+
+/*
+ * call-seq:
+ *    stream.relations -> Hash
+ *
+ * All relations received so far as Hash of OID => PG::ReplicationStream::Relation .
+ */
+static VALUE
+pg_replstream_relations( VALUE self )
+{
+	return pg_replstream_get_this( self )->relations;
+}
+
+/*
+ * call-seq:
+ *    stream.received_lsn -> Integer
+ *
+ * The highest WAL position received from the server.
+ */
+static VALUE
+pg_replstream_received_lsn( VALUE self )
+{
+	return ULL2NUM( pg_replstream_get_this( self )->received_lsn );
+}
+
+/*
+ * call-seq:
+ *    stream.flushed_lsn -> Integer
+ *
+ * The WAL position reported to the server as flushed by the client.
+ */
+static VALUE
+pg_replstream_flushed_lsn( VALUE self )
+{
+	return ULL2NUM( pg_replstream_get_this( self )->flushed_lsn );
+}
+
+/*
+ * call-seq:
+ *    stream.flushed_lsn = Integer
+ *
+ * Set the WAL position up to which the received data is durably stored by the client.
+ * The server may remove WAL up to this position from the replication slot.
+ */
+static VALUE
+pg_replstream_flushed_lsn_set( VALUE self, VALUE lsn )
+{
+	pg_replstream_get_this( self )->flushed_lsn = NUM2ULL( lsn );
+	return lsn;
+}
+
+/*
+ * call-seq:
+ *    stream.applied_lsn -> Integer
+ *
+ * The WAL position reported to the server as applied by the client.
+ */
+static VALUE
+pg_replstream_applied_lsn( VALUE self )
+{
+	return ULL2NUM( pg_replstream_get_this( self )->applied_lsn );
+}
+
+/*
+ * call-seq:
+ *    stream.applied_lsn = Integer
+ *
+ * Set the WAL position up to which the received data is applied by the client.
+ */
+static VALUE
+pg_replstream_applied_lsn_set( VALUE self, VALUE lsn )
+{
+	pg_replstream_get_this( self )->applied_lsn = NUM2ULL( lsn );
+	return lsn;
+}
+
+void
+init_pg_replication(void)
+{
+	/*
+	 * Document-class: PG::ReplicationStream
+	 *
+	 * Client for the streaming replication protocol.
+	 */
+	rb_cPG_ReplicationStream = rb_define_class_under( rb_mPG, "ReplicationStream", rb_cObject );
+	rb_define_alloc_func( rb_cPG_ReplicationStream, pg_replstream_s_allocate );
+
+	rb_define_private_method( rb_cPG_ReplicationStream, "init_stream", pg_replstream_init_stream, 2 );
+	rb_define_private_method( rb_cPG_ReplicationStream, "decode_message", pg_replstream_decode_message, 1 );
+	rb_define_private_method( rb_cPG_ReplicationStream, "send_status_update", pg_replstream_send_status_update, 1 );
+	rb_define_method( rb_cPG_ReplicationStream, "connection", pg_replstream_connection, 0 );
+	rb_define_method( rb_cPG_ReplicationStream, "relations", pg_replstream_relations, 0 );
+	rb_define_method( rb_cPG_ReplicationStream, "received_lsn", pg_replstream_received_lsn, 0 );
+	rb_define_method( rb_cPG_ReplicationStream, "flushed_lsn", pg_replstream_flushed_lsn, 0 );
+	rb_define_method( rb_cPG_ReplicationStream, "flushed_lsn=", pg_replstream_flushed_lsn_set, 1 );
+	rb_define_method( rb_cPG_ReplicationStream, "applied_lsn", pg_replstream_applied_lsn, 0 );
+	rb_define_method( rb_cPG_ReplicationStream, "applied_lsn=", pg_replstream_applied_lsn_set, 1 );
+
+	/* Primary keepalive message */
+	rb_cKeepalive = rb_struct_define_under( rb_cPG_ReplicationStream, "Keepalive", "wal_end", "send_time", "reply_requested", NULL );
+	/* WAL data of a physical replication stream */
+	rb_cXLogData = rb_struct_define_under( rb_cPG_ReplicationStream, "XLogData", "wal_start", "wal_end", "send_time", "data", NULL );
+	/* pgoutput messages of a logical replication stream */
+	rb_cBegin = rb_struct_define_under( rb_cPG_ReplicationStream, "Begin", "final_lsn", "commit_time", "xid", NULL );
+	rb_cCommit = rb_struct_define_under( rb_cPG_ReplicationStream, "Commit", "commit_lsn", "end_lsn", "commit_time", "flags", NULL );
+	rb_cRelation = rb_struct_define_under( rb_cPG_ReplicationStream, "Relation", "oid", "namespace", "name", "replica_identity", "columns", "type_map", NULL );
+	rb_cColumn = rb_struct_define_under( rb_cPG_ReplicationStream, "Column", "name", "type_oid", "type_modifier", "key", NULL );
+	rb_cInsert = rb_struct_define_under( rb_cPG_ReplicationStream, "Insert", "relation", "new_tuple", NULL );
+	rb_cUpdate = rb_struct_define_under( rb_cPG_ReplicationStream, "Update", "relation", "old_tuple", "new_tuple", NULL );
+	rb_cDelete = rb_struct_define_under( rb_cPG_ReplicationStream, "Delete", "relation", "old_tuple", NULL );
+	rb_cTruncate = rb_struct_define_under( rb_cPG_ReplicationStream, "Truncate", "relations", "cascade", "restart_identity", NULL );
+	rb_cOther = rb_struct_define_under( rb_cPG_ReplicationStream, "Other", "type", "data", NULL );
+
+	rb_gc_register_address( &rb_cKeepalive );
+	rb_gc_register_address( &rb_cXLogData );
+	rb_gc_register_address( &rb_cBegin );
+	rb_gc_register_address( &rb_cCommit );
+	rb_gc_register_address( &rb_cRelation );
+	rb_gc_register_address( &rb_cColumn );
+	rb_gc_register_address( &rb_cInsert );
+	rb_gc_register_address( &rb_cUpdate );
+	rb_gc_register_address( &rb_cDelete );
+	rb_gc_register_address( &rb_cTruncate );
+	rb_gc_register_address( &rb_cOther );
+
+	s_sym_unchanged_toast = ID2SYM( rb_intern("unchanged_toast") );
+}
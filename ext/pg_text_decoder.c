@@ -41,6 +41,10 @@
 #include <sys/socket.h>
 #endif
 #include <string.h>
+#include <math.h>
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+#include "ruby/ractor.h"
+#endif
 
 VALUE rb_mPG_TextDecoder;
 static ID s_id_Rational;
@@ -53,6 +57,16 @@ static VALUE s_IPAddr;
 static VALUE s_vmasks4;
 static VALUE s_vmasks6;
 static VALUE s_nan, s_pos_inf, s_neg_inf;
+static VALUE s_Date;
+static VALUE s_Date_GREGORIAN;
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+static rb_ractor_local_key_t s_date_cache_key;
+#else
+static VALUE s_date_cache;
+#endif
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+static rb_ractor_local_key_t s_timestamp_cache_key;
+#endif
 static int use_ipaddr_alloc;
 static ID s_id_lshift;
 static ID s_id_add;
@@ -100,58 +114,23 @@ pg_text_dec_string(t_pg_coder *conv, const char *val, int len, int tuple, int fi
  * to Ruby Integer objects.
  *
  */
-static VALUE
+VALUE
 pg_text_dec_integer(t_pg_coder *conv, const char *val, int len, int tuple, int field, int enc_idx)
 {
-	long i;
-	int max_len;
-
-	if( sizeof(i) >= 8 && FIXNUM_MAX >= 1000000000000000000LL ){
-		/* 64 bit system can safely handle all numbers up to 18 digits as Fixnum */
-		max_len = 18;
-	} else if( sizeof(i) >= 4 && FIXNUM_MAX >= 1000000000LL ){
-		/* 32 bit system can safely handle all numbers up to 9 digits as Fixnum */
-		max_len = 9;
-	} else {
-		/* unknown -> don't use fast path for int conversion */
-		max_len = 0;
-	}
-
-	if( len <= max_len ){
-		/* rb_cstr2inum() seems to be slow, so we do the int conversion by hand.
-		 * This proved to be 40% faster by the following benchmark:
-		 *
-		 *   conn.type_mapping_for_results = PG::BasicTypeMapForResults.new conn
-		 *   Benchmark.measure do
-		 *     conn.exec("select generate_series(1,1000000)").values }
-		 *   end
-		 */
-		const char *val_pos = val;
-		char digit = *val_pos;
-		int neg;
-		int error = 0;
-
-		if( digit=='-' ){
-			neg = 1;
-			i = 0;
-		}else if( digit>='0' && digit<='9' ){
-			neg = 0;
-			i = digit - '0';
-		} else {
-			error = 1;
-		}
+	int64_t i;
 
-		while (!error && (digit=*++val_pos)) {
-			if( digit>='0' && digit<='9' ){
-				i = i * 10 + (digit - '0');
-			} else {
-				error = 1;
-			}
-		}
-
-		if( !error ){
-			return LONG2FIX(neg ? -i : i);
-		}
+	/* rb_cstr2inum() seems to be slow, so we do the int conversion by hand.
+	 * This proved to be 40% faster by the following benchmark:
+	 *
+	 *   conn.type_mapping_for_results = PG::BasicTypeMapForResults.new conn
+	 *   Benchmark.measure do
+	 *     conn.exec("select generate_series(1,1000000)").values }
+	 *   end
+	 *
+	 * See sample/integer_decoder_benchmark.rb for the SWAR parser.
+	 */
+	if( rbpg_parse_int64(val, val + len, &i) ){
+		return LL2NUM(i);
 	}
 	/* Fallback to ruby method if number too big or unrecognized. */
 	return rb_cstr2inum(val, 10);
@@ -163,12 +142,70 @@ pg_text_dec_integer(t_pg_coder *conv, const char *val, int len, int tuple, int f
  * This is a decoder class for conversion of PostgreSQL numeric types
  * to Ruby BigDecimal objects.
  *
+ * The target classes can be chosen per PG::Coder#flags= :
+ * * PG::Coder::NUMERIC_TO_INTEGER returns an Integer for values without fractional part or
+ *   with fractional digits that are all zero, like +42+ or +42.00+ .
+ * * PG::Coder::NUMERIC_TO_FLOAT returns a Float for values with at most 15 significant digits
+ *   (Float::DIG) within the normalized range of Float, so that Float#to_s gives back the same decimal value.
+ *   Values with more digits and values beyond the Float range, like +1e-400+ , stay BigDecimal.
+ *   NaN and Infinity are returned as Float.
+ *
+ * All other values are returned as BigDecimal.
+ * The same flags can be set per #to_integer= and #to_float= .
+ *
  * As soon as this class is used, it requires the 'bigdecimal' gem.
  *
  */
-static VALUE
+VALUE
 pg_text_dec_numeric(t_pg_coder *conv, const char *val, int len, int tuple, int field, int enc_idx)
 {
+	int flags = conv->flags;
+
+	if( flags & (PG_CODER_NUMERIC_TO_INTEGER | PG_CODER_NUMERIC_TO_FLOAT) ){
+		const char *p = val, *end = val + len;
+		const char *int_start, *int_end, *frac_end;
+
+		if( p < end && *p == '-' ) p++;
+		int_start = p;
+		while( p < end && (unsigned char)(*p - '0') <= 9 ) p++;
+		int_end = frac_end = p;
+		if( p < end && *p == '.' ){
+			/* frac_end points behind the last non-zero fractional digit */
+			for( p++; p < end && (unsigned char)(*p - '0') <= 9; p++ ){
+				if( *p != '0' ) frac_end = p + 1;
+			}
+		}
+
+		if( p == end && int_end > int_start ){
+			if( (flags & PG_CODER_NUMERIC_TO_INTEGER) && frac_end == int_end ){
+				int64_t i;
+				if( rbpg_parse_int64(val, int_end, &i) ){
+					return LL2NUM(i);
+				}
+				return rb_str_to_inum(rb_str_new(val, int_end - val), 10, 0);
+			}
+			if( flags & PG_CODER_NUMERIC_TO_FLOAT ){
+				const char *s = int_start;
+				int nsig = 0;
+				double d;
+
+				while( s < frac_end && (*s == '0' || *s == '.') ) s++;
+				for( ; s < frac_end; s++ ){
+					if( *s != '.' ) nsig++;
+				}
+				/* Up to DBL_DIG (15) significant digits are preserved by the conversion to double and back.
+				 * Values which are subnormal or underflow to zero are rejected by rbpg_parse_double(),
+				 * but zero is checked here as well, since precision is lost otherwise. */
+				if( nsig <= 15 && rbpg_parse_double(val, frac_end, &d) && !isinf(d) && (d != 0.0 || nsig == 0) ){
+					return rb_float_new(d);
+				}
+			}
+		} else if( flags & PG_CODER_NUMERIC_TO_FLOAT ){
+			if( len == 3 && memcmp(val, "NaN", 3) == 0 ) return s_nan;
+			if( len == 8 && memcmp(val, "Infinity", 8) == 0 ) return s_pos_inf;
+			if( len == 9 && memcmp(val, "-Infinity", 9) == 0 ) return s_neg_inf;
+		}
+	}
 	return rb_funcall(rb_cObject, s_id_BigDecimal, 1, rb_str_new(val, len));
 }
 
@@ -177,7 +214,6 @@ static VALUE
 init_pg_text_decoder_numeric(VALUE rb_mPG_TextDecoder)
 {
 	rb_funcall(rb_mPG, rb_intern("require_bigdecimal_without_warning"), 0);
-	s_id_BigDecimal = rb_intern("BigDecimal");
 
 	/* dummy = rb_define_class_under( rb_mPG_TextDecoder, "Numeric", rb_cPG_SimpleDecoder ); */
 	pg_define_coder( "Numeric", pg_text_dec_numeric, rb_cPG_SimpleDecoder, rb_mPG_TextDecoder );
@@ -195,6 +231,8 @@ init_pg_text_decoder_numeric(VALUE rb_mPG_TextDecoder)
 static VALUE
 pg_text_dec_float(t_pg_coder *conv, const char *val, int len, int tuple, int field, int enc_idx)
 {
+	double d;
+
 	switch(*val) {
 		case 'N':
 			return s_nan;
@@ -203,10 +241,13 @@ pg_text_dec_float(t_pg_coder *conv, const char *val, int len, int tuple, int fie
 		case '-':
 			if (val[1] == 'I') {
 				return s_neg_inf;
-			} else {
-				return rb_float_new(rb_cstr_to_dbl(val, Qfalse));
 			}
+			/* fall through */
 		default:
+			/* Eisel-Lemire parser with fallback to strtod for more than 19 digits or subnormal numbers */
+			if( rbpg_parse_double(val, val + len, &d) ){
+				return rb_float_new(d);
+			}
 			return rb_float_new(rb_cstr_to_dbl(val, Qfalse));
 	}
 }
@@ -620,6 +661,115 @@ static int parse_year(const char **str) {
 	return year;
 }
 
+/*
+ * Number of columns kept in the timestamp cache.
+ * Columns beyond this number share the entries of lower columns.
+ */
+#define TIMESTAMP_CACHE_COLUMNS 32
+
+static void
+pg_timestamp_cache_mark(void *ptr)
+{
+	t_pg_timestamp_cache_entry *entries = ptr;
+	int i;
+
+	for( i = 0; i < TIMESTAMP_CACHE_COLUMNS; i++ ){
+		rb_gc_mark(entries[i].time);
+	}
+}
+
+static void
+pg_timestamp_cache_free(void *ptr)
+{
+	xfree(ptr);
+}
+
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+static const struct rb_ractor_local_storage_type pg_timestamp_cache_type = {
+	pg_timestamp_cache_mark,
+	pg_timestamp_cache_free,
+};
+#else
+static t_pg_timestamp_cache_entry s_timestamp_cache[TIMESTAMP_CACHE_COLUMNS];
+#endif
+
+/*
+ * Return the cache entry of the given column for the current Ractor.
+ *
+ * The entry is invalidated if it was filled by a coder with a different format or flags.
+ */
+t_pg_timestamp_cache_entry *
+pg_timestamp_cache_entry(t_pg_coder *conv, int field)
+{
+	t_pg_timestamp_cache_entry *entry;
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+	t_pg_timestamp_cache_entry *entries = rb_ractor_local_storage_ptr(s_timestamp_cache_key);
+	if( !entries ){
+		int i;
+		entries = ALLOC_N(t_pg_timestamp_cache_entry, TIMESTAMP_CACHE_COLUMNS);
+		for( i = 0; i < TIMESTAMP_CACHE_COLUMNS; i++ ){
+			entries[i].format = -1;
+			entries[i].time = Qnil;
+			entries[i].day = 0;
+		}
+		rb_ractor_local_storage_ptr_set(s_timestamp_cache_key, entries);
+	}
+#else
+	t_pg_timestamp_cache_entry *entries = s_timestamp_cache;
+#endif
+
+	entry = &entries[(field < 0 ? 0 : field) % TIMESTAMP_CACHE_COLUMNS];
+	if( entry->format != conv->format || entry->flags != conv->flags ){
+		entry->format = conv->format;
+		entry->flags = conv->flags;
+		entry->len = -1;
+		entry->time = Qnil;
+		entry->day = 0;
+	}
+	return entry;
+}
+
+/*
+ * Store a decoded timestamp in the cache entry and return it frozen.
+ * String values like "infinity" are not cached.
+ */
+VALUE
+pg_timestamp_cache_store(t_pg_timestamp_cache_entry *entry, const char *val, int len, VALUE time)
+{
+	if( !RB_TYPE_P(time, T_STRING) && len <= PG_TIMESTAMP_CACHE_RAW_LEN ){
+		rb_obj_freeze(time);
+		memcpy(entry->raw, val, len);
+		entry->len = len;
+		entry->time = time;
+	}
+	return time;
+}
+
+#if (RUBY_API_VERSION_MAJOR > 2 || (RUBY_API_VERSION_MAJOR == 2 && RUBY_API_VERSION_MINOR >= 3)) && defined(HAVE_TIMEGM)
+/*
+ * Like timegm(), but reuses the result of the previous date part of the column, if available.
+ */
+static time_t
+pg_timegm_cached(struct tm *tm, t_pg_timestamp_cache_entry *entry)
+{
+	time_t time;
+	int day_time = tm->tm_hour * 3600 + tm->tm_min * 60 + tm->tm_sec;
+
+	if( entry && entry->day == tm->tm_mday && entry->mon == tm->tm_mon + 1 && entry->year == tm->tm_year + 1900 ){
+		return entry->day_sec + day_time;
+	}
+	time = timegm(tm);
+	if( entry && time != -1 ){
+		/* tm_mday is never 0, so that day 0 marks an empty entry */
+		entry->year = tm->tm_year + 1900;
+		entry->mon = tm->tm_mon + 1;
+		entry->day = tm->tm_mday;
+		entry->day_sec = time - day_time;
+	}
+	return time;
+}
+#endif
+
 #define TZ_NEG 1
 #define TZ_POS 2
 
@@ -635,12 +785,18 @@ static int parse_year(const char **str) {
  * * +PG::Coder::TIMESTAMP_APP_UTC+ : Return timestamp as UTC time (default)
  * * +PG::Coder::TIMESTAMP_APP_LOCAL+ : Return timestamp as local time
  *
+ * The flag +PG::Coder::TIMESTAMP_CACHE+ enables a cache of the last decoded timestamp per column.
+ * A repeated value of a column returns the same Time object, which is therefore frozen.
+ * Frozen Time objects can not be converted in place by Time#localtime or Time#utc .
+ * Use Time#getlocal or Time#getutc instead.
+ * The date part of the previous value is reused as well, if the timestamp is given with time zone or interpreted as UTC.
+ *
  * Example:
  *   deco = PG::TextDecoder::Timestamp.new(flags: PG::Coder::TIMESTAMP_DB_UTC | PG::Coder::TIMESTAMP_APP_LOCAL)
  *   deco.decode("2000-01-01 00:00:00")  # => 2000-01-01 01:00:00 +0100
  *   deco.decode("2000-01-01 00:00:00.123-06")  # => 2000-01-01 00:00:00 -0600
  */
-static VALUE pg_text_dec_timestamp(t_pg_coder *conv, const char *val, int len, int tuple, int field, int enc_idx)
+static VALUE pg_text_dec_timestamp_parse(t_pg_coder *conv, const char *val, int len, int tuple, int field, int enc_idx, t_pg_timestamp_cache_entry *entry)
 {
 	const char *str = val;
 	int year, mon, day;
@@ -722,7 +878,7 @@ static VALUE pg_text_dec_timestamp(t_pg_coder *conv, const char *val, int len, i
 
 			if (tz_given) {
 				/* with timezone */
-				time_t time = timegm(&tm);
+				time_t time = pg_timegm_cached(&tm, entry);
 				if (time != -1){
 					int gmt_offset;
 
@@ -742,7 +898,7 @@ static VALUE pg_text_dec_timestamp(t_pg_coder *conv, const char *val, int len, i
 				if( conv->flags & PG_CODER_TIMESTAMP_DB_LOCAL ) {
 					time = mktime(&tm);
 				} else {
-					time = timegm(&tm);
+					time = pg_timegm_cached(&tm, entry);
 				}
 				if (time != -1){
 					ts.tv_sec = time;
@@ -807,6 +963,152 @@ static VALUE pg_text_dec_timestamp(t_pg_coder *conv, const char *val, int len, i
 	return pg_text_dec_string(conv, val, len, tuple, field, enc_idx);
 }
 
+static VALUE pg_text_dec_timestamp(t_pg_coder *conv, const char *val, int len, int tuple, int field, int enc_idx)
+{
+	t_pg_timestamp_cache_entry *entry;
+
+	if( !(conv->flags & PG_CODER_TIMESTAMP_CACHE) ){
+		return pg_text_dec_timestamp_parse(conv, val, len, tuple, field, enc_idx, NULL);
+	}
+
+	entry = pg_timestamp_cache_entry(conv, field);
+	if( entry->len == len && memcmp(entry->raw, val, len) == 0 ){
+		return entry->time;
+	}
+	return pg_timestamp_cache_store(entry, val, len,
+			pg_text_dec_timestamp_parse(conv, val, len, tuple, field, enc_idx, entry));
+}
+
+/*
+ * Number of columns and Date objects per column kept in the cache of PG::TextDecoder::Date .
+ * The cache is an Array of DATE_CACHE_COLUMNS * DATE_CACHE_WAYS pairs of key and Date object
+ * followed by the next slot to be replaced per column and the flags of the coder which filled the column.
+ */
+#define DATE_CACHE_COLUMNS 16
+#define DATE_CACHE_WAYS 4
+#define DATE_CACHE_NEXT_POS (DATE_CACHE_COLUMNS * DATE_CACHE_WAYS * 2)
+#define DATE_CACHE_FLAGS_POS (DATE_CACHE_NEXT_POS + DATE_CACHE_COLUMNS)
+#define DATE_CACHE_SIZE (DATE_CACHE_FLAGS_POS + DATE_CACHE_COLUMNS)
+
+/*
+ * Return the cache of the current Ractor.
+ * Cached Date objects must not be passed to other Ractors.
+ */
+static VALUE
+pg_text_dec_date_cache(void)
+{
+	VALUE cache;
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+	if( !rb_ractor_local_storage_value_lookup(s_date_cache_key, &cache) ){
+		cache = rb_ary_new_capa( DATE_CACHE_SIZE );
+		rb_ary_resize( cache, DATE_CACHE_SIZE );
+		rb_ractor_local_storage_value_set( s_date_cache_key, cache );
+	}
+#else
+	cache = s_date_cache;
+#endif
+	return cache;
+}
+
+/*
+ * Document-class: PG::TextDecoder::Date < PG::SimpleDecoder
+ *
+ * This is a decoder class for conversion of PostgreSQL text date
+ * to Ruby Date objects.
+ *
+ * Dates of the ISO format <tt>YYYY-MM-DD</tt> and <tt>YYYY-MM-DD BC</tt> are decoded to Date objects of the proleptic gregorian calendar.
+ * The values +infinity+ and +-infinity+ and dates of other DateStyle settings are returned as String.
+ *
+ * The last few dates of each column are cached, so that repeated dates return the same Date object.
+ * All returned Date objects are therefore frozen.
+ * Use <tt>Date#dup</tt> to get a modifiable copy.
+ * The cache is kept per Ractor and is invalidated per column, when the column is decoded by a coder with different flags.
+ *
+ * As soon as this class is used, it requires the ruby standard library 'date'.
+ */
+static VALUE
+pg_text_dec_date(t_pg_coder *conv, const char *val, int len, int tuple, int field, int enc_idx)
+{
+	const char *str = val;
+	int year, mon, day;
+	long key, col, i;
+	VALUE cache, date;
+
+	year = parse_year(&str);
+
+	if( str - val < 4 || str[0] != '-' || !isdigit(str[1]) || !isdigit(str[2]) ||
+			str[3] != '-' || !isdigit(str[4]) || !isdigit(str[5]) ){
+		return rb_enc_str_new(val, len, rb_enc_from_index(enc_idx));
+	}
+	mon = str2_to_int(str+1);
+	day = str2_to_int(str+4);
+	str += 6;
+	if( str[0] == ' ' && str[1] == 'B' && str[2] == 'C' ){
+		year = -year + 1;
+		str += 3;
+	}
+	if( str != val + len ){
+		return rb_enc_str_new(val, len, rb_enc_from_index(enc_idx));
+	}
+
+	/* Lookup the date in the cache of the column */
+	key = (long)year * 10000 + mon * 100 + day;
+	cache = pg_text_dec_date_cache();
+	col = (field < 0 ? 0 : field) % DATE_CACHE_COLUMNS;
+	if( RARRAY_AREF(cache, DATE_CACHE_FLAGS_POS + col) != INT2FIX(conv->flags) ){
+		/* The column was filled by another coder */
+		for( i = 0; i < DATE_CACHE_WAYS; i++ ){
+			rb_ary_store(cache, (col * DATE_CACHE_WAYS + i) * 2, Qnil);
+		}
+		rb_ary_store(cache, DATE_CACHE_FLAGS_POS + col, INT2FIX(conv->flags));
+	}
+	for( i = 0; i < DATE_CACHE_WAYS; i++ ){
+		long pos = (col * DATE_CACHE_WAYS + i) * 2;
+		if( RARRAY_AREF(cache, pos) == LONG2FIX(key) ){
+			return RARRAY_AREF(cache, pos + 1);
+		}
+	}
+
+	date = rb_funcall(s_Date, s_id_new, 4, INT2NUM(year), INT2NUM(mon), INT2NUM(day), s_Date_GREGORIAN);
+	rb_obj_freeze(date);
+
+	/* Replace the cache entries of the column round robin */
+	{
+		long next_pos = DATE_CACHE_NEXT_POS + col;
+		VALUE next = RARRAY_AREF(cache, next_pos);
+		long way = NIL_P(next) ? 0 : FIX2LONG(next);
+		long pos = (col * DATE_CACHE_WAYS + way) * 2;
+		rb_ary_store(cache, pos, LONG2FIX(key));
+		rb_ary_store(cache, pos + 1, date);
+		rb_ary_store(cache, next_pos, LONG2FIX((way + 1) % DATE_CACHE_WAYS));
+	}
+
+	return date;
+}
+
+/* called per autoload when TextDecoder::Date is used */
+static VALUE
+init_pg_text_decoder_date(VALUE rb_mPG_TextDecoder)
+{
+	rb_require("date");
+	rb_gc_register_address(&s_Date);
+	rb_gc_register_address(&s_Date_GREGORIAN);
+	s_Date = rb_const_get(rb_cObject, rb_intern("Date"));
+	s_Date_GREGORIAN = rb_const_get(s_Date, rb_intern("GREGORIAN"));
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+	s_date_cache_key = rb_ractor_local_storage_value_newkey();
+#else
+	rb_gc_register_address(&s_date_cache);
+	s_date_cache = rb_ary_new_capa( DATE_CACHE_SIZE );
+	rb_ary_resize( s_date_cache, DATE_CACHE_SIZE );
+#endif
+
+	/* dummy = rb_define_class_under( rb_mPG_TextDecoder, "Date", rb_cPG_SimpleDecoder ); */
+	pg_define_coder( "Date", pg_text_dec_date, rb_cPG_SimpleDecoder, rb_mPG_TextDecoder );
+
+	return Qnil;
+}
+
 /*
  * Document-class: PG::TextDecoder::Inet < PG::SimpleDecoder
  *
@@ -972,6 +1274,7 @@ init_pg_text_decoder(void)
 	s_id_new = rb_intern("new");
 	s_id_utc = rb_intern("utc");
 	s_id_getlocal = rb_intern("getlocal");
+	s_id_BigDecimal = rb_intern("BigDecimal");
 
 	rb_gc_register_address(&s_nan);
 	rb_gc_register_address(&s_pos_inf);
@@ -980,10 +1283,24 @@ init_pg_text_decoder(void)
 	s_pos_inf = rb_eval_string("1.0/0.0");
 	s_neg_inf = rb_eval_string("-1.0/0.0");
 
+#ifdef HAVE_RB_EXT_RACTOR_SAFE
+	s_timestamp_cache_key = rb_ractor_local_storage_ptr_newkey(&pg_timestamp_cache_type);
+#else
+	{
+		int i;
+		for( i = 0; i < TIMESTAMP_CACHE_COLUMNS; i++ ){
+			s_timestamp_cache[i].format = -1;
+			s_timestamp_cache[i].time = Qnil;
+			rb_gc_register_address(&s_timestamp_cache[i].time);
+		}
+	}
+#endif
+
 	/* This module encapsulates all decoder classes with text input format */
 	rb_mPG_TextDecoder = rb_define_module_under( rb_mPG, "TextDecoder" );
 	rb_define_private_method(rb_singleton_class(rb_mPG_TextDecoder), "init_inet", init_pg_text_decoder_inet, 0);
 	rb_define_private_method(rb_singleton_class(rb_mPG_TextDecoder), "init_numeric", init_pg_text_decoder_numeric, 0);
+	rb_define_private_method(rb_singleton_class(rb_mPG_TextDecoder), "init_date", init_pg_text_decoder_date, 0);
 
 	/* Make RDoc aware of the decoder classes... */
 	/* dummy = rb_define_class_under( rb_mPG_TextDecoder, "Boolean", rb_cPG_SimpleDecoder ); */
@@ -53,6 +53,11 @@ static ID s_id_to_i;
 static ID s_id_to_s;
 static ID s_cBigDecimal;
 static VALUE s_str_F;
+static ID s_id_gregorianP;
+static ID s_id_gregorian;
+static ID s_id_jd;
+static ID s_id_strftime;
+static VALUE s_str_date_format;
 
 static int pg_text_enc_integer(t_pg_coder *this, VALUE value, char *out, VALUE *intermediate, int enc_idx);
 
@@ -222,23 +227,26 @@ pg_text_enc_integer(t_pg_coder *this, VALUE value, char *out, VALUE *intermediat
 	}
 }
 
-#define MAX_DOUBLE_DIGITS 16
+/* sign, 17 digits, dot, "e-308" */
+#define MAX_DOUBLE_LEN 24
 
 /*
  * Document-class: PG::TextEncoder::Float < PG::SimpleEncoder
  *
  * This is the encoder class for the PostgreSQL float types.
  *
+ * Floats are written with the shortest number of digits that reads back to the same value.
+ * Numbers with a decimal exponent below -4 or above 14 are written in exponent format like <tt>1.5e20</tt>.
+ *
  */
 static int
 pg_text_enc_float(t_pg_coder *conv, VALUE value, char *out, VALUE *intermediate1, int enc_idx)
 {
 	if(out){
 		double dvalue = NUM2DBL(value);
-		int len = 0;
-		int neg = 0;
-		int exp2i, exp10i, i;
-		unsigned long long ll, remainder, oldval;
+		char *start = out;
+		char digits[17];
+		int ndigits, exp10, decpt, i;
 
 		/* Cast to the same strings as value.to_s . */
 		if( isinf(dvalue) ){
@@ -254,90 +262,63 @@ pg_text_enc_float(t_pg_coder *conv, VALUE value, char *out, VALUE *intermediate1
 			return 3;
 		}
 
-		/*
-		 * The following computation is roughly a conversion kind of
-		 *   sprintf( out, "%.16E", dvalue);
-		 */
-
 		/* write the algebraic sign */
-		if( dvalue < 0 ) {
+		if( signbit(dvalue) ) {
 			dvalue = -dvalue;
 			*out++ = '-';
-			neg++;
 		}
-
-		/* retrieve the power of 2 exponent */
-		frexp(dvalue, &exp2i);
-		/* compute the power of 10 exponent */
-		exp10i = (int)floor(exp2i * 0.30102999566398114); /* Math.log(2)/Math.log(10) */
-		/* move the decimal point, so that we get an integer of MAX_DOUBLE_DIGITS decimal digits */
-		ll = (unsigned long long)(dvalue * pow(10, MAX_DOUBLE_DIGITS - 1 - exp10i) + 0.5);
-
-		/* avoid leading zeros due to inaccuracy of deriving exp10i from exp2i */
-		/* otherwise we would print "09.0" instead of "9.0" */
-		if( ll < 1000000000000000 ){ /* pow(10, MAX_DOUBLE_DIGITS-1) */
-			exp10i--;
-			ll *= 10;
+		if( dvalue == 0 ){
+			memcpy( out, "0.0", 3 );
+			return (int)(out - start) + 3;
 		}
 
-		if( exp10i <= -5 || exp10i >= 15 ) {
-			/* Write the float in exponent format (1.23e45) */
-			VALUE intermediate;
+		ndigits = rbpg_dtoa_shortest(dvalue, digits, &exp10);
+		/* number of digits left to the decimal point */
+		decpt = ndigits + exp10;
 
-			/* write fraction digits from right to left */
-			for( i = MAX_DOUBLE_DIGITS; i > 1; i--){
-				oldval = ll;
-				ll /= 10;
-				remainder = oldval - ll * 10;
-				/* omit trailing zeros */
-				if(remainder != 0 || len ) {
-					out[i] = '0' + remainder;
-					len++;
-				}
+		if( decpt - 1 <= -5 || decpt - 1 >= 15 ) {
+			/* Write the float in exponent format (1.23e45) */
+			int e = decpt - 1;
+			char ebuf[4];
+			int elen = 0;
+
+			*out++ = digits[0];
+			if( ndigits > 1 ){
+				*out++ = '.';
+				memcpy( out, digits + 1, ndigits - 1 );
+				out += ndigits - 1;
 			}
-
-			/* write decimal point */
-			if( len ){
-				out[1] = '.';
-				len++;
+			*out++ = 'e';
+			if( e < 0 ){
+				*out++ = '-';
+				e = -e;
 			}
-
-			/* write remaining single digit left to the decimal point */
-			oldval = ll;
-			ll /= 10;
-			remainder = oldval - ll * 10;
-			out[0] = '0' + remainder;
-			len++;
-
-			/* write exponent */
-			out[len++] = 'e';
-			intermediate = INT2NUM(exp10i);
-
-			return neg + len + pg_text_enc_integer(conv, Qnil, out + len, &intermediate, enc_idx);
+			do {
+				ebuf[elen++] = '0' + e % 10;
+				e /= 10;
+			} while( e );
+			while( elen ) *out++ = ebuf[--elen];
+		} else if( decpt <= 0 ) {
+			/* write the float in non exponent format (0.001234) */
+			*out++ = '0';
+			*out++ = '.';
+			for( i = decpt; i < 0; i++ ) *out++ = '0';
+			memcpy( out, digits, ndigits );
+			out += ndigits;
 		} else {
-			/* write the float in non exponent format (0.001234 or 123450.0) */
-
-			/* write digits from right to left */
-			int lz = exp10i < 0 ? 0 : exp10i;
-			for( i = MAX_DOUBLE_DIGITS - (exp10i < 0 ? exp10i : 0); i >= 0; i-- ){
-				oldval = ll;
-				ll /= 10;
-				remainder = oldval - ll * 10;
-				/* write decimal point */
-				if( i - 1 == lz ){
-					out[i--] = '.';
-					len++;
-				}
-				/* if possible then omit trailing zeros */
-				if(remainder != 0 || len || i - 2 == lz) {
-					out[i] = '0' + remainder;
-					len++;
-				}
+			/* write the float in non exponent format (123450.0 or 1.2345) */
+			for( i = 0; i < decpt; i++ ) *out++ = i < ndigits ? digits[i] : '0';
+			*out++ = '.';
+			if( ndigits > decpt ){
+				memcpy( out, digits + decpt, ndigits - decpt );
+				out += ndigits - decpt;
+			} else {
+				*out++ = '0';
 			}
-			return neg + len;
 		}
+		return (int)(out - start);
 	}else{
-		return 1 /*sign*/ + MAX_DOUBLE_DIGITS + 1 /*dot*/ + 1 /*e*/ + 1 /*exp sign*/ + 3 /*exp digits*/;
+		return MAX_DOUBLE_LEN;
 	}
 }
 
@@ -392,6 +373,86 @@ init_pg_text_encoder_numeric(VALUE rb_mPG_TextDecoder)
 	return Qnil;
 }
 
+/*
+ * Document-class: PG::TextEncoder::Date < PG::SimpleEncoder
+ *
+ * This is a encoder class for conversion of Ruby Date objects to PostgreSQL date type.
+ *
+ * Date and DateTime objects are written as <tt>YYYY-MM-DD</tt> of the proleptic gregorian calendar.
+ * Dates before year 1 are written with suffix <tt>BC</tt>.
+ * Other values are sent as their string representation, so that a String like <tt>"infinity"</tt> can be used as well.
+ *
+ */
+static int
+pg_text_enc_date(t_pg_coder *this, VALUE value, char *out, VALUE *intermediate, int enc_idx)
+{
+	if(out){
+		int year, mon, day, bc = 0;
+		char *start = out;
+
+		pg_j2date(NUM2INT(*intermediate), &year, &mon, &day);
+		if( year <= 0 ){
+			year = -year + 1;
+			bc = 1;
+		}
+		if( year >= 10000 ){
+			out += sprintf(out, "%d", year);
+		} else {
+			*out++ = '0' + year / 1000;
+			*out++ = '0' + year / 100 % 10;
+			*out++ = '0' + year / 10 % 10;
+			*out++ = '0' + year % 10;
+		}
+		*out++ = '-';
+		*out++ = '0' + mon / 10;
+		*out++ = '0' + mon % 10;
+		*out++ = '-';
+		*out++ = '0' + day / 10;
+		*out++ = '0' + day % 10;
+		if( bc ){
+			memcpy(out, " BC", 3);
+			out += 3;
+		}
+		return (int)(out - start);
+	}else{
+		VALUE jd;
+
+		if( !rb_respond_to(value, s_id_gregorianP) ){
+			return pg_coder_enc_to_s(this, value, out, intermediate, enc_idx);
+		}
+		/* The julian day number doesn't depend on the calendar reform of the Date object */
+		jd = rb_funcall(value, s_id_jd, 0);
+		if( !FIXNUM_P(jd) || FIX2LONG(jd) < -32044 || FIX2LONG(jd) > 0x7FFFFFFF - 32044 - 146097 ){
+			/* Out of range of PostgreSQL and of pg_j2date() */
+			if( rb_funcall(value, s_id_gregorianP, 0) != Qtrue )
+				value = rb_funcall(value, s_id_gregorian, 0);
+			*intermediate = rb_funcall(value, s_id_strftime, 1, s_str_date_format);
+			return pg_coder_enc_to_s(this, *intermediate, NULL, intermediate, enc_idx);
+		}
+		*intermediate = jd;
+		/* 7 digits year, month, day and " BC" */
+		return 16;
+	}
+}
+
+/* called per autoload when TextEncoder::Date is used */
+static VALUE
+init_pg_text_encoder_date(VALUE rb_mPG_TextEncoder)
+{
+	rb_require("date");
+	rb_gc_register_address(&s_str_date_format);
+	s_str_date_format = rb_str_freeze(rb_str_new_cstr("%Y-%m-%d"));
+	s_id_gregorianP = rb_intern("gregorian?");
+	s_id_gregorian = rb_intern("gregorian");
+	s_id_jd = rb_intern("jd");
+	s_id_strftime = rb_intern("strftime");
+
+	/* dummy = rb_define_class_under( rb_mPG_TextEncoder, "Date", rb_cPG_SimpleEncoder ); */
+	pg_define_coder( "Date", pg_text_enc_date, rb_cPG_SimpleEncoder, rb_mPG_TextEncoder );
+
+	return Qnil;
+}
+
 
 static const char hextab[] = {
 	'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'
@@ -827,6 +888,7 @@ init_pg_text_encoder(void)
 	/* This module encapsulates all encoder classes with text output format */
 	rb_mPG_TextEncoder = rb_define_module_under( rb_mPG, "TextEncoder" );
 	rb_define_private_method(rb_singleton_class(rb_mPG_TextEncoder), "init_numeric", init_pg_text_encoder_numeric, 0);
+	rb_define_private_method(rb_singleton_class(rb_mPG_TextEncoder), "init_date", init_pg_text_encoder_date, 0);
 
 	/* Make RDoc aware of the encoder classes... */
 	/* dummy = rb_define_class_under( rb_mPG_TextEncoder, "Boolean", rb_cPG_SimpleEncoder ); */
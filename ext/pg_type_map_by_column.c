@@ -265,6 +265,7 @@ pg_tmbc_init(VALUE self, VALUE conv_ary)
 {
 	long i;
 	t_tmbc *this;
+	t_tmbc *prev = RTYPEDDATA_DATA(self);
 	int conv_ary_len;
 
 	rb_check_frozen(self);
@@ -273,6 +274,8 @@ pg_tmbc_init(VALUE self, VALUE conv_ary)
 	this = xmalloc(sizeof(t_tmbc) + sizeof(struct pg_tmbc_converter) * conv_ary_len);
 	/* Set nfields to 0 at first, so that GC mark function doesn't access uninitialized memory. */
 	this->nfields = 0;
+	/* Invalidate plans of PG::CopyCoder compiled from the previous coders. */
+	this->generation = prev == (t_tmbc *)&pg_typemap_funcs ? 0 : prev->generation + 1;
 	this->typemap.funcs = pg_tmbc_funcs;
 	RB_OBJ_WRITE(self, &this->typemap.default_typemap, pg_typemap_all_strings);
 	RTYPEDDATA_DATA(self) = this;
@@ -66,6 +66,7 @@ pg_tmbo_build_type_map_for_result2( t_tmbo *this, PGresult *pgresult )
 	p_colmap = xmalloc(sizeof(t_tmbc) + sizeof(struct pg_tmbc_converter) * nfields);
 	/* Set nfields to 0 at first, so that GC mark function doesn't access uninitialized memory. */
 	p_colmap->nfields = 0;
+	p_colmap->generation = 0;
 	p_colmap->typemap.funcs = pg_tmbc_funcs;
 	p_colmap->typemap.default_typemap = pg_typemap_all_strings;
 
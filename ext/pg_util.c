@@ -7,6 +7,15 @@
 #include "pg.h"
 #include "pg_util.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSE2__) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+/* AVX2 is compiled per function attribute and selected at runtime */
+#define RBPG_HAVE_AVX2
+#include <immintrin.h>
+#endif
+
 static const char base64_encode_table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
 /* Encode _len_ bytes at _in_ as base64 and write output to _out_.
@@ -147,3 +156,266 @@ rbpg_strncasecmp(const char *s1, const char *s2, size_t n)
 	return 0;
 }
 
+
+#if !defined(WORDS_BIGENDIAN)
+/*
+ * Check whether all 8 bytes are ASCII digits.
+ */
+static inline int
+swar_is_8digits(uint64_t w)
+{
+	return ((w & UINT64_C(0xF0F0F0F0F0F0F0F0)) |
+			(((w + UINT64_C(0x0606060606060606)) & UINT64_C(0xF0F0F0F0F0F0F0F0)) >> 4)) ==
+			UINT64_C(0x3333333333333333);
+}
+
+/*
+ * Convert 8 ASCII digits (in little endian memory order) to their value.
+ * Adjacent digits are combined to pairs, then to quadruples and finally to the result by three multiplications.
+ */
+static inline uint32_t
+swar_parse_8digits(uint64_t w)
+{
+	w = ((w & UINT64_C(0x0F0F0F0F0F0F0F0F)) * 2561) >> 8;
+	w = ((w & UINT64_C(0x00FF00FF00FF00FF)) * 6553601) >> 16;
+	return (uint32_t)(((w & UINT64_C(0x0000FFFF0000FFFF)) * UINT64_C(42949672960001)) >> 32);
+}
+
+/*
+ * Same as swar_is_8digits() and swar_parse_8digits() but for 4 digits.
+ */
+static inline int
+swar_is_4digits(uint32_t w)
+{
+	return ((w & 0xF0F0F0F0) | (((w + 0x06060606) & 0xF0F0F0F0) >> 4)) == 0x33333333;
+}
+
+static inline uint32_t
+swar_parse_4digits(uint32_t w)
+{
+	w = ((w & 0x0F0F0F0F) * 2561) >> 8;
+	return ((w & 0x00FF00FF) * 6553601) >> 16;
+}
+#endif
+
+/*
+ * Parse a decimal integer with optional minus sign in the memory range from _s_ to _end_.
+ *
+ * Returns 1 and stores the value in _out_ if the whole range is a valid integer of the int64_t range.
+ * Returns 0 otherwise, so that the caller can fall back to rb_cstr2inum() for big numbers or other notations.
+ *
+ * Digits are converted 8 and 4 at once per SWAR on little endian CPUs.
+ * This is used by PG::TextDecoder::Integer and in place by PG::TextDecoder::CopyRow .
+ */
+int
+rbpg_parse_int64(const char *s, const char *end, int64_t *out)
+{
+	uint64_t u = 0;
+	int neg = 0;
+
+	if( s < end && *s == '-' ){
+		neg = 1;
+		s++;
+	}
+	/* 19 digits always fit into uint64_t */
+	if( s >= end || end - s > 19 ) return 0;
+
+#if !defined(WORDS_BIGENDIAN)
+	while( end - s >= 8 ){
+		uint64_t w;
+		memcpy(&w, s, 8);
+		if( !swar_is_8digits(w) ) return 0;
+		u = u * 100000000 + swar_parse_8digits(w);
+		s += 8;
+	}
+	if( end - s >= 4 ){
+		uint32_t w;
+		memcpy(&w, s, 4);
+		if( !swar_is_4digits(w) ) return 0;
+		u = u * 10000 + swar_parse_4digits(w);
+		s += 4;
+	}
+#endif
+	for( ; s < end; s++ ){
+		unsigned int digit = (unsigned char)*s - '0';
+		if( digit > 9 ) return 0;
+		u = u * 10 + digit;
+	}
+
+	if( neg ){
+		if( u > (uint64_t)INT64_MAX + 1 ) return 0;
+		*out = u == (uint64_t)INT64_MAX + 1 ? INT64_MIN : -(int64_t)u;
+	} else {
+		if( u > (uint64_t)INT64_MAX ) return 0;
+		*out = (int64_t)u;
+	}
+	return 1;
+}
+
+/*
+ * Find one of the characters _c1_ to _c4_ in the remaining bytes one by one.
+ */
+static const char *
+find_any4_scalar(const char *s, const char *end, char c1, char c2, char c3, char c4)
+{
+	for( ; s < end; s++ ){
+		if( *s == c1 || *s == c2 || *s == c3 || *s == c4 ) return s;
+	}
+	return end;
+}
+
+/*
+ * Compare 16 bytes at once on SSE2 capable CPUs and 8 bytes at once per SWAR otherwise.
+ */
+static const char *
+find_any4_wide(const char *s, const char *end, char c1, char c2, char c3, char c4)
+{
+#if defined(__SSE2__)
+	const __m128i v1 = _mm_set1_epi8(c1);
+	const __m128i v2 = _mm_set1_epi8(c2);
+	const __m128i v3 = _mm_set1_epi8(c3);
+	const __m128i v4 = _mm_set1_epi8(c4);
+
+	while( end - s >= 16 ){
+		__m128i chunk = _mm_loadu_si128((const __m128i *)s);
+		__m128i hits = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(chunk, v1), _mm_cmpeq_epi8(chunk, v2)),
+				_mm_or_si128(_mm_cmpeq_epi8(chunk, v3), _mm_cmpeq_epi8(chunk, v4)));
+		int mask = _mm_movemask_epi8(hits);
+		if( mask ){
+#if defined(__GNUC__)
+			return s + __builtin_ctz(mask);
+#else
+			break;
+#endif
+		}
+		s += 16;
+	}
+#else
+	const uint64_t ones = UINT64_C(0x0101010101010101);
+	const uint64_t highs = UINT64_C(0x8080808080808080);
+	const uint64_t v1 = ones * (unsigned char)c1;
+	const uint64_t v2 = ones * (unsigned char)c2;
+	const uint64_t v3 = ones * (unsigned char)c3;
+	const uint64_t v4 = ones * (unsigned char)c4;
+
+	while( end - s >= 8 ){
+		uint64_t w, x1, x2, x3, x4;
+		memcpy(&w, s, 8);
+		x1 = w ^ v1;
+		x2 = w ^ v2;
+		x3 = w ^ v3;
+		x4 = w ^ v4;
+		/* Determine whether one of the bytes is zero */
+		if( (((x1 - ones) & ~x1) | ((x2 - ones) & ~x2) | ((x3 - ones) & ~x3) | ((x4 - ones) & ~x4)) & highs ){
+			/* The position is determined by the byte-wise loop below */
+			break;
+		}
+		s += 8;
+	}
+#endif
+
+	return find_any4_scalar(s, end, c1, c2, c3, c4);
+}
+
+#ifdef RBPG_HAVE_AVX2
+/*
+ * Compare 32 bytes at once on AVX2 capable CPUs.
+ */
+__attribute__((target("avx2")))
+static const char *
+find_any4_avx2(const char *s, const char *end, char c1, char c2, char c3, char c4)
+{
+	const __m256i v1 = _mm256_set1_epi8(c1);
+	const __m256i v2 = _mm256_set1_epi8(c2);
+	const __m256i v3 = _mm256_set1_epi8(c3);
+	const __m256i v4 = _mm256_set1_epi8(c4);
+
+	while( end - s >= 32 ){
+		__m256i chunk = _mm256_loadu_si256((const __m256i *)s);
+		__m256i hits = _mm256_or_si256(
+				_mm256_or_si256(_mm256_cmpeq_epi8(chunk, v1), _mm256_cmpeq_epi8(chunk, v2)),
+				_mm256_or_si256(_mm256_cmpeq_epi8(chunk, v3), _mm256_cmpeq_epi8(chunk, v4)));
+		unsigned int mask = (unsigned int)_mm256_movemask_epi8(hits);
+		if( mask ){
+			return s + __builtin_ctz(mask);
+		}
+		s += 32;
+	}
+
+	return find_any4_wide(s, end, c1, c2, c3, c4);
+}
+#endif
+
+static const struct {
+	const char *name;
+	t_rbpg_find_any4 find_any4;
+} find_any4_impls[] = {
+#ifdef RBPG_HAVE_AVX2
+	{ "avx2", find_any4_avx2 },
+#endif
+#if defined(__SSE2__)
+	{ "sse2", find_any4_wide },
+#else
+	{ "swar", find_any4_wide },
+#endif
+	{ "scalar", find_any4_scalar },
+};
+
+static int find_any4_impl_idx = sizeof(find_any4_impls) / sizeof(*find_any4_impls) - 1;
+
+/*
+ * Find the first occurrence of one of the characters _c1_ to _c4_ in the memory range from _s_ to _end_.
+ * Returns _end_ if none of the characters is found.
+ *
+ * This is used to find characters to be escaped or unescaped in COPY text data.
+ * Most fields don't contain such characters, so that the memory is compared in blocks.
+ * The implementation is selected at runtime by rbpg_simd_init() according to the CPU features.
+ */
+t_rbpg_find_any4 rbpg_find_any4 = find_any4_scalar;
+
+/*
+ * Select the fastest implementation supported by the CPU.
+ */
+void
+rbpg_simd_init(void)
+{
+	int i;
+	for( i=0; i < (int)(sizeof(find_any4_impls) / sizeof(*find_any4_impls)); i++ ){
+#ifdef RBPG_HAVE_AVX2
+		if( find_any4_impls[i].find_any4 == find_any4_avx2 && !__builtin_cpu_supports("avx2") ) continue;
+#endif
+		break;
+	}
+	find_any4_impl_idx = i;
+	rbpg_find_any4 = find_any4_impls[i].find_any4;
+}
+
+/*
+ * Select the implementation _name_. Returns 0 if _name_ is unknown or not supported by the CPU.
+ */
+int
+rbpg_simd_select(const char *name)
+{
+	int i;
+	for( i=0; i < (int)(sizeof(find_any4_impls) / sizeof(*find_any4_impls)); i++ ){
+		if( strcmp(find_any4_impls[i].name, name) == 0 ){
+#ifdef RBPG_HAVE_AVX2
+			if( find_any4_impls[i].find_any4 == find_any4_avx2 && !__builtin_cpu_supports("avx2") ) return 0;
+#endif
+			find_any4_impl_idx = i;
+			rbpg_find_any4 = find_any4_impls[i].find_any4;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Name of the selected implementation.
+ */
+const char *
+rbpg_simd_name(void)
+{
+	return find_any4_impls[find_any4_impl_idx].name;
+}
@@ -62,4 +62,14 @@ int rbpg_base64_decode( char *out, const char *in, unsigned int len);
 
 int rbpg_strncasecmp(const char *s1, const char *s2, size_t n);
 
+int rbpg_parse_int64(const char *s, const char *end, int64_t *out);
+int rbpg_parse_double(const char *s, const char *end, double *out);
+int rbpg_dtoa_shortest(double d, char *digits, int *exp10);
+
+typedef const char *(* t_rbpg_find_any4)(const char *s, const char *end, char c1, char c2, char c3, char c4);
+extern t_rbpg_find_any4 rbpg_find_any4;
+void rbpg_simd_init(void);
+int rbpg_simd_select(const char *name);
+const char *rbpg_simd_name(void);
+
 #endif /* end __utils_h */
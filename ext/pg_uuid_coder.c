@@ -0,0 +1,326 @@
+/*
+ * pg_uuid_coder.c - PG::TextDecoder::UUID, PG::TextEncoder::UUID and their binary variants
+ *
+ */
+
+/*
+ *
+ * Type casts between PostgreSQL uuid values and Ruby Strings.
+ *
+ * UUIDs are returned as canonical Strings like "a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11" per default.
+ * Per PG::Coder#flags= they can be returned as 16 byte binary Strings or as deduplicated frozen Strings instead.
+ * The encoders accept both forms.
+ *
+ * The hex conversion processes 8 hex digits within one 64 bit word (SWAR), so that
+ * no table lookup or branch per digit is required.
+ *
+ */
+
+#include "pg.h"
+#include "pg_util.h"
+#include <string.h>
+
+#define UUID_LEN 16
+#define UUID_TEXT_LEN 36
+
+/* Broadcast a byte value to all bytes of a 64 bit word */
+#define BYTES8(b) (UINT64_C(0x0101010101010101) * (b))
+
+/*
+ * Convert the 8 nibbles of a 64 bit word with one nibble per byte to lowercase hex digits.
+ */
+static inline uint64_t
+uuid_nibbles_to_hex(uint64_t nib)
+{
+	/* 1 in each byte with a nibble > 9 */
+	uint64_t letter = ((nib + BYTES8(0x06)) >> 4) & BYTES8(0x01);
+	return nib + BYTES8('0') + letter * ('a' - '0' - 10);
+}
+
+/*
+ * Write 4 bytes as 8 lowercase hex digits.
+ */
+static inline void
+uuid_hex_encode4(const char *in, char *out)
+{
+	uint64_t x = (uint32_t)read_nbo32(in);
+
+	/* spread the nibbles to one byte each, with the first nibble in the most significant byte */
+	x = (x | (x << 16)) & UINT64_C(0x0000FFFF0000FFFF);
+	x = (x | (x << 8)) & UINT64_C(0x00FF00FF00FF00FF);
+	x = (x | (x << 4)) & BYTES8(0x0F);
+	x = uuid_nibbles_to_hex(x);
+	write_nbo64(x, out);
+}
+
+/*
+ * Read 8 hex digits of any case as 4 bytes.
+ * Returns 0 if there is a non hex digit.
+ */
+static inline int
+uuid_hex_decode4(const char *in, char *out)
+{
+	uint64_t x = (uint64_t)read_nbo64(in);
+	uint64_t lower = x | BYTES8(0x20);
+	/* 1 in each byte with a letter */
+	uint64_t letter = (lower >> 6) & BYTES8(0x01);
+	uint64_t nib = (lower & BYTES8(0x0F)) + letter * 9;
+
+	/* All characters are valid, if they are converted back to the same lowercase hex digits.
+	 * Digits must not differ in bit 0x20 from their lowercase form, but letters may. */
+	if( (nib & BYTES8(0xF0)) || uuid_nibbles_to_hex(nib) != lower || (x | (letter << 5)) != lower ){
+		return 0;
+	}
+
+	/* join the nibbles */
+	nib = (nib | (nib >> 4)) & UINT64_C(0x00FF00FF00FF00FF);
+	nib = (nib | (nib >> 8)) & UINT64_C(0x0000FFFF0000FFFF);
+	nib = (nib | (nib >> 16)) & UINT64_C(0x00000000FFFFFFFF);
+	write_nbo32(nib, out);
+	return 1;
+}
+
+/*
+ * Write the 16 byte UUID as 36 characters of canonical text.
+ */
+static void
+uuid_format(const char *uuid, char *out)
+{
+	char hex[8];
+
+	uuid_hex_encode4(uuid, out);
+	out[8] = '-';
+	uuid_hex_encode4(uuid + 4, hex);
+	memcpy(out + 9, hex, 4);
+	out[13] = '-';
+	memcpy(out + 14, hex + 4, 4);
+	out[18] = '-';
+	uuid_hex_encode4(uuid + 8, hex);
+	memcpy(out + 19, hex, 4);
+	out[23] = '-';
+	memcpy(out + 24, hex + 4, 4);
+	uuid_hex_encode4(uuid + 12, out + 28);
+}
+
+/*
+ * Parse the text forms of a UUID into 16 bytes.
+ *
+ * Accepted are 32 hex digits, the canonical form with hyphens, and both surrounded by braces.
+ * Returns 0 for other input.
+ */
+static int
+uuid_parse(const char *s, long len, char *out)
+{
+	char hex[32];
+
+	if( len >= 2 && s[0] == '{' && s[len-1] == '}' ){
+		s++;
+		len -= 2;
+	}
+	if( len == UUID_TEXT_LEN ){
+		if( s[8] != '-' || s[13] != '-' || s[18] != '-' || s[23] != '-' ) return 0;
+		memcpy(hex, s, 8);
+		memcpy(hex + 8, s + 9, 4);
+		memcpy(hex + 12, s + 14, 4);
+		memcpy(hex + 16, s + 19, 4);
+		memcpy(hex + 20, s + 24, 12);
+		s = hex;
+	} else if( len != 32 ){
+		return 0;
+	}
+	return uuid_hex_decode4(s, out) && uuid_hex_decode4(s + 8, out + 4) &&
+			uuid_hex_decode4(s + 16, out + 8) && uuid_hex_decode4(s + 24, out + 12);
+}
+
+static VALUE
+uuid_new_string(t_pg_coder *conv, const char *text, int enc_idx)
+{
+	if( conv->flags & PG_CODER_UUID_INTERN ){
+#ifdef HAVE_RB_ENC_INTERNED_STR
+		return rb_enc_interned_str( text, UUID_TEXT_LEN, rb_enc_from_index(enc_idx) );
+#else
+		VALUE str = rb_str_new( text, UUID_TEXT_LEN );
+		PG_ENCODING_SET_NOCHECK( str, enc_idx );
+		return rb_funcall( str, rb_intern("-@"), 0 );
+#endif
+	} else {
+		VALUE str = rb_str_new( text, UUID_TEXT_LEN );
+		PG_ENCODING_SET_NOCHECK( str, enc_idx );
+		return str;
+	}
+}
+
+static VALUE
+uuid_new_binary(const char *uuid)
+{
+	VALUE str = rb_str_new( uuid, UUID_LEN );
+	PG_ENCODING_SET_NOCHECK( str, rb_ascii8bit_encindex() );
+	return str;
+}
+
+/*
+ * Document-class: PG::TextDecoder::UUID < PG::SimpleDecoder
+ *
+ * This is a decoder class for conversion of PostgreSQL uuid values to Ruby Strings.
+ *
+ * The following flags can be used to choose the kind of String:
+ * * +PG::Coder::UUID_BINARY+ : Return a 16 byte binary String.
+ * * +PG::Coder::UUID_INTERN+ : Return a deduplicated frozen String in canonical form.
+ *   Each UUID is allocated only once, which saves memory if the same UUIDs are retrieved repeatedly.
+ *
+ * Without flags a new canonical String is returned like by PG::TextDecoder::String .
+ * The flags can be set per #binary_string= and #intern= as well.
+ *
+ */
+static VALUE
+pg_text_dec_uuid(t_pg_coder *conv, const char *val, int len, int tuple, int field, int enc_idx)
+{
+	char uuid[UUID_LEN];
+
+	if( conv->flags & PG_CODER_UUID_BINARY ){
+		if( !uuid_parse(val, len, uuid) ){
+			rb_raise( rb_eTypeError, "wrong data for text uuid converter in tuple %d field %d", tuple, field);
+		}
+		return uuid_new_binary(uuid);
+	}
+	if( len == UUID_TEXT_LEN ){
+		return uuid_new_string(conv, val, enc_idx);
+	}
+	return pg_text_dec_string(conv, val, len, tuple, field, enc_idx);
+}
+
+/*
+ * Document-class: PG::BinaryDecoder::UUID < PG::SimpleDecoder
+ *
+ * This is a decoder class for conversion of PostgreSQL binary uuid values to Ruby Strings.
+ *
+ * The same flags as with PG::TextDecoder::UUID can be used.
+ * Per default the 16 bytes are converted to a new canonical String.
+ *
+ */
+static VALUE
+pg_bin_dec_uuid(t_pg_coder *conv, const char *val, int len, int tuple, int field, int enc_idx)
+{
+	char text[UUID_TEXT_LEN];
+
+	if( len != UUID_LEN ){
+		rb_raise( rb_eTypeError, "wrong data for binary uuid converter in tuple %d field %d", tuple, field);
+	}
+	if( conv->flags & PG_CODER_UUID_BINARY ){
+		return uuid_new_binary(val);
+	}
+	uuid_format(val, text);
+	return uuid_new_string(conv, text, enc_idx);
+}
+
+static VALUE
+uuid_to_string(VALUE value)
+{
+	return RB_TYPE_P(value, T_STRING) ? value : rb_obj_as_string(value);
+}
+
+/*
+ * Document-class: PG::TextEncoder::UUID < PG::SimpleEncoder
+ *
+ * This is the encoder class for the PostgreSQL uuid type.
+ *
+ * 16 byte Strings are expected to be a binary UUID and are converted to canonical text.
+ * All other values are sent as their String representation like by PG::TextEncoder::String .
+ *
+ */
+static int
+pg_text_enc_uuid(t_pg_coder *conv, VALUE value, char *out, VALUE *intermediate, int enc_idx)
+{
+	if(out){
+		uuid_format(RSTRING_PTR(*intermediate), out);
+		return UUID_TEXT_LEN;
+	} else {
+		VALUE str = uuid_to_string(value);
+		if( RSTRING_LEN(str) == UUID_LEN ){
+			*intermediate = str;
+			return UUID_TEXT_LEN;
+		}
+		return pg_coder_enc_to_s(conv, str, NULL, intermediate, enc_idx);
+	}
+}
+
+/*
+ * Document-class: PG::BinaryEncoder::UUID < PG::SimpleEncoder
+ *
+ * This is the binary encoder class for the PostgreSQL uuid type.
+ *
+ * It accepts 16 byte binary Strings and the text forms of a UUID:
+ * 32 hex digits with or without the hyphens of the canonical form, optionally surrounded by braces.
+ * Other values raise an ArgumentError.
+ *
+ */
+static int
+pg_bin_enc_uuid(t_pg_coder *conv, VALUE value, char *out, VALUE *intermediate, int enc_idx)
+{
+	if(out){
+		VALUE str = *intermediate;
+		if( RSTRING_LEN(str) == UUID_LEN ){
+			memcpy(out, RSTRING_PTR(str), UUID_LEN);
+		} else {
+			uuid_parse(RSTRING_PTR(str), RSTRING_LEN(str), out);
+		}
+	} else {
+		VALUE str = uuid_to_string(value);
+		char uuid[UUID_LEN];
+
+		if( RSTRING_LEN(str) != UUID_LEN && !uuid_parse(RSTRING_PTR(str), RSTRING_LEN(str), uuid) ){
+			rb_raise( rb_eArgError, "invalid value for binary uuid: %+"PRIsVALUE, value );
+		}
+		*intermediate = str;
+	}
+	return UUID_LEN;
+}
+
+/* called per autoload when TextDecoder::UUID is used */
+static VALUE
+init_pg_text_decoder_uuid(VALUE rb_mPG_TextDecoder)
+{
+	/* dummy = rb_define_class_under( rb_mPG_TextDecoder, "UUID", rb_cPG_SimpleDecoder ); */
+	pg_define_coder( "UUID", pg_text_dec_uuid, rb_cPG_SimpleDecoder, rb_mPG_TextDecoder );
+
+	return Qnil;
+}
+
+/* called per autoload when TextEncoder::UUID is used */
+static VALUE
+init_pg_text_encoder_uuid(VALUE rb_mPG_TextEncoder)
+{
+	/* dummy = rb_define_class_under( rb_mPG_TextEncoder, "UUID", rb_cPG_SimpleEncoder ); */
+	pg_define_coder( "UUID", pg_text_enc_uuid, rb_cPG_SimpleEncoder, rb_mPG_TextEncoder );
+
+	return Qnil;
+}
+
+/* called per autoload when BinaryDecoder::UUID is used */
+static VALUE
+init_pg_bin_decoder_uuid(VALUE rb_mPG_BinaryDecoder)
+{
+	/* dummy = rb_define_class_under( rb_mPG_BinaryDecoder, "UUID", rb_cPG_SimpleDecoder ); */
+	pg_define_coder( "UUID", pg_bin_dec_uuid, rb_cPG_SimpleDecoder, rb_mPG_BinaryDecoder );
+
+	return Qnil;
+}
+
+/* called per autoload when BinaryEncoder::UUID is used */
+static VALUE
+init_pg_bin_encoder_uuid(VALUE rb_mPG_BinaryEncoder)
+{
+	/* dummy = rb_define_class_under( rb_mPG_BinaryEncoder, "UUID", rb_cPG_SimpleEncoder ); */
+	pg_define_coder( "UUID", pg_bin_enc_uuid, rb_cPG_SimpleEncoder, rb_mPG_BinaryEncoder );
+
+	return Qnil;
+}
+
+void
+init_pg_uuidcoder(void)
+{
+	rb_define_private_method(rb_singleton_class(rb_mPG_TextDecoder), "init_uuid", init_pg_text_decoder_uuid, 0);
+	rb_define_private_method(rb_singleton_class(rb_mPG_TextEncoder), "init_uuid", init_pg_text_encoder_uuid, 0);
+	rb_define_private_method(rb_singleton_class(rb_mPG_BinaryDecoder), "init_uuid", init_pg_bin_decoder_uuid, 0);
+	rb_define_private_method(rb_singleton_class(rb_mPG_BinaryEncoder), "init_uuid", init_pg_bin_encoder_uuid, 0);
+}
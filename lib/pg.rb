@@ -103,11 +103,21 @@ module PG
       autoload klass, 'pg/binary_decoder/timestamp'
     end
     autoload :Date, 'pg/binary_decoder/date'
+    autoload :JSON, 'pg/binary_decoder/json'
+    autoload :Interval, 'pg/binary_decoder/interval'
+    autoload :Numeric, 'pg/binary_decoder/numeric'
+    autoload :UUID, 'pg/binary_decoder/uuid'
   end
   module BinaryEncoder
     %i[ TimestampUtc TimestampLocal ].each do |klass|
       autoload klass, 'pg/binary_encoder/timestamp'
     end
+    %i[ JSON JSONB ].each do |klass|
+      autoload klass, 'pg/binary_encoder/json'
+    end
+    autoload :Interval, 'pg/binary_encoder/interval'
+    autoload :Numeric, 'pg/binary_encoder/numeric'
+    autoload :UUID, 'pg/binary_encoder/uuid'
   end
   module TextDecoder
     %i[ TimestampUtc TimestampUtcToLocal TimestampLocal TimestampWithoutTimeZone TimestampWithTimeZone ].each do |klass|
@@ -115,8 +125,16 @@ module PG
     end
     autoload :Date, 'pg/text_decoder/date'
     autoload :Inet, 'pg/text_decoder/inet'
+    %i[ Interval IntervalOptions ].each do |klass|
+      autoload klass, 'pg/text_decoder/interval'
+    end
     autoload :JSON, 'pg/text_decoder/json'
-    autoload :Numeric, 'pg/text_decoder/numeric'
+    %i[ Numeric NumericOptions ].each do |klass|
+      autoload klass, 'pg/text_decoder/numeric'
+    end
+    %i[ UUID UUIDOptions ].each do |klass|
+      autoload klass, 'pg/text_decoder/uuid'
+    end
   end
   module TextEncoder
     %i[ TimestampUtc TimestampWithoutTimeZone TimestampWithTimeZone ].each do |klass|
@@ -124,14 +142,19 @@ module PG
     end
     autoload :Date, 'pg/text_encoder/date'
     autoload :Inet, 'pg/text_encoder/inet'
+    autoload :Interval, 'pg/text_encoder/interval'
     autoload :JSON, 'pg/text_encoder/json'
     autoload :Numeric, 'pg/text_encoder/numeric'
+    autoload :UUID, 'pg/text_encoder/uuid'
   end
 
   autoload :BasicTypeMapBasedOnResult, 'pg/basic_type_map_based_on_result'
   autoload :BasicTypeMapForQueries, 'pg/basic_type_map_for_queries'
   autoload :BasicTypeMapForResults, 'pg/basic_type_map_for_results'
   autoload :BasicTypeRegistry, 'pg/basic_type_registry'
+  autoload :CopyLoader, 'pg/copy_loader'
+  autoload :CopyWriter, 'pg/copy_writer'
+  autoload :HostRouter, 'pg/host_router'
   require 'pg/exceptions'
   require 'pg/coder'
   require 'pg/type_map_by_column'
@@ -139,6 +162,7 @@ module PG
   require 'pg/cancel_connection'
   require 'pg/result'
   require 'pg/tuple'
+  require 'pg/replication_stream'
   autoload :VERSION, 'pg/version'
 
 
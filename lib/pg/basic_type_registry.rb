@@ -246,9 +246,7 @@ class PG::BasicTypeRegistry
 
 		# FIXME: why are we keeping these types as strings?
 		# alias_type 'tsvector', 'text'
-		# alias_type 'interval', 'text'
 		# alias_type 'macaddr',  'text'
-		# alias_type 'uuid',     'text'
 		#
 		# register_type 'money', OID::Money.new
 		register_type 0, 'bytea', PG::TextEncoder::Bytea, PG::TextDecoder::Bytea
@@ -263,6 +261,7 @@ class PG::BasicTypeRegistry
 		register_type 0, 'timestamp', PG::TextEncoder::TimestampWithoutTimeZone, PG::TextDecoder::TimestampWithoutTimeZone
 		register_type 0, 'timestamptz', PG::TextEncoder::TimestampWithTimeZone, PG::TextDecoder::TimestampWithTimeZone
 		register_type 0, 'date', PG::TextEncoder::Date, PG::TextDecoder::Date
+		register_type 0, 'interval', PG::TextEncoder::Interval, PG::TextDecoder::Interval
 		# register_type 'time', OID::Time.new
 		#
 		# register_type 'path', OID::Text.new
@@ -278,12 +277,19 @@ class PG::BasicTypeRegistry
 		register_type 0, 'inet', PG::TextEncoder::Inet, PG::TextDecoder::Inet
 		alias_type 0, 'cidr', 'inet'
 
+		register_type 0, 'uuid', PG::TextEncoder::UUID, PG::TextDecoder::UUID
+
 		register_type 0, 'record', PG::TextEncoder::Record, PG::TextDecoder::Record
 
 
 		register_type 1, 'int2', PG::BinaryEncoder::Int2, PG::BinaryDecoder::Integer
 		register_type 1, 'int4', PG::BinaryEncoder::Int4, PG::BinaryDecoder::Integer
 		register_type 1, 'int8', PG::BinaryEncoder::Int8, PG::BinaryDecoder::Integer
+		begin
+			PG.require_bigdecimal_without_warning
+			register_type 1, 'numeric', PG::BinaryEncoder::Numeric, PG::BinaryDecoder::Numeric
+		rescue LoadError
+		end
 		alias_type    1, 'oid',  'int2'
 
 		register_type 1, 'text', PG::BinaryEncoder::String, PG::BinaryDecoder::String
@@ -300,6 +306,10 @@ class PG::BasicTypeRegistry
 		register_type 1, 'timestamp', PG::BinaryEncoder::TimestampUtc, PG::BinaryDecoder::TimestampUtc
 		register_type 1, 'timestamptz', PG::BinaryEncoder::TimestampUtc, PG::BinaryDecoder::TimestampUtcToLocal
 		register_type 1, 'date', PG::BinaryEncoder::Date, PG::BinaryDecoder::Date
+		register_type 1, 'interval', PG::BinaryEncoder::Interval, PG::BinaryDecoder::Interval
+		register_type 1, 'json', PG::BinaryEncoder::JSON, PG::BinaryDecoder::JSON
+		register_type 1, 'jsonb', PG::BinaryEncoder::JSONB, PG::BinaryDecoder::JSON
+		register_type 1, 'uuid', PG::BinaryEncoder::UUID, PG::BinaryDecoder::UUID
 
 		self
 	end
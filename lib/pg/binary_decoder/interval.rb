@@ -0,0 +1,13 @@
+# -*- ruby -*-
+# frozen_string_literal: true
+
+module PG
+	module BinaryDecoder
+		# Init C part of the decoder
+		init_interval
+
+		class Interval < SimpleDecoder
+			include PG::TextDecoder::IntervalOptions
+		end
+	end
+end # module PG
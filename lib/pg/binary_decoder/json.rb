@@ -0,0 +1,13 @@
+# -*- ruby -*-
+# frozen_string_literal: true
+
+module PG
+	module BinaryDecoder
+		# Init C part of the decoder
+		init_json
+
+		class JSON < SimpleDecoder
+			include PG::TextDecoder::JSONOptions
+		end
+	end
+end # module PG
@@ -0,0 +1,13 @@
+# -*- ruby -*-
+# frozen_string_literal: true
+
+module PG
+	module BinaryDecoder
+		# Init C part of the decoder
+		init_numeric
+
+		class Numeric < SimpleDecoder
+			include PG::TextDecoder::NumericOptions
+		end
+	end
+end # module PG
@@ -7,19 +7,19 @@ module PG
 		class TimestampUtc < Timestamp
 			def initialize(hash={}, **kwargs)
 				warn("PG::Coder.new(hash) is deprecated. Please use keyword arguments instead! Called from #{caller.first}", category: :deprecated) unless hash.empty?
-				super(**hash, **kwargs, flags: PG::Coder::TIMESTAMP_DB_UTC | PG::Coder::TIMESTAMP_APP_UTC)
+				super(**hash, **kwargs, flags: PG::Coder::TIMESTAMP_DB_UTC | PG::Coder::TIMESTAMP_APP_UTC | (kwargs.fetch(:flags){ hash.fetch(:flags, 0) } & PG::Coder::TIMESTAMP_CACHE))
 			end
 		end
 		class TimestampUtcToLocal < Timestamp
 			def initialize(hash={}, **kwargs)
 				warn("PG::Coder.new(hash) is deprecated. Please use keyword arguments instead! Called from #{caller.first}", category: :deprecated) unless hash.empty?
-				super(**hash, **kwargs, flags: PG::Coder::TIMESTAMP_DB_UTC | PG::Coder::TIMESTAMP_APP_LOCAL)
+				super(**hash, **kwargs, flags: PG::Coder::TIMESTAMP_DB_UTC | PG::Coder::TIMESTAMP_APP_LOCAL | (kwargs.fetch(:flags){ hash.fetch(:flags, 0) } & PG::Coder::TIMESTAMP_CACHE))
 			end
 		end
 		class TimestampLocal < Timestamp
 			def initialize(hash={}, **kwargs)
 				warn("PG::Coder.new(hash) is deprecated. Please use keyword arguments instead! Called from #{caller.first}", category: :deprecated) unless hash.empty?
-				super(**hash, **kwargs, flags: PG::Coder::TIMESTAMP_DB_LOCAL | PG::Coder::TIMESTAMP_APP_LOCAL)
+				super(**hash, **kwargs, flags: PG::Coder::TIMESTAMP_DB_LOCAL | PG::Coder::TIMESTAMP_APP_LOCAL | (kwargs.fetch(:flags){ hash.fetch(:flags, 0) } & PG::Coder::TIMESTAMP_CACHE))
 			end
 		end
 	end
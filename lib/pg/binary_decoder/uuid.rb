@@ -0,0 +1,13 @@
+# -*- ruby -*-
+# frozen_string_literal: true
+
+module PG
+	module BinaryDecoder
+		# Init C part of the decoder
+		init_uuid
+
+		class UUID < SimpleDecoder
+			include PG::TextDecoder::UUIDOptions
+		end
+	end
+end # module PG
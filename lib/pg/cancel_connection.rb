@@ -43,6 +43,66 @@ if defined?(PG::CancelConnection)
 		end
 		alias async_cancel cancel
 
+		# call-seq:
+		#    PG::CancelConnection.cancel_all(cancel_connections, timeout: nil) -> Array
+		#
+		# Sends the cancel requests of all given PG::CancelConnection objects concurrently in one nonblocking polling loop.
+		#
+		# Each object must be in state +CONNECTION_ALLOCATED+ (new or after #reset).
+		# +timeout+ is the maximum time in seconds to wait for all cancel requests to be sent.
+		# Cancel connections which don't complete in time are reset.
+		#
+		# Returns an Array with one element per cancel connection, which is +nil+ on success or a String with the error message.
+		#
+		# See also PG::Connection.cancel_all .
+		def self.cancel_all(cancons, timeout: nil)
+			errors = Array.new(cancons.size)
+			poll_states = {}
+			cancons.each_with_index do |cancon, idx|
+				cancon.start
+				poll_states[idx] = PG::PGRES_POLLING_WRITING
+			rescue PG::Error => err
+				errors[idx] = err.to_s
+			end
+			stop_time = Process.clock_gettime(Process::CLOCK_MONOTONIC) + timeout if timeout
+
+			until poll_states.empty?
+				if stop_time
+					remaining = stop_time - Process.clock_gettime(Process::CLOCK_MONOTONIC)
+					if remaining <= 0
+						poll_states.each_key do |idx|
+							cancon = cancons[idx]
+							msg = cancon.error_message.chomp.sub(/:\s*\z/, "")
+							msg = %Q{cancel request to server at "#{cancon.send(:host)}", port #{cancon.send(:port)}} if msg.empty?
+							errors[idx] = "#{msg}: timeout expired"
+							cancon.reset
+						end
+						break
+					end
+				end
+
+				readers, writers = [], []
+				poll_states.each do |idx, poll_status|
+					(poll_status == PG::PGRES_POLLING_READING ? readers : writers) << cancons[idx].socket_io
+				end
+				IO.select(readers, writers, nil, remaining)
+
+				poll_states.keys.each do |idx|
+					cancon = cancons[idx]
+					case poll_status = cancon.poll
+					when PG::PGRES_POLLING_OK
+						poll_states.delete(idx)
+					when PG::PGRES_POLLING_FAILED
+						errors[idx] = cancon.error_message
+						poll_states.delete(idx)
+					else
+						poll_states[idx] = poll_status
+					end
+				end
+			end
+			errors
+		end
+
 		# These private methods are there to allow a shared polling_loop.
 		private
 		attr_reader :host
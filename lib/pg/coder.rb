@@ -98,6 +98,29 @@ module PG
 		end
 	end
 
+	module TextEncoder
+		class CopyCsvRow < CopyEncoder
+			def to_h
+				{ **super,
+					quote: quote,
+					escape: escape,
+					force_quote: force_quote,
+				}
+			end
+		end
+	end
+
+	module TextDecoder
+		class CopyCsvRow < CopyDecoder
+			def to_h
+				{ **super,
+					quote: quote,
+					escape: escape,
+				}
+			end
+		end
+	end
+
 	class RecordCoder < Coder
 		def to_h
 			{ **super,
@@ -214,6 +214,7 @@ class PG::Connection
 	def copy_data( sql, coder=nil )
 		raise PG::NotInBlockingMode.new("copy_data can not be used in nonblocking mode", connection: self) if nonblocking?
 		res = exec( sql )
+		reset_copy_stats
 
 		case res.result_status
 		when PGRES_COPY_IN
@@ -293,6 +294,95 @@ class PG::Connection
 		end
 	end
 
+	# call-seq:
+	#    conn.copy_from_io( sql, io, buffer_size: 65536 ) -> PG::Result
+	#
+	# Execute a <tt>COPY ... FROM STDIN</tt> command and send the content of +io+ as COPY data.
+	#
+	# The data is read by <tt>io.read</tt> in blocks of +buffer_size+ bytes into one reused String and each block is sent by one call to libpq's +PQputCopyData+.
+	# The data is sent as is, so that it must be in the format given to the COPY command.
+	# Any IO-like object responding to +read+ can be used, for instance a File, a pipe or a StringIO.
+	# Reading from +io+ and waiting for the socket are done by ruby's IO functions, so that the GVL is released while waiting and a Fiber.scheduler is respected.
+	#
+	# Errors are handled like in #copy_data.
+	#
+	# Example:
+	#   File.open("my_table.csv", "rb") do |fd|
+	#     conn.copy_from_io("COPY my_table FROM STDIN (FORMAT csv)", fd)
+	#   end
+	#
+	def copy_from_io( sql, io, buffer_size: 65536 )
+		buffer = String.new(capacity: buffer_size, encoding: Encoding::BINARY)
+		copy_data( sql ) do |res|
+			raise ArgumentError, "SQL command is no COPY FROM STDIN statement: #{sql}" unless res.result_status == PGRES_COPY_IN
+			while io.read(buffer_size, buffer)
+				put_copy_rows_buffered([], nil, buffer, buffer_size, true)
+			end
+		end
+	end
+
+	# call-seq:
+	#    conn.copy_to_io( sql, io, buffer_size: 65536 ) -> PG::Result
+	#
+	# Execute a <tt>COPY ... TO STDOUT</tt> command and write the received COPY data to +io+.
+	#
+	# All rows received so far are collected by the C extension into one reused String of about +buffer_size+ bytes, which is then written by one call to <tt>io.write</tt>.
+	# This avoids the allocation of one String per row as with #get_copy_data .
+	# Any IO-like object responding to +write+ can be used.
+	# Writing to +io+ and waiting for the socket are done by ruby's IO functions, so that the GVL is released while waiting and a Fiber.scheduler is respected.
+	#
+	# Errors are handled like in #copy_data.
+	#
+	# Example:
+	#   File.open("my_table.dump", "wb") do |fd|
+	#     conn.copy_to_io("COPY my_table TO STDOUT (FORMAT binary)", fd)
+	#   end
+	#
+	def copy_to_io( sql, io, buffer_size: 65536 )
+		buffer = String.new(capacity: buffer_size + 1024, encoding: Encoding::BINARY)
+		copy_data( sql ) do |res|
+			raise ArgumentError, "SQL command is no COPY TO STDOUT statement: #{sql}" unless res.result_status == PGRES_COPY_OUT
+			loop do
+				while (got=get_copy_chunk(buffer, buffer_size)) == false
+					wait_copy_readable
+				end
+				break unless got
+				io.write(buffer)
+			end
+		end
+	end
+
+	# call-seq:
+	#    conn.copy_writer( sql, coder=nil, buffer_size: 65536 ) {|writer| ... } -> PG::Result
+	#
+	# Execute a <tt>COPY ... FROM STDIN</tt> command and yield a PG::CopyWriter to send the data.
+	#
+	# Rows written by the writer are encoded by +coder+ into one reusable buffer, which is sent to the server by one +PQputCopyData+ call every +buffer_size+ bytes.
+	# This is significantly faster than #put_copy_data per row for bulk loads.
+	# If +coder+ is +nil+, rows must be Strings in the COPY format of the command.
+	#
+	# Errors are handled the same way as in #copy_data .
+	#
+	# Example:
+	#   enco = PG::TextEncoder::CopyRow.new
+	#   conn.copy_writer("COPY my_table FROM STDIN", enco) do |writer|
+	#     writer.write_rows(rows)
+	#   end
+	#
+	# Binary format is supported with PG::BinaryEncoder::CopyRow :
+	#   enco = PG::BinaryEncoder::CopyRow.new
+	#   conn.copy_writer("COPY my_table FROM STDIN (FORMAT binary)", enco) do |writer|
+	#     writer << ["some", "data", "to", "copy"]
+	#   end
+	def copy_writer( sql, coder=nil, buffer_size: 65536 )
+		copy_data( sql ) do |res|
+			raise ArgumentError, "SQL command is no COPY FROM STDIN statement: #{sql}" unless res.result_status == PGRES_COPY_IN
+			writer = PG::CopyWriter.new(self, coder, buffer_size: buffer_size, binary: coder && res.binary_tuples == 1)
+			yield writer
+			writer.finish
+		end
+	end
+
 	# Backward-compatibility aliases for stuff that's moved into PG.
 	class << self
 		define_method( :isthreadsafe, &PG.method(:isthreadsafe) )
@@ -386,8 +476,8 @@ class PG::Connection
 	end
 
 	# call-seq:
-	#    conn.get_result() -> PG::Result
-	#    conn.get_result() {|pg_result| block }
+	#    conn.get_result( [ timeout: nil ] ) -> PG::Result
+	#    conn.get_result( [ timeout: nil ] ) {|pg_result| block }
 	#
 	# Blocks waiting for the next result from a call to
 	# #send_query (or another asynchronous command), and returns
@@ -399,9 +489,17 @@ class PG::Connection
 	# If the optional code block is given, it will be passed <i>result</i> as an argument,
 	# and the PG::Result object will  automatically be cleared when the block terminates.
 	# In this instance, <code>conn.exec</code> returns the value of the block.
-	def get_result
-		block
-		sync_get_result
+	#
+	# The optional +timeout+ is the maximum time in seconds to wait for the next result.
+	# If it expires, the running query is canceled, all pending results are discarded and PG::QueryTimeout is raised.
+	# The connection is reset, if the server doesn't process the cancel request in time.
+	def get_result(timeout: nil, &result_block)
+		if timeout.nil?
+			self.block
+		elsif !self.block(timeout)
+			query_timeout(timeout)
+		end
+		sync_get_result(&result_block)
 	end
 	alias async_get_result get_result
 
@@ -427,14 +525,67 @@ class PG::Connection
 			return sync_get_copy_data(async, decoder)
 		else
 			while (res=sync_get_copy_data(true, decoder)) == false
-				socket_io.wait_readable
-				consume_input
+				wait_copy_readable
 			end
 			return res
 		end
 	end
 	alias async_get_copy_data get_copy_data
 
+	# call-seq:
+	#    conn.get_copy_rows( max_rows = nil [, decoder = nil ] ) -> Array or nil
+	#
+	# Return an Array of all rows of COPY data, which are received so far, or +nil+ if the copy is done.
+	# The call blocks until at least one row is available.
+	#
+	# At most _max_rows_ rows are returned if _max_rows_ is given.
+	# The rows are decoded like in #get_copy_data, but all rows are retrieved from libpq and decoded in one call.
+	# This is significantly faster than #get_copy_data for large exports.
+	#
+	# See also #copy_each_batch.
+	#
+	def get_copy_rows(max_rows=nil, decoder=nil)
+		while (res=sync_get_copy_rows(max_rows, decoder)) == false
+			wait_copy_readable
+		end
+		res
+	end
+
+	# Wait for more COPY data and account the time to #copy_stats .
+	private def wait_copy_readable
+		if copy_stats
+			t0 = Process.clock_gettime(Process::CLOCK_MONOTONIC, :nanosecond)
+			socket_io.wait_readable
+			add_copy_wait_ns(Process.clock_gettime(Process::CLOCK_MONOTONIC, :nanosecond) - t0)
+		else
+			socket_io.wait_readable
+		end
+		consume_input
+	end
+
+	# call-seq:
+	#    conn.copy_each_batch( sql, coder=nil, max_rows: 1000 ) {|rows| ... } -> PG::Result
+	#
+	# Execute a <tt>COPY ... TO STDOUT</tt> command and yield the received rows in Arrays of up to _max_rows_ rows.
+	#
+	# This is a faster variant of #copy_data with #get_copy_data .
+	# The parameters and the handling of errors are the same as in #copy_data.
+	#
+	# Example:
+	#   deco = PG::TextDecoder::CopyRow.new
+	#   conn.copy_each_batch("COPY my_table TO STDOUT", deco) do |rows|
+	#     rows.each { |row| p row }
+	#   end
+	#
+	def copy_each_batch( sql, coder=nil, max_rows: 1000 )
+		copy_data( sql, coder ) do |res|
+			raise ArgumentError, "SQL command is no COPY TO STDOUT statement: #{sql}" unless res.result_status == PGRES_COPY_OUT
+			while rows=get_copy_rows(max_rows)
+				yield rows
+			end
+		end
+	end
+
 
 	# In async_api=true mode (default) all send calls run nonblocking.
 	# The difference is that setnonblocking(true) disables automatic handling of would-block cases.
@@ -595,6 +746,8 @@ class PG::Connection
 			iopts = self.class.send(:resolve_hosts, iopts)
 		end
 		conninfo = self.class.parse_connect_args( iopts );
+		# Prepared statements don't survive the new session
+		@typed_statements = nil
 		reset_start2(conninfo)
 		async_connect_or_reset(:reset_poll)
 		self
@@ -621,14 +774,61 @@ class PG::Connection
 		# error message if a failure occurs.
 		#
 		# On PostgreSQL-17+ client library the class PG::CancelConnection is used.
+		# It is kept for subsequent calls, see #cancel_connection .
 		# On older client library a pure ruby implementation is used.
 		def cancel
-			cancon = PG::CancelConnection.new(self)
-			cancon.async_cancel
+			cancon = checkout_cancel_connection
+			begin
+				cancon.async_cancel
+			ensure
+				checkin_cancel_connection(cancon)
+			end
 		rescue PG::Error => err
 			err.to_s
 		end
 
+		# call-seq:
+		#    conn.cancel_connection() -> PG::CancelConnection
+		#
+		# Returns the PG::CancelConnection that is reused by #cancel and PG::Connection.cancel_all .
+		#
+		# The object is created on first use and is reset per PG::CancelConnection#reset after each cancel request, so that it's ready for the next one.
+		# It is created anew after the backend process changed (for instance by #reset) or after a failed cancel request.
+		# Calling this method in advance prepares the cancel request, so that the connection parameters don't need to be copied when the cancellation is urgent.
+		# The cancel request is sent to the address the connection is established to, so that no DNS lookup is necessary.
+		# The TCP and SSL handshake can not be done in advance, since the server expects the cancel request as the first message of a new connection.
+		#
+		# Available since PostgreSQL-17.
+		def cancel_connection
+			cancon = @cancel_connection
+			if cancon && @cancel_backend_pid == backend_pid
+				begin
+					cancon.reset unless cancon.status == PG::CONNECTION_ALLOCATED
+					return cancon
+				rescue PG::ConnectionBad
+					# The cancel connection was finished due to a failed request
+				end
+			end
+			@cancel_backend_pid = backend_pid
+			@cancel_connection = PG::CancelConnection.new(self)
+		end
+
+		# Fetch the reusable cancel connection or a new one, if it's in use by another thread or fiber.
+		private def checkout_cancel_connection
+			mutex = (@cancel_mutex ||= Thread::Mutex.new)
+			return PG::CancelConnection.new(self) unless mutex.try_lock
+			begin
+				cancel_connection
+			rescue Exception
+				mutex.unlock
+				raise
+			end
+		end
+
+		private def checkin_cancel_connection(cancon)
+			@cancel_mutex.unlock if cancon.equal?(@cancel_connection) && @cancel_mutex.owned?
+		end
+
 	else
 
 		# PostgreSQL < 17
@@ -755,6 +955,131 @@ class PG::Connection
 		end
 	end
 
+	# Type maps of a statement prepared by #prepare_typed .
+	#
+	# +param_type_map+ is a PG::TypeMapByColumn with one encoder per statement parameter.
+	# +result_type_maps+ is an Array of two PG::TypeMapByColumn objects with one decoder per result column for text (index 0) and binary (index 1) result format.
+	TypedStatement = Struct.new(:param_type_map, :result_type_maps)
+
+	# call-seq:
+	#    conn.prepare_typed(stmt_name, sql [, param_types ] [, coder_maps: nil ] ) -> PG::Result
+	#
+	# Prepares a statement like #prepare and builds type maps for its parameters and result columns.
+	#
+	# After preparation the statement is described by #describe_prepared once.
+	# The reported parameter and result column OIDs are translated to encoders and decoders of +coder_maps+ (a PG::BasicTypeRegistry::CoderMapsBundle).
+	# If +coder_maps+ is not given, the bundle of #type_map_for_queries or #type_map_for_results is used, if it is a PG::BasicTypeMapForQueries or PG::BasicTypeMapForResults .
+	# Otherwise a new bundle is retrieved from the server once per connection.
+	#
+	# The type maps are stored with the statement and used by #exec_prepared automatically, as long as no explicit +type_map+ is given there.
+	# An explicit +type_map+ replaces both, so that the result is decoded per #type_map_for_results then.
+	# This avoids the per value lookup of encoders by class and decoders by OID on each execution:
+	#
+	#   conn.prepare_typed("ins", "INSERT INTO users (id, born) VALUES ($1, $2) RETURNING *")
+	#   conn.exec_prepared("ins", [5, Date.new(2000, 1, 1)]).to_a
+	#     # => [{"id"=>5, "born"=>#<Date: 2000-01-01>}]
+	#
+	# The type maps are dropped, when the statement is prepared again by #prepare, closed by #close_prepared or the connection is reset.
+	# Deallocation per SQL <tt>DEALLOCATE</tt> is not tracked.
+	#
+	# Parameters are sent in text format.
+	# Types without a registered coder are passed as String.
+	#
+	# Returns the PG::Result of #describe_prepared .
+	def prepare_typed(name, sql, param_types=nil, coder_maps: nil)
+		prepare(name, sql, param_types).clear
+		desc = describe_prepared(name)
+		coder_maps ||= coder_maps_for_typed_statements
+
+		encoders = coder_maps.map_for(0, :encoder)
+		param_type_map = PG::TypeMapByColumn.new(Array.new(desc.nparams) { |i| encoders.coder_by_oid(desc.paramtype(i)) })
+		result_type_maps = [0, 1].map do |format|
+			decoders = coder_maps.map_for(format, :decoder)
+			PG::TypeMapByColumn.new(Array.new(desc.nfields) { |i| decoders.coder_by_oid(desc.ftype(i)) }).freeze
+		end
+
+		(@typed_statements ||= {})[name] = TypedStatement.new(param_type_map.freeze, result_type_maps.freeze).freeze
+		desc
+	end
+
+	# Returns the PG::Connection::TypedStatement of a statement prepared by #prepare_typed or +nil+.
+	def typed_statement(name)
+		@typed_statements&.[](name)
+	end
+
+	private def coder_maps_for_typed_statements
+		[type_map_for_queries, type_map_for_results].each do |tm|
+			return tm.coder_maps_bundle if tm.respond_to?(:coder_maps_bundle)
+		end
+		@coder_maps_for_typed_statements ||= PG::BasicTypeRegistry::CoderMapsBundle.new(self)
+	end
+
+	alias c_async_exec_prepared async_exec_prepared
+	alias c_sync_exec_prepared sync_exec_prepared
+	private :c_async_exec_prepared, :c_sync_exec_prepared
+
+	# Execute a prepared statement and apply the type maps of #prepare_typed, if the statement was prepared that way.
+	private def exec_typed_statement(c_meth, name, params, result_format, type_map, **kwargs)
+		if (ts = @typed_statements&.[](name))
+			res = __send__(c_meth, name, params, result_format, type_map || ts.param_type_map, **kwargs)
+			res.type_map = ts.result_type_maps[result_format.to_i] unless type_map
+		else
+			res = __send__(c_meth, name, params, result_format, type_map, **kwargs)
+		end
+
+		if block_given?
+			begin
+				return yield res
+			ensure
+				res.clear
+			end
+		end
+		res
+	end
+
+	def async_exec_prepared(name, params=nil, result_format=nil, type_map=nil, timeout: nil, &block)
+		if timeout
+			exec_typed_statement(:c_async_exec_prepared, name, params, result_format, type_map, timeout: timeout, &block)
+		else
+			exec_typed_statement(:c_async_exec_prepared, name, params, result_format, type_map, &block)
+		end
+	end
+
+	def sync_exec_prepared(name, params=nil, result_format=nil, type_map=nil, &block)
+		exec_typed_statement(:c_sync_exec_prepared, name, params, result_format, type_map, &block)
+	end
+
+	# Re-preparing or closing a statement drops the type maps of #prepare_typed.
+	%i[async_prepare sync_prepare send_prepare].each do |meth|
+		alias_method "c_#{meth}", meth
+		private "c_#{meth}"
+
+		define_method(meth) do |name, *args, &block|
+			@typed_statements&.delete(name)
+			__send__("c_#{meth}", name, *args, &block)
+		end
+	end
+
+	%i[async_close_prepared sync_close_prepared send_close_prepared].each do |meth|
+		next unless method_defined?(meth)
+		alias_method "c_#{meth}", meth
+		private "c_#{meth}"
+
+		define_method(meth) do |name|
+			@typed_statements&.delete(name)
+			__send__("c_#{meth}", name)
+		end
+	end
+
+	alias c_sync_reset sync_reset
+	private :c_sync_reset
+
+	def sync_reset
+		# Prepared statements don't survive the new session
+		@typed_statements = nil
+		c_sync_reset
+	end
+
 	module Pollable
 		# Track the progress of the connection, waiting for the socket to become readable/writable before polling it.
 		#
@@ -996,6 +1321,7 @@ class PG::Connection
 				end
 				hostaddrs.map { |hostaddr| [hostaddr, mhost, iports[idx]] }
 			end
+			dests = host_router.order(dests, iopts) if host_router
 			iopts.merge(
 				hostaddr: dests.map{|d| d[0] }.join(","),
 				host: dests.map{|d| d[1] }.join(","),
@@ -1042,6 +1368,8 @@ class PG::Connection
 			else
 				# No host given
 			end
+			router = host_router
+			start = Process.clock_gettime(Process::CLOCK_MONOTONIC) if router
 			conn = connect_start(iopts) or
 										raise(PG::Error, "Unable to create a new connection")
 
@@ -1049,10 +1377,22 @@ class PG::Connection
 
 			# save the connection options for conn.reset
 			conn.instance_variable_set(:@iopts_for_reset, iopts_for_reset)
-			conn.send(:async_connect_or_reset, :connect_poll)
+			begin
+				conn.send(:async_connect_or_reset, :connect_poll)
+			rescue PG::ConnectionBad
+				router&.invalidate(iopts[:hostaddr].to_s.split(",", -1).zip(iopts[:host].to_s.split(",", -1), iopts[:port].to_s.split(",", -1)))
+				raise
+			end
+			router&.connected(conn, Process.clock_gettime(Process::CLOCK_MONOTONIC) - start)
 			conn
 		end
 
+		# The PG::HostRouter used to sort multiple hosts before connecting or +nil+ (default).
+		#
+		# If set, PG::Connection.new and PG::Connection#reset probe the health state and round trip time of all given hosts and try the fastest healthy host first.
+		# See PG::HostRouter for details.
+		attr_accessor :host_router
+
 		private def host_is_named_pipe?(host_string)
 			host_string.empty? || host_string.start_with?("/") ||  # it's UnixSocket?
 							host_string.start_with?("@") ||  # it's UnixSocket in the abstract namespace?
@@ -1094,6 +1434,32 @@ class PG::Connection
 		end
 		alias async_ping ping
 
+		# call-seq:
+		#    PG::Connection.cancel_all(conns, timeout: nil) -> Array
+		#
+		# Requests cancellation of the commands currently processed on all given connections.
+		#
+		# On PostgreSQL-17+ client library all cancel requests are sent concurrently in one nonblocking polling loop, using the reusable PG::Connection#cancel_connection of each connection.
+		# So a slow or unreachable server doesn't delay the cancellation on other servers.
+		# On older client library PG::Connection#cancel is called on each connection one after the other.
+		#
+		# +timeout+ is the maximum time in seconds to wait for all cancel requests to be sent.
+		#
+		# Returns an Array with one element per connection, which is +nil+ on success or a String with the error message.
+		def cancel_all(conns, timeout: nil)
+			if defined?(PG::CancelConnection)
+				cancons = []
+				begin
+					conns.each { |conn| cancons << conn.send(:checkout_cancel_connection) }
+					PG::CancelConnection.cancel_all(cancons, timeout: timeout)
+				ensure
+					conns.zip(cancons) { |conn, cancon| conn.send(:checkin_cancel_connection, cancon) if cancon }
+				end
+			else
+				conns.map(&:cancel)
+			end
+		end
+
 		REDIRECT_CLASS_METHODS = PG.make_shareable({
 			:new => [:async_connect, :sync_connect],
 			:connect => [:async_connect, :sync_connect],
@@ -0,0 +1,155 @@
+# -*- ruby -*-
+# frozen_string_literal: true
+
+require 'pg' unless defined?( PG )
+require 'zlib'
+
+# Load rows into one table through several parallel COPY streams.
+#
+# Each connection runs one <tt>COPY ... FROM STDIN</tt> command in its own thread.
+# The rows of the row source are distributed to the streams either by a key function or round robin.
+# They are passed in batches to the stream threads, which encode them by the given coder and send them per PG::Connection#copy_writer .
+# Since libpq's send and wait functions release the GVL, the streams are sent to the server in parallel.
+#
+#   conns = 4.times.map { PG.connect(dbname: "test") }
+#   enco = PG::TextEncoder::CopyRow.new
+#   loader = PG::CopyLoader.new(conns, "COPY measurements FROM STDIN", enco, partition_by: ->(row) { row[0] })
+#   loader.load(rows) do |stream|
+#     puts "stream #{stream.index}: #{stream.error || stream.result.cmd_tuples}"
+#   end
+#
+# A failing stream doesn't stop the other streams.
+# Its COPY command is aborted like in PG::Connection#copy_data and the remaining rows of its partition are counted as dropped.
+# Rows are not moved to other streams, so that the partitioning stays stable.
+# An exception raised by the row source aborts all streams and is re-raised by #load .
+#
+# Note that each stream is a separate transaction, unless the connections are in a common distributed transaction.
+class PG::CopyLoader
+	# The final state of one COPY stream.
+	#
+	# +index+ is the position of the connection in the list given to PG::CopyLoader.new .
+	# +result+ is the PG::Result of the COPY command or +nil+ if the stream failed with +error+.
+	# +rows+ is the number of rows assigned to the stream and +dropped+ the number of these rows discarded after a failure.
+	Stream = Struct.new(:index, :connection, :result, :error, :rows, :dropped) do
+		def success?
+			error.nil?
+		end
+	end
+
+	# Signals the stream threads to abort the COPY command.
+	class Aborted < StandardError
+	end
+
+	# The connections used for the COPY streams.
+	attr_reader :connections
+	# The COPY command executed on each connection.
+	attr_reader :sql
+	# The PG::Coder used to encode the rows or +nil+ if rows are given as encoded Strings.
+	attr_reader :coder
+	# The number of rows passed to a stream thread at once.
+	attr_reader :batch_size
+
+	# Create a new loader.
+	#
+	# +connections+ is an Array of PG::Connection objects, which must be idle and in blocking mode.
+	# +partition_by+ is an optional object responding to +call+ which returns a key for each row.
+	# Rows with the same key are sent through the same connection.
+	# The connection is selected by the CRC32 of the String representation of the key, so that the assignment doesn't change between processes.
+	# Without +partition_by+ rows are distributed round robin.
+	# +queue_size+ is the number of batches per stream which are buffered before the row source is paused.
+	# +buffer_size+ is passed to PG::Connection#copy_writer .
+	def initialize(connections, sql, coder=nil, partition_by: nil, batch_size: 1000, queue_size: 4, buffer_size: 65536)
+		raise ArgumentError, "at least one connection is required" if connections.empty?
+		@connections = connections
+		@sql = sql
+		@coder = coder
+		@partition_by = partition_by
+		@batch_size = batch_size
+		@queue_size = queue_size
+		@buffer_size = buffer_size
+		@mutex = Thread::Mutex.new
+	end
+
+	# Send all rows of +rows+ through the COPY streams.
+	#
+	# +rows+ can be any object responding to +each+.
+	# Blocks until all streams are finished and returns an Array of PG::CopyLoader::Stream objects in the order of the connections.
+	#
+	# If a block is given, each PG::CopyLoader::Stream is yielded in the order the streams finish, after all rows were passed to the streams.
+	def load(rows)
+		streams = @connections.each_with_index.map do |conn, idx|
+			Stream.new(idx, conn, nil, nil, 0, 0)
+		end
+		queues = streams.map { Thread::SizedQueue.new(@queue_size) }
+		finished = Thread::Queue.new
+		threads = streams.zip(queues).map do |stream, queue|
+			Thread.new do
+				run_stream(stream, queue)
+			ensure
+				finished.push(stream)
+			end
+		end
+		batches = Array.new(streams.size) { [] }
+
+		begin
+			rr = -1
+			rows.each do |row|
+				idx = if @partition_by
+					Zlib.crc32(@partition_by.call(row).to_s) % streams.size
+				else
+					rr += 1
+					rr % streams.size
+				end
+				batch = batches[idx]
+				batch << row
+				if batch.size >= @batch_size
+					enqueue(streams[idx], queues[idx], batch)
+					batches[idx] = []
+				end
+			end
+			streams.each_with_index do |stream, idx|
+				enqueue(stream, queues[idx], batches[idx]) unless batches[idx].empty?
+				queues[idx].close
+			end
+			streams.size.times { yield finished.pop } if block_given?
+		rescue Exception => err
+			queues.each do |queue|
+				queue.clear
+				begin
+					queue.push(err)
+				rescue ClosedQueueError
+				end
+				queue.close
+			end
+			raise
+		ensure
+			threads.each(&:join)
+		end
+
+		streams
+	end
+
+	private def enqueue(stream, queue, batch)
+		stream.rows += batch.size
+		queue.push(batch)
+	rescue ClosedQueueError
+		# The stream failed before
+		@mutex.synchronize { stream.dropped += batch.size }
+	end
+
+	private def run_stream(stream, queue)
+		stream.result = stream.connection.copy_writer(@sql, @coder, buffer_size: @buffer_size) do |writer|
+			while batch = queue.pop
+				raise Aborted, "COPY aborted: #{batch.message}" if batch.is_a?(Exception)
+				writer.write_rows(batch)
+			end
+		end
+	rescue Exception => err
+		stream.error = err
+		queue.close
+		# Count the rows which were queued but not sent
+		while batch = (queue.pop(true) rescue nil)
+			@mutex.synchronize { stream.dropped += batch.size } unless batch.is_a?(Exception)
+		end
+	end
+end
@@ -0,0 +1,76 @@
+# -*- ruby -*-
+# frozen_string_literal: true
+
+require 'pg' unless defined?( PG )
+
+# Buffered writer for the data of a <tt>COPY ... FROM STDIN</tt> command.
+#
+# Objects of this class are created by PG::Connection#copy_writer .
+#
+# Rows are encoded by the given coder (typically PG::TextEncoder::CopyRow or PG::BinaryEncoder::CopyRow) into one reusable buffer String.
+# The buffer is sent to the server by one call to libpq's +PQputCopyData+ each time it exceeds +buffer_size+ bytes.
+# This avoids one +PQputCopyData+ call per row, which dominates bulk loads with PG::Connection#put_copy_data .
+# PG::TextEncoder::CopyRow, PG::TextEncoder::CopyCsvRow and PG::BinaryEncoder::CopyRow write directly into the buffer, so that no String is allocated per row.
+# Other coders may need an intermediate String per row.
+#
+#   enco = PG::TextEncoder::CopyRow.new
+#   conn.copy_writer("COPY my_table FROM STDIN", enco) do |writer|
+#     writer << ["some", "data", "to", "copy"]
+#     writer.write_rows([["more", "data", "to", "copy"], ["even", "more", "data", "to copy"]])
+#   end
+class PG::CopyWriter
+	BinarySignature = "PGCOPY\n\377\r\n\0".b
+	private_constant :BinarySignature
+
+	# The PG::Connection the data is sent to.
+	attr_reader :connection
+	# The PG::Coder used to encode the rows or +nil+ if rows are given as encoded Strings.
+	attr_reader :coder
+	# The number of bytes to buffer before data is sent to the server.
+	attr_reader :buffer_size
+
+	# Create a new writer for an already started COPY command.
+	#
+	# If +binary+ is +true+ the binary COPY header and trailer are written by the writer.
+	def initialize(connection, coder, buffer_size: 65536, binary: false)
+		@connection = connection
+		@coder = coder
+		@buffer_size = buffer_size
+		@binary = binary
+		@buffer = String.new(capacity: buffer_size + 1024, encoding: Encoding::BINARY)
+		# Binary file header (11 byte signature, 32 bit flags and 32 bit extension length)
+		@buffer << BinarySignature << ("\x00" * 8) if binary
+		@single_row = [nil]
+	end
+
+	# Encode one row and append it to the buffer.
+	def write_row(row)
+		@single_row[0] = row
+		write_rows(@single_row)
+	ensure
+		@single_row[0] = nil
+	end
+	alias << write_row
+
+	# Encode all rows of the given Array and append them to the buffer.
+	#
+	# The rows are processed in one call to the C extension.
+	def write_rows(rows)
+		@connection.send(:put_copy_rows_buffered, rows, @coder, @buffer, @buffer_size, false)
+		self
+	end
+
+	# Send all buffered data to the server.
+	def flush
+		@connection.send(:put_copy_rows_buffered, [], @coder, @buffer, @buffer_size, true)
+		self
+	end
+
+	# Send the remaining data inclusive the binary trailer to the server.
+	#
+	# This is called by PG::Connection#copy_writer at the end of the block.
+	def finish
+		@buffer << "\xFF\xFF".b if @binary # Binary file trailer 16 bit "-1"
+		flush
+	end
+end
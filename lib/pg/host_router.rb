@@ -0,0 +1,148 @@
+# -*- ruby -*-
+# frozen_string_literal: true
+
+require 'pg' unless defined?( PG )
+
+# Latency aware routing of new connections to one of several hosts.
+#
+# The router keeps a process wide table of the health state of all hosts it has seen.
+# It is used by PG::Connection.new and PG::Connection#reset when assigned to PG::Connection.host_router :
+#
+#   PG::Connection.host_router = PG::HostRouter.new
+#   conn = PG.connect(host: "pg1.example.com,pg2.example.com,pg3.example.com", target_session_attrs: "prefer-standby")
+#
+# Before a connection is started, all resolved host addresses with an outdated health state are probed by PG::Connection.ping in parallel and the round trip time is measured.
+# The time to establish a successful connection is recorded as well.
+# The addresses are then passed to libpq in the following order:
+# 1. healthy hosts before hosts which didn't respond or reject connections
+# 2. for read-only connections (+target_session_attrs+ set to +read-only+, +standby+ or +prefer-standby+): known replicas before unknown hosts before known primaries
+# 3. lower round trip time first
+#
+# All hosts are kept in the list, so that libpq fails over to the next host if the preferred one is not available.
+# Hosts of failed connection attempts are probed again on the next connect.
+#
+# Since libpq shuffles the hosts when +load_balance_hosts+ is set to +random+, this option should not be used together with a router.
+class PG::HostRouter
+	# Health state of one host address.
+	#
+	# +rtt+ is the smoothed round trip time in seconds or +nil+ if unknown.
+	# +healthy+ is +true+ if the server accepted connections at the last check.
+	# +standby+ is +true+ for a replica, +false+ for a primary server and +nil+ if unknown.
+	Entry = Struct.new(:rtt, :healthy, :standby, :checked_at)
+
+	READ_ONLY_SESSION_ATTRS = %w[ read-only standby prefer-standby ].freeze
+	private_constant :READ_ONLY_SESSION_ATTRS
+
+	# Weight of a new RTT sample in the smoothed RTT value.
+	RTT_SMOOTHING = 0.3
+
+	# Seconds after which the health state of a host is probed again.
+	attr_reader :ttl
+
+	# The +connect_timeout+ in seconds used to probe a host.
+	attr_reader :probe_timeout
+
+	def initialize(ttl: 30, probe_timeout: 2)
+		@ttl = ttl
+		@probe_timeout = probe_timeout
+		@entries = {}
+		@mutex = Thread::Mutex.new
+	end
+
+	# Retrieve the health state of a host address as PG::HostRouter::Entry or +nil+ if the host is unknown.
+	def [](hostaddr, host, port)
+		@mutex.synchronize { @entries[key(hostaddr, host, port)]&.dup }
+	end
+
+	# Update the health state of a host address.
+	#
+	# +rtt+ is a new RTT sample in seconds or +nil+.
+	# A +standby+ value of +nil+ keeps the previously known server role.
+	def record(hostaddr, host, port, rtt:, healthy:, standby: nil)
+		k = key(hostaddr, host, port)
+		@mutex.synchronize do
+			e = @entries[k] ||= Entry.new
+			if rtt
+				e.rtt = e.rtt ? e.rtt + (rtt - e.rtt) * RTT_SMOOTHING : rtt
+			end
+			e.healthy = healthy
+			e.standby = standby unless standby.nil?
+			e.checked_at = now
+		end
+		self
+	end
+
+	# Mark the given host addresses as outdated, so that they are probed on the next connect.
+	def invalidate(dests)
+		@mutex.synchronize do
+			dests.each do |d|
+				e = @entries[key(*d)]
+				e.checked_at = nil if e
+			end
+		end
+		self
+	end
+
+	# Forget all health state.
+	def clear
+		@mutex.synchronize { @entries.clear }
+		self
+	end
+
+	# Sort the destinations in the order they should be tried.
+	#
+	# +dests+ is an Array of <tt>[hostaddr, host, port]</tt> triples and +iopts+ the Hash of connection options.
+	# Hosts with outdated health state are probed before.
+	def order(dests, iopts)
+		return dests if dests.size < 2
+
+		probe(dests.reject { |d| fresh?(*d) }.uniq, iopts)
+
+		read_only = READ_ONLY_SESSION_ATTRS.include?(iopts[:target_session_attrs])
+		dests.each_with_index.sort_by do |d, idx|
+			e = self[*d]
+			[
+				e&.healthy ? 0 : 1,
+				read_only ? (e.nil? || e.standby.nil? ? 1 : e.standby ? 0 : 2) : 0,
+				e&.rtt || Float::INFINITY,
+				idx,
+			]
+		end.map(&:first)
+	end
+
+	# Record the establishment of the connection +conn+ which took +rtt+ seconds.
+	def connected(conn, rtt)
+		standby = case conn.parameter_status("in_hot_standby")
+			when "on" then true
+			when "off" then false
+		end
+		record(conn.hostaddr, conn.host, conn.port, rtt: rtt, healthy: true, standby: standby)
+	end
+
+	private def probe(dests, iopts)
+		dests.map do |hostaddr, host, port|
+			Thread.new do
+				opts = iopts.merge(hostaddr: hostaddr, host: host, port: port, connect_timeout: @probe_timeout).compact
+				start = now
+				res = PG::Connection.ping(opts)
+				healthy = res == PG::PQPING_OK
+				record(hostaddr, host, port, rtt: healthy ? now - start : nil, healthy: healthy)
+			end
+		end.each(&:join)
+	end
+
+	private def fresh?(hostaddr, host, port)
+		checked_at = @mutex.synchronize { @entries[key(hostaddr, host, port)]&.checked_at }
+		checked_at && now - checked_at < @ttl
+	end
+
+	private def key(hostaddr, host, port)
+		port = port.to_s
+		port = PG::DEF_PGPORT.to_s if port.empty?
+		[hostaddr.to_s, host.to_s, port]
+	end
+
+	private def now
+		Process.clock_gettime(Process::CLOCK_MONOTONIC)
+	end
+end
@@ -0,0 +1,184 @@
+# -*- ruby -*-
+# frozen_string_literal: true
+
+require 'pg' unless defined?( PG )
+
+# Client for the streaming replication protocol.
+#
+# The stream is received through a PG::Connection which is opened in replication mode (<tt>replication: "database"</tt> for logical replication or <tt>replication: true</tt> for physical replication).
+# Messages are parsed in C and the standby status updates are built without allocating Ruby objects.
+#
+# With +publications+ the stream runs logical replication with the +pgoutput+ plugin and yields the decoded messages:
+# * PG::ReplicationStream::Begin , PG::ReplicationStream::Commit
+# * PG::ReplicationStream::Relation - the description of a table, which is sent before the first change of the table
+# * PG::ReplicationStream::Insert , PG::ReplicationStream::Update , PG::ReplicationStream::Delete - the changed rows decoded through the type map of the relation
+# * PG::ReplicationStream::Truncate
+# * PG::ReplicationStream::Other - all other messages with the raw data
+#
+# Without +publications+ the stream runs physical replication and yields PG::ReplicationStream::XLogData with the raw WAL data.
+#
+# Example:
+#   conn = PG.connect(dbname: "test", replication: "database")
+#   stream = PG::ReplicationStream.new(conn, "my_slot", publications: ["my_pub"], type_map: PG::BasicTypeMapForResults.new(conn))
+#   stream.each do |event|
+#     case event
+#     when PG::ReplicationStream::Insert
+#       p event.relation.name => event.new_tuple
+#     when PG::ReplicationStream::Commit
+#       stream.acknowledge(event.end_lsn)
+#     end
+#   end
+#
+# Unchanged TOASTed values of Update messages are returned as the Symbol +:unchanged_toast+.
+# Streaming of in-progress transactions (pgoutput option +streaming+) is not supported.
+class PG::ReplicationStream
+	# The name of the replication slot.
+	attr_reader :slot
+	# The names of the publications of a logical stream or +nil+ for physical replication.
+	attr_reader :publications
+	# Seconds between two standby status updates sent to the server.
+	attr_reader :status_interval
+
+	# Parse a WAL position of the form <tt>"16/B374D848"</tt> to an Integer.
+	def self.parse_lsn(str)
+		hi, lo = str.split("/", 2)
+		(hi.to_i(16) << 32) | lo.to_i(16)
+	end
+
+	# Format an Integer WAL position as <tt>"16/B374D848"</tt>.
+	def self.format_lsn(lsn)
+		format("%X/%X", lsn >> 32, lsn & 0xFFFFFFFF)
+	end
+
+	# Create a new stream on the replication connection +connection+ for the replication slot +slot+.
+	#
+	# +start_lsn+ is the WAL position to start from.
+	# The default +0+ starts at the confirmed position of a logical replication slot.
+	# +proto_version+ and +options+ are passed to the pgoutput plugin.
+	# +type_map+ is a PG::TypeMapByOid (like PG::BasicTypeMapForResults) which is used to decode the column values of logical replication.
+	# Without +type_map+ all values are returned as String.
+	def initialize(connection, slot, start_lsn: 0, publications: nil, proto_version: 1, options: {}, status_interval: 10, type_map: nil)
+		init_stream(connection, !publications.nil?)
+		@slot = slot
+		@start_lsn = start_lsn.is_a?(String) ? self.class.parse_lsn(start_lsn) : start_lsn
+		@publications = publications && Array(publications)
+		@proto_version = proto_version
+		@options = options
+		@status_interval = status_interval
+		@coders = type_map&.coders&.each_with_object({}) do |coder, h|
+			h[coder.oid] = coder if coder.format == 0
+		end
+		@started = false
+		@next_status = nil
+	end
+
+	# Whether the stream decodes pgoutput messages.
+	def logical?
+		!@publications.nil?
+	end
+
+	# Send the +START_REPLICATION+ command to the server.
+	#
+	# It is called by #each if the stream isn't started yet.
+	def start
+		sql = +"START_REPLICATION SLOT #{connection.quote_ident(@slot)}"
+		sql << " LOGICAL" if logical?
+		sql << " " << self.class.format_lsn(@start_lsn)
+		if logical?
+			opts = {
+				"proto_version" => @proto_version.to_s,
+				"publication_names" => @publications.map { |pub| connection.quote_ident(pub) }.join(","),
+			}.merge(@options)
+			sql << " (" << opts.map { |key, val| "#{connection.quote_ident(key.to_s)} '#{val.to_s.gsub("'", "''")}'" }.join(", ") << ")"
+		end
+
+		res = connection.exec(sql)
+		unless res.result_status == PG::PGRES_COPY_BOTH
+			raise PG::Error.new("unexpected result of START_REPLICATION: #{res.res_status}", connection: connection)
+		end
+		@started = true
+		@next_status = clock + @status_interval
+		self
+	end
+
+	# Receive the stream and yield each decoded message.
+	#
+	# Keepalive messages are answered internally and a standby status update is sent every #status_interval seconds.
+	# The block is called until the server ends the stream or #stop is called.
+	#
+	# Returns the final PG::Result of the stream or +nil+ if it was ended by #stop .
+	def each
+		return enum_for(:each) unless block_given?
+		start unless @started
+
+		while @started && (data = next_message)
+			event = decode_message(data)
+			case event
+			when Keepalive
+				send_status(reply: false) if event.reply_requested
+			when Relation
+				event.type_map = type_map_for(event) if @coders
+				yield event
+			else
+				yield event
+			end
+			send_status if @started && clock >= @next_status
+		end
+		return nil unless @started
+		@started = false
+		connection.get_last_result
+	end
+
+	# Confirm that all data up to WAL position +lsn+ is processed by the client.
+	#
+	# The position is sent to the server with the next standby status update.
+	# The server may then remove the WAL up to this position from the replication slot.
+	def acknowledge(lsn)
+		self.flushed_lsn = lsn
+		self.applied_lsn = lsn
+	end
+
+	# Send a standby status update with #received_lsn , #flushed_lsn and #applied_lsn immediately.
+	#
+	# If +reply+ is +true+ the server is requested to answer with a keepalive message.
+	def send_status(reply: false)
+		send_status_update(reply)
+		connection.flush
+		@next_status = clock + @status_interval
+		nil
+	end
+
+	# End the stream.
+	#
+	# A final standby status update is sent before the replication is ended.
+	# Returns the final PG::Result of the stream.
+	def stop
+		send_status
+		connection.put_copy_end
+		# Discard the data which was sent before the server received the end of the stream
+		while connection.get_copy_data
+		end
+		@started = false
+		connection.get_last_result
+	end
+
+	private def next_message
+		loop do
+			data = connection.get_copy_data(true)
+			return data unless data == false
+
+			now = clock
+			send_status if now >= @next_status
+			connection.socket_io.wait_readable(@next_status - now)
+			connection.consume_input
+		end
+	end
+
+	private def type_map_for(relation)
+		PG::TypeMapByColumn.new(relation.columns.map { |col| @coders[col.type_oid] })
+	end
+
+	private def clock
+		Process.clock_gettime(Process::CLOCK_MONOTONIC)
+	end
+end
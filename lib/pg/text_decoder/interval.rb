@@ -0,0 +1,25 @@
+# -*- ruby -*-
+# frozen_string_literal: true
+
+module PG
+	module TextDecoder
+		# Init C part of the decoder
+		init_interval
+
+		# Options of PG::TextDecoder::Interval and PG::BinaryDecoder::Interval
+		module IntervalOptions
+			# Return intervals as Float seconds instead of <tt>[months, days, microseconds]</tt> .
+			def to_seconds=(value)
+				self.flags = value ? flags | PG::Coder::INTERVAL_TO_SECONDS : flags & ~PG::Coder::INTERVAL_TO_SECONDS
+			end
+
+			def to_seconds
+				flags & PG::Coder::INTERVAL_TO_SECONDS != 0
+			end
+		end
+
+		class Interval < SimpleDecoder
+			include IntervalOptions
+		end
+	end
+end # module PG
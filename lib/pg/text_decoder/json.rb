@@ -5,13 +5,47 @@ require 'json'
 
 module PG
 	module TextDecoder
-		# This is a decoder class for conversion of PostgreSQL JSON/JSONB type to Ruby Hash, Array, String, Numeric, nil values.
-		#
-		# As soon as this class is used, it requires the ruby standard library 'json'.
-		class JSON < SimpleDecoder
-			def decode(string, tuple=nil, field=nil)
-				::JSON.parse(string)
+		# Init C part of the decoder
+		init_json
+
+		# Options of PG::TextDecoder::JSON and PG::BinaryDecoder::JSON
+		module JSONOptions
+			# Return Hash keys as Symbols instead of Strings.
+			def symbolize_names=(value)
+				self.flags = value ? flags | PG::Coder::JSON_SYMBOLIZE_NAMES : flags & ~PG::Coder::JSON_SYMBOLIZE_NAMES
+			end
+
+			def symbolize_names
+				flags & PG::Coder::JSON_SYMBOLIZE_NAMES != 0
+			end
+
+			# Freeze all decoded Arrays and Hashes and deduplicate all Strings.
+			def deep_freeze=(value)
+				self.flags = value ? flags | PG::Coder::JSON_DEEP_FREEZE : flags & ~PG::Coder::JSON_DEEP_FREEZE
+			end
+
+			def deep_freeze
+				flags & PG::Coder::JSON_DEEP_FREEZE != 0
 			end
+
+			# Set to +BigDecimal+ to decode numbers with fraction or exponent as BigDecimal instead of Float.
+			def decimal_class=(klass)
+				if klass
+					PG.require_bigdecimal_without_warning
+					raise ArgumentError, "decimal_class must be BigDecimal or nil" unless klass == ::BigDecimal
+					self.flags = flags | PG::Coder::JSON_BIGDECIMAL
+				else
+					self.flags = flags & ~PG::Coder::JSON_BIGDECIMAL
+				end
+			end
+
+			def decimal_class
+				::BigDecimal if flags & PG::Coder::JSON_BIGDECIMAL != 0
+			end
+		end
+
+		class JSON < SimpleDecoder
+			include JSONOptions
 		end
 	end
 end # module PG
@@ -5,5 +5,31 @@ module PG
 	module TextDecoder
 		# Init C part of the decoder
 		init_numeric
+
+		# Options of PG::TextDecoder::Numeric and PG::BinaryDecoder::Numeric
+		module NumericOptions
+			# Return values without fractional part or with only zeros as fractional digits as Integer instead of BigDecimal.
+			def to_integer=(value)
+				self.flags = value ? flags | PG::Coder::NUMERIC_TO_INTEGER : flags & ~PG::Coder::NUMERIC_TO_INTEGER
+			end
+
+			def to_integer
+				flags & PG::Coder::NUMERIC_TO_INTEGER != 0
+			end
+
+			# Return values with at most 15 significant digits (Float::DIG) within the normalized range of Float as Float instead of BigDecimal.
+			# The value is then exactly given back by Float#to_s .
+			def to_float=(value)
+				self.flags = value ? flags | PG::Coder::NUMERIC_TO_FLOAT : flags & ~PG::Coder::NUMERIC_TO_FLOAT
+			end
+
+			def to_float
+				flags & PG::Coder::NUMERIC_TO_FLOAT != 0
+			end
+		end
+
+		class Numeric < SimpleDecoder
+			include NumericOptions
+		end
 	end
 end # module PG
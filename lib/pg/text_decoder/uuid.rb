@@ -0,0 +1,34 @@
+# -*- ruby -*-
+# frozen_string_literal: true
+
+module PG
+	module TextDecoder
+		# Init C part of the decoder
+		init_uuid
+
+		# Options of PG::TextDecoder::UUID and PG::BinaryDecoder::UUID
+		module UUIDOptions
+			# Return UUIDs as 16 byte binary Strings instead of canonical text.
+			def binary_string=(value)
+				self.flags = value ? flags | PG::Coder::UUID_BINARY : flags & ~PG::Coder::UUID_BINARY
+			end
+
+			def binary_string
+				flags & PG::Coder::UUID_BINARY != 0
+			end
+
+			# Return UUIDs as deduplicated frozen Strings.
+			def intern=(value)
+				self.flags = value ? flags | PG::Coder::UUID_INTERN : flags & ~PG::Coder::UUID_INTERN
+			end
+
+			def intern
+				flags & PG::Coder::UUID_INTERN != 0
+			end
+		end
+
+		class UUID < SimpleDecoder
+			include UUIDOptions
+		end
+	end
+end # module PG
@@ -0,0 +1,9 @@
+# -*- ruby -*-
+# frozen_string_literal: true
+
+module PG
+	module TextEncoder
+		# Init C part of the encoder
+		init_uuid
+	end
+end # module PG
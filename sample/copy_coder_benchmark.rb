@@ -0,0 +1,48 @@
+# -*- ruby -*-
+#
+# Benchmark of PG::TextDecoder::CopyRow and PG::TextEncoder::CopyRow with all
+# implementations of the COPY text scanner supported by the CPU (see PG.simd).
+# The "scalar" implementation is the byte by byte scan.
+#
+# No database connection is required.
+#
+#   ruby sample/copy_coder_benchmark.rb [rows] [field_size]
+
+require 'pg'
+require 'benchmark'
+
+nrows = (ARGV[0] || 100_000).to_i
+field_size = (ARGV[1] || 50).to_i
+
+rows = {
+	"clean text" => Array.new(6) { |i| ("abcdefghijklmnopqrstuvwxyz"[i..] * field_size)[0, field_size] },
+	"with escapes" => Array.new(6) { |i| ("abc\\def\tghi\njkl"[i..] * field_size)[0, field_size] },
+	"short fields" => %w[1 22 333 a bb ccc],
+}
+
+encoder = PG::TextEncoder::CopyRow.new
+decoder = PG::TextDecoder::CopyRow.new
+impls = %i[avx2 sse2 swar scalar].select do |impl|
+	PG.simd = impl
+	true
+rescue ArgumentError
+	false
+end
+PG.simd = impls.first
+
+puts "#{nrows} rows, #{field_size} bytes per field, implementations: #{impls.join(", ")}"
+rows.each do |title, row|
+	line = encoder.encode(row)
+	puts "\n#{title}: #{line.bytesize} bytes per line"
+	Benchmark.bm(14) do |x|
+		impls.each do |impl|
+			PG.simd = impl
+			x.report("decode #{impl}") { nrows.times { decoder.decode(line) } }
+		end
+		impls.each do |impl|
+			PG.simd = impl
+			x.report("encode #{impl}") { nrows.times { encoder.encode(row) } }
+		end
+	end
+end
+PG.simd = impls.first
@@ -0,0 +1,43 @@
+# -*- ruby -*-
+#
+# Benchmark of PG::TextDecoder::Integer with value distributions of the
+# PostgreSQL types int2, int4 and int8. The values are decoded as single values,
+# as elements of PG::TextDecoder::Array and as columns of PG::TextDecoder::CopyRow .
+# String#to_i is measured as a reference.
+#
+# No database connection is required.
+#
+#   ruby sample/integer_decoder_benchmark.rb [values]
+
+require 'pg'
+require 'benchmark'
+
+nvalues = (ARGV[0] || 1_000_000).to_i
+ncols = 10
+prng = Random.new(42)
+
+distributions = {
+	"int2" => -> { prng.rand(-32768..32767) },
+	"int4 serial" => -> { prng.rand(1..10_000_000) },
+	"int4" => -> { prng.rand(-2**31...2**31) },
+	"int8" => -> { prng.rand(-2**63...2**63) },
+}
+
+int_dec = PG::TextDecoder::Integer.new
+array_dec = PG::TextDecoder::Array.new(elements_type: int_dec)
+copy_dec = PG::TextDecoder::CopyRow.new(type_map: PG::TypeMapByColumn.new([int_dec] * ncols))
+
+puts "#{nvalues} values per distribution"
+distributions.each do |title, gen|
+	values = Array.new(nvalues) { gen.call.to_s }
+	arrays = values.each_slice(100).map { |vals| "{#{vals.join(",")}}" }
+	lines = values.each_slice(ncols).map { |vals| vals.join("\t") + "\n" }
+
+	puts "\n#{title}: #{values.sum(&:bytesize) / nvalues.to_f} bytes per value"
+	Benchmark.bm(18) do |x|
+		x.report("String#to_i") { values.each { |v| v.to_i } }
+		x.report("Integer") { values.each { |v| int_dec.decode(v) } }
+		x.report("Array of Integer") { arrays.each { |v| array_dec.decode(v) } }
+		x.report("CopyRow of Integer") { lines.each { |v| copy_dec.decode(v) } }
+	end
+end
@@ -257,7 +257,7 @@ describe 'Basic type mapping' do
 				end
 			end
 
-			[0].each do |format|
+			[1, 0].each do |format|
 				it "should do format #{format} numeric type conversions", :bigdecimal do
 					small = '123456790123.12'
 					large = ('123456790'*10) << '.' << ('012345679')
@@ -278,7 +278,7 @@ describe 'Basic type mapping' do
 				end
 			end
 
-			[0].each do |format|
+			[0, 1].each do |format|
 				it "should do format #{format} JSON conversions" do
 					['JSON', 'JSONB'].each do |type|
 						res = @conn.exec_params( "SELECT CAST('123' AS #{type}),
@@ -299,6 +299,21 @@ describe 'Basic type mapping' do
 				end
 			end
 
+			[0, 1].each do |format|
+				it "should do format #{format} uuid conversions" do
+					res = @conn.exec_params( "SELECT CAST('A0EEBC99-9C0B-4EF8-BB6D-6BB9BD380A11' AS uuid)", [], format )
+					expect( res.getvalue(0,0) ).to eq( "a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11" )
+				end
+			end
+
+			[0, 1].each do |format|
+				it "should do format #{format} interval conversions" do
+					res = @conn.exec_params( "SELECT CAST('1 year 2 mons -3 days 04:05:06.5' AS interval), CAST('-00:00:00.000001' AS interval)", [], format )
+					expect( res.getvalue(0,0) ).to eq( [14, -3, 14706500000] )
+					expect( res.getvalue(0,1) ).to eq( [0, 0, -1] )
+				end
+			end
+
 			[0, 1].each do |format|
 				it "should do format #{format} array type conversions" do
 					res = @conn.exec_params( "SELECT CAST('{1,2,3}' AS INT2[]), CAST('{{1,2},{3,4}}' AS INT2[][]),
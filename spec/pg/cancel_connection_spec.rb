@@ -37,6 +37,43 @@ else
 			expect( conn.status ).to eq( PG::CONNECTION_ALLOCATED )
 		end
 
+		it "is reused by PG::Connection#cancel" do
+			cancon = @conn.cancel_connection
+			expect( cancon ).to be_a( PG::CancelConnection )
+			@conn.send_query "SELECT pg_sleep(10)"
+			expect( @conn.cancel ).to be_nil
+			expect{ @conn.get_last_result }.to raise_error(PG::QueryCanceled)
+			expect( @conn.cancel_connection ).to equal( cancon )
+			expect( cancon.status ).to eq( PG::CONNECTION_ALLOCATED )
+		end
+
+		it "is renewed after a connection reset", :without_transaction do
+			cancon = @conn.cancel_connection
+			@conn.reset
+			expect( @conn.cancel_connection ).not_to equal( cancon )
+		end
+
+		it "can send several cancel requests in one polling loop" do
+			conns = 2.times.map { PG.connect(@conninfo) }
+			conns.each { |c| c.send_query "SELECT pg_sleep(10)" }
+			cancons = conns.map { |c| PG::CancelConnection.new(c) }
+			expect( PG::CancelConnection.cancel_all(cancons) ).to eq( [nil, nil] )
+			conns.each do |c|
+				expect{ c.get_last_result }.to raise_error(PG::QueryCanceled)
+			end
+			expect( cancons.map(&:status) ).to eq( [PG::CONNECTION_OK, PG::CONNECTION_OK] )
+		ensure
+			conns&.each(&:finish)
+		end
+
+		it "reports the server of cancel requests which timed out" do
+			cancons = [PG::CancelConnection.new(@conn)]
+			errors = PG::CancelConnection.cancel_all(cancons, timeout: 0)
+			expect( errors.size ).to eq( 1 )
+			expect( errors[0] ).to match( /\S: timeout expired\z/ )
+			expect( cancons[0].status ).to eq( PG::CONNECTION_ALLOCATED )
+		end
+
 		it "can be finished" do
 			conn.finish
 			conn.finish
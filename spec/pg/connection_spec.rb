@@ -5,6 +5,7 @@ require_relative '../helpers'
 
 require 'timeout'
 require 'socket'
+require 'stringio'
 require 'pg'
 
 # Work around ruby bug: https://bugs.ruby-lang.org/issues/19562
@@ -1058,6 +1059,29 @@ describe PG::Connection do
 		expect( Time.now - start ).to be < 9.9
 	end
 
+	it "can cancel a query several times" do
+		2.times do
+			@conn.send_query "SELECT pg_sleep(10)"
+			sleep 0.1
+			expect( @conn.cancel ).to be_nil
+			expect{ @conn.get_last_result }.to raise_error(PG::QueryCanceled)
+		end
+	end
+
+	it "allows queries on several connections to be cancelled at once" do
+		conns = 2.times.map { PG.connect(@conninfo) }
+		conns.each { |conn| conn.send_query "SELECT pg_sleep(10)" }
+		sleep 0.1
+		start = Time.now
+		expect( PG::Connection.cancel_all(conns, timeout: 5) ).to eq( [nil, nil] )
+		conns.each do |conn|
+			expect{ conn.get_last_result }.to raise_error(PG::QueryCanceled)
+		end
+		expect( Time.now - start ).to be < 9.9
+	ensure
+		conns&.each(&:finish)
+	end
+
 	describe "#transaction" do
 
 		it "automatically rolls back a transaction if an exception is raised" do
@@ -1638,6 +1662,205 @@ describe PG::Connection do
 		end
 	end
 
+	describe "#copy_writer" do
+		before :each do
+			@conn.exec( "CREATE TEMP TABLE copytable (col1 TEXT, col2 INT)" )
+		end
+
+		it "writes rows in text format" do
+			enco = PG::TextEncoder::CopyRow.new
+			res = @conn.copy_writer( "COPY copytable FROM STDIN", enco, buffer_size: 100 ) do |writer|
+				expect( writer ).to be_a( PG::CopyWriter )
+				writer << ["a", 1]
+				writer.write_rows( 1000.times.map { |i| ["b\t#{i}", i] } )
+				writer.write_row( [nil, nil] )
+			end
+			expect( res.result_status ).to eq( PG::PGRES_COMMAND_OK )
+			expect( res.cmd_tuples ).to eq( 1002 )
+			expect( @conn.exec( "SELECT * FROM copytable WHERE col2 = 999" ).values ).to eq( [["b\t999", "999"]] )
+			expect( @conn.exec( "SELECT count(*) FROM copytable WHERE col1 IS NULL" ).values ).to eq( [["1"]] )
+		end
+
+		it "writes rows in binary format" do
+			enco = PG::BinaryEncoder::CopyRow.new( type_map: PG::TypeMapByColumn.new( [nil, PG::BinaryEncoder::Int4.new] ) )
+			@conn.copy_writer( "COPY copytable FROM STDIN (FORMAT binary)", enco ) do |writer|
+				writer.write_rows( [["a", 1], ["b", 2]] )
+			end
+			expect( @conn.exec( "SELECT * FROM copytable ORDER BY col2" ).values ).to eq( [["a", "1"], ["b", "2"]] )
+		end
+
+		it "writes preformatted rows without coder" do
+			@conn.copy_writer( "COPY copytable FROM STDIN" ) do |writer|
+				writer.write_rows( ["x\t1\n", "y\t2\n"] )
+			end
+			expect( @conn.exec( "SELECT * FROM copytable ORDER BY col2" ).values ).to eq( [["x", "1"], ["y", "2"]] )
+		end
+
+		it "drops the partial data of a row which fails to encode" do
+			bad = Object.new
+			def bad.to_s; raise ArgumentError, "bad value"; end
+			@conn.copy_writer( "COPY copytable FROM STDIN", PG::TextEncoder::CopyRow.new ) do |writer|
+				writer << ["a", 1]
+				expect{ writer << ["b", bad] }.to raise_error( ArgumentError, "bad value" )
+				writer << ["c", 3]
+			end
+			expect( @conn.exec( "SELECT * FROM copytable ORDER BY col2" ).values ).to eq( [["a", "1"], ["c", "3"]] )
+		end
+
+		it "aborts the COPY on exceptions" do
+			expect {
+				@conn.copy_writer( "COPY copytable FROM STDIN", PG::TextEncoder::CopyRow.new ) do |writer|
+					writer << ["a", 1]
+					raise "boom"
+				end
+			}.to raise_error( RuntimeError, "boom" )
+			expect( @conn ).to still_be_usable
+		end
+	end
+
+	describe "#copy_from_io and #copy_to_io" do
+		before :each do
+			@conn.exec( "CREATE TEMP TABLE copytable (col1 TEXT, col2 INT)" )
+		end
+
+		it "loads data from an IO" do
+			io = StringIO.new( 1000.times.map { |i| "row#{i}\t#{i}\n" }.join )
+			res = @conn.copy_from_io( "COPY copytable FROM STDIN", io, buffer_size: 100 )
+			expect( res.result_status ).to eq( PG::PGRES_COMMAND_OK )
+			expect( res.cmd_tuples ).to eq( 1000 )
+			expect( @conn.exec( "SELECT * FROM copytable WHERE col2 = 999" ).values ).to eq( [["row999", "999"]] )
+		end
+
+		it "writes data to an IO" do
+			@conn.exec( "INSERT INTO copytable SELECT 'row' || i, i FROM generate_series(0, 999) i" )
+			io = StringIO.new( "".b )
+			res = @conn.copy_to_io( "COPY copytable TO STDOUT", io, buffer_size: 100 )
+			expect( res.cmd_tuples ).to eq( 1000 )
+			expect( io.string ).to eq( 1000.times.map { |i| "row#{i}\t#{i}\n" }.join )
+		end
+
+		it "round trips binary COPY data through a pipe" do
+			@conn.exec( "INSERT INTO copytable VALUES ('a', 1), ('b', 2)" )
+			rd, wr = IO.pipe
+			@conn.copy_to_io( "COPY copytable TO STDOUT (FORMAT binary)", wr )
+			wr.close
+			@conn.exec( "TRUNCATE copytable" )
+			@conn.copy_from_io( "COPY copytable FROM STDIN (FORMAT binary)", rd )
+			rd.close
+			expect( @conn.exec( "SELECT * FROM copytable ORDER BY col2" ).values ).to eq( [["a", "1"], ["b", "2"]] )
+		end
+
+		it "aborts the COPY on IO errors" do
+			io = Object.new
+			def io.read(*) raise IOError, "read failed" end
+			expect {
+				@conn.copy_from_io( "COPY copytable FROM STDIN", io )
+			}.to raise_error( IOError, "read failed" )
+			expect( @conn ).to still_be_usable
+		end
+
+		it "refuses COPY commands of the wrong direction" do
+			expect {
+				@conn.copy_to_io( "COPY copytable FROM STDIN", StringIO.new )
+			}.to raise_error( ArgumentError, /COPY TO STDOUT/ )
+			expect( @conn ).to still_be_usable
+		end
+	end
+
+	describe "#copy_each_batch" do
+		it "yields decoded rows in batches" do
+			deco = PG::TextDecoder::CopyRow.new
+			batches = []
+			res = @conn.copy_each_batch( "COPY (SELECT generate_series(1, 2500), 'x') TO STDOUT", deco, max_rows: 1000 ) do |rows|
+				batches << rows
+			end
+			expect( res.result_status ).to eq( PG::PGRES_COMMAND_OK )
+			expect( batches.map(&:size).max ).to be <= 1000
+			expect( batches.flatten(1) ).to eq( (1..2500).map { |i| [i.to_s, "x"] } )
+		end
+
+		it "yields binary strings without decoder" do
+			rows = []
+			@conn.copy_each_batch( "COPY (SELECT generate_series(1, 3)) TO STDOUT" ) do |batch|
+				rows.concat batch
+			end
+			expect( rows ).to eq( ["1\n", "2\n", "3\n"] )
+		end
+
+		it "can process binary format" do
+			deco = PG::BinaryDecoder::CopyRow.new( type_map: PG::TypeMapByColumn.new( [PG::BinaryDecoder::Integer.new] ) )
+			rows = []
+			res = @conn.copy_each_batch( "COPY (SELECT generate_series(1, 3)::INT) TO STDOUT (FORMAT binary)", deco ) do |batch|
+				rows.concat batch
+			end
+			expect( res.result_status ).to eq( PG::PGRES_COMMAND_OK )
+			expect( rows ).to eq( [[1], [2], [3]] )
+		end
+
+		it "returns nil from #get_copy_rows after the last batch" do
+			@conn.copy_data( "COPY (SELECT 1) TO STDOUT" ) do
+				expect( @conn.get_copy_rows ).to eq( ["1\n"] )
+				expect( @conn.get_copy_rows ).to be_nil
+			end
+			expect( @conn ).to still_be_usable
+		end
+
+		it "can handle client errors" do
+			expect {
+				@conn.copy_each_batch( "COPY (SELECT generate_series(1, 10)) TO STDOUT" ) do |rows|
+					raise "boom"
+				end
+			}.to raise_error( RuntimeError, "boom" )
+			expect( @conn ).to still_be_usable
+		end
+	end
+
+	describe "#copy_stats" do
+		after :each do
+			@conn.disable_copy_stats
+		end
+
+		it "is nil unless enabled" do
+			expect( @conn.copy_stats ).to be_nil
+			@conn.enable_copy_stats
+			expect( @conn.copy_stats ).to include( rows: 0, bytes: 0, encode_ns: 0, decode_ns: 0, wait_ns: 0 )
+			@conn.disable_copy_stats
+			expect( @conn.copy_stats ).to be_nil
+		end
+
+		it "counts rows and bytes of COPY FROM STDIN and calls the progress block" do
+			progress = []
+			@conn.enable_copy_stats( 100 ) { |stats| progress << stats[:rows] }
+			@conn.exec( "CREATE TEMP TABLE copy_stats_test (id INT, name TEXT)" )
+			enco = PG::TextEncoder::CopyRow.new
+			@conn.copy_data( "COPY copy_stats_test FROM STDIN", enco ) do
+				250.times { |i| @conn.put_copy_data [i, "abc"] }
+				expect( @conn.copy_stats[:rows] ).to eq( 250 )
+			end
+
+			stats = @conn.copy_stats
+			expect( stats[:rows] ).to eq( 250 )
+			expect( stats[:bytes] ).to eq( (0...250).sum { |i| "#{i}\tabc\n".bytesize } )
+			expect( stats[:encode_ns] ).to be > 0
+			expect( stats[:elapsed_ns] ).to be >= stats[:encode_ns] + stats[:wait_ns]
+			expect( progress ).to eq( [100, 200] )
+		end
+
+		it "counts rows of COPY TO STDOUT and resets at the next COPY" do
+			@conn.enable_copy_stats
+			deco = PG::TextDecoder::CopyRow.new
+			@conn.copy_data( "COPY (SELECT generate_series(1, 10)) TO STDOUT", deco ) do
+				while @conn.get_copy_data
+				end
+			end
+			expect( @conn.copy_stats ).to include( rows: 10, bytes: 21 )
+			expect( @conn.copy_stats[:decode_ns] ).to be > 0
+
+			@conn.copy_each_batch( "COPY (SELECT generate_series(1, 3)) TO STDOUT" ) { }
+			expect( @conn.copy_stats ).to include( rows: 3, bytes: 6, decode_ns: 0 )
+		end
+	end
+
 	it "described_class#block shouldn't block a second thread" do
 		start = Time.now
 		t = Thread.new do
@@ -1886,6 +2109,139 @@ describe PG::Connection do
 		expect( result ).to eq( { 'one' => '47' } )
 	end
 
+	describe "query timeout" do
+		it "raises PG::QueryTimeout and cancels the query in #exec" do
+			start = Time.now
+			expect {
+				@conn.exec( "SELECT pg_sleep(10)", timeout: 0.1 )
+			}.to raise_error( PG::QueryTimeout, /timeout/ ){|err| expect(err).to have_attributes(connection: @conn) }
+			expect( Time.now - start ).to be < 9
+			expect( @conn.exec( "SELECT 1" ).values ).to eq( [["1"]] )
+		end
+
+		it "is a PG::QueryCanceled error" do
+			expect( PG::QueryTimeout.ancestors ).to include( PG::QueryCanceled )
+		end
+
+		it "raises PG::QueryTimeout in #exec_params and #exec_prepared" do
+			expect {
+				@conn.exec_params( "SELECT pg_sleep($1)", [10], timeout: 0.1 )
+			}.to raise_error( PG::QueryTimeout )
+			@conn.prepare( "sleeper", "SELECT pg_sleep($1)" )
+			expect {
+				@conn.exec_prepared( "sleeper", [10], timeout: 0.1 )
+			}.to raise_error( PG::QueryTimeout )
+			expect( @conn.exec_prepared( "sleeper", [0], timeout: 5 ).values ).to eq( [[""]] )
+		end
+
+		it "raises PG::QueryTimeout in #get_result" do
+			@conn.send_query( "SELECT pg_sleep(10)" )
+			expect {
+				@conn.get_result( timeout: 0.1 )
+			}.to raise_error( PG::QueryTimeout )
+			expect( @conn.get_result ).to be_nil
+		end
+
+		it "waits per #block in #get_result without timeout" do
+			@conn.send_query( "SELECT pg_sleep(0.1), 4" )
+			expect( @conn ).to receive( :block ).with( no_args ).and_call_original
+			expect( @conn.get_result{|r| r.values } ).to eq( [["", "4"]] )
+			expect( @conn.get_result ).to be_nil
+		end
+
+		it "resets the connection if the query can't be canceled", :without_transaction do
+			conn = PG.connect( @conninfo )
+			expect( conn ).to receive( :async_cancel ).and_raise( PG::ConnectionBad )
+			expect( conn ).to receive( :reset ).and_call_original
+			expect {
+				conn.exec( "SELECT pg_sleep(10)", timeout: 0.1 )
+			}.to raise_error( PG::QueryTimeout )
+			expect( conn.exec( "SELECT 5" ).values ).to eq( [["5"]] )
+		ensure
+			conn&.finish
+		end
+
+		it "resets the connection without waiting if the cancel request returns an error", :without_transaction do
+			conn = PG.connect( @conninfo )
+			expect( conn ).to receive( :async_cancel ).and_return( "cancel request failed" )
+			expect( conn ).to receive( :reset ).and_call_original
+			start = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+			expect {
+				conn.exec( "SELECT pg_sleep(10)", timeout: 0.1 )
+			}.to raise_error( PG::QueryTimeout )
+			expect( Process.clock_gettime(Process::CLOCK_MONOTONIC) - start ).to be < 1.0
+			expect( conn.exec( "SELECT 6" ).values ).to eq( [["6"]] )
+		ensure
+			conn&.finish
+		end
+
+		it "returns the result within the timeout" do
+			expect( @conn.exec( "SELECT 2", timeout: 10 ).values ).to eq( [["2"]] )
+			expect( @conn.exec( "SELECT 3", timeout: nil ).values ).to eq( [["3"]] )
+		end
+
+		it "rejects unknown keywords" do
+			expect{ @conn.exec( "SELECT 1", foo: 1 ) }.to raise_error( ArgumentError, /foo/ )
+		end
+	end
+
+	describe "#prepare_typed" do
+		it "builds type maps from the statement description" do
+			desc = @conn.prepare_typed( "typed1", "SELECT $1::int4 + 1 AS a, $2::text AS b, $3::bool AS c" )
+			expect( desc.nparams ).to eq( 3 )
+			ts = @conn.typed_statement( "typed1" )
+			expect( ts.param_type_map.coders.map(&:class) ).to eq( [PG::TextEncoder::Integer, PG::TextEncoder::String, PG::TextEncoder::Boolean] )
+			expect( ts.result_type_maps[0].coders.map(&:class) ).to eq( [PG::TextDecoder::Integer, PG::TextDecoder::String, PG::TextDecoder::Boolean] )
+			expect( ts.result_type_maps[1].coders.map(&:class) ).to eq( [PG::BinaryDecoder::Integer, PG::BinaryDecoder::String, PG::BinaryDecoder::Boolean] )
+		end
+
+		it "applies the type maps in #exec_prepared" do
+			@conn.prepare_typed( "typed2", "SELECT $1::int4 + 1 AS a, $2::text AS b, $3::bool AS c" )
+			res = @conn.exec_prepared( "typed2", [4, "x", true] )
+			expect( res.values ).to eq( [[5, "x", true]] )
+			res = @conn.exec_prepared( "typed2", [5, "y", false], 1 )
+			expect( res.values ).to eq( [[6, "y", false]] )
+			expect( @conn.exec_prepared( "typed2", [6, "z", nil] ){|r| r.values } ).to eq( [[7, "z", nil]] )
+		end
+
+		it "doesn't change other prepared statements" do
+			@conn.prepare( "untyped", "SELECT $1::int4 + 1 AS a" )
+			expect( @conn.exec_prepared( "untyped", ["4"] ).values ).to eq( [["5"]] )
+			expect( @conn.typed_statement( "untyped" ) ).to be_nil
+		end
+
+		it "prefers an explicit type map", :without_transaction do
+			@conn.prepare_typed( "typed3", "SELECT $1::int4 AS a" )
+			tm = PG::TypeMapByColumn.new( [PG::TextEncoder::String.new] )
+			expect( @conn.exec_prepared( "typed3", ["7"], 0, tm ).values ).to eq( [["7"]] )
+			expect( @conn.exec_prepared( "typed3", ["7"] ).values ).to eq( [[7]] )
+			@conn.reset
+			expect( @conn.typed_statement( "typed3" ) ).to be_nil
+		end
+
+		it "drops the type maps when the statement is prepared again" do
+			@conn.prepare_typed( "typed4", "SELECT $1::int4 AS a" )
+			@conn.exec( "DEALLOCATE typed4" )
+			@conn.prepare( "typed4", "SELECT $1::text AS a" )
+			expect( @conn.typed_statement( "typed4" ) ).to be_nil
+			expect( @conn.exec_prepared( "typed4", ["x"] ).values ).to eq( [["x"]] )
+		end
+
+		it "drops the type maps when the statement is closed", :postgresql_17 do
+			@conn.prepare_typed( "typed5", "SELECT $1::int4 AS a" )
+			@conn.close_prepared( "typed5" )
+			expect( @conn.typed_statement( "typed5" ) ).to be_nil
+			@conn.prepare( "typed5", "SELECT $1::text AS a" )
+			expect( @conn.exec_prepared( "typed5", ["x"] ).values ).to eq( [["x"]] )
+		end
+
+		it "drops the type maps on #sync_reset", :without_transaction do
+			@conn.prepare_typed( "typed6", "SELECT $1::int4 AS a" )
+			@conn.sync_reset
+			expect( @conn.typed_statement( "typed6" ) ).to be_nil
+		end
+	end
+
 	it "carries the connection in case of connection errors" do
 		conn = PG.connect(@conninfo)
 		expect {
@@ -0,0 +1,82 @@
+# -*- rspec -*-
+# encoding: utf-8
+
+require_relative '../helpers'
+require 'pg'
+
+describe PG::CopyLoader do
+	let!(:conns) { 3.times.map { PG.connect(@conninfo) } }
+	let!(:enco) { PG::TextEncoder::CopyRow.new }
+
+	before :each do
+		@conn.exec( "DROP TABLE IF EXISTS copyloader; CREATE TABLE copyloader (id INT, part INT)" )
+	end
+
+	after :each do
+		conns.each(&:close)
+		@conn.exec( "DROP TABLE IF EXISTS copyloader" )
+	end
+
+	it "loads rows round robin through all connections" do
+		loader = described_class.new( conns, "COPY copyloader FROM STDIN", enco, batch_size: 100 )
+		streams = loader.load( (1..3000).map { |i| [i, i % 7] } )
+
+		expect( streams.map(&:index) ).to eq( [0, 1, 2] )
+		expect( streams ).to all( be_success )
+		expect( streams.map(&:rows) ).to eq( [1000, 1000, 1000] )
+		expect( streams.map { |s| s.result.cmd_tuples } ).to eq( [1000, 1000, 1000] )
+		expect( @conn.exec( "SELECT count(*), sum(id) FROM copyloader" ).values ).to eq( [["3000", (1..3000).sum.to_s]] )
+	end
+
+	it "sends rows with the same key through the same connection" do
+		loader = described_class.new( conns, "COPY copyloader FROM STDIN", enco, partition_by: ->(row) { row[1] }, batch_size: 10 )
+		rows = (1..500).map { |i| [i, i % 7] }
+		streams = loader.load( rows )
+
+		expect( streams.sum(&:rows) ).to eq( 500 )
+		expected = rows.group_by { |_, part| Zlib.crc32(part.to_s) % 3 }.transform_values(&:size)
+		expect( streams.map(&:rows) ).to eq( 3.times.map { |idx| expected[idx] || 0 } )
+		expect( @conn.exec( "SELECT count(*) FROM copyloader" ).getvalue(0, 0) ).to eq( "500" )
+	end
+
+	it "assigns keys independent of the process" do
+		loader = described_class.new( conns, "COPY copyloader FROM STDIN", enco, partition_by: ->(row) { row[1] } )
+		streams = loader.load( [[1, "a"], [2, "b"], [3, "c"], [4, 17]] )
+		# CRC32 of "a", "b", "c" and "17" modulo 3
+		expect( streams.map(&:rows) ).to eq( [2, 0, 2] )
+	end
+
+	it "yields the streams in the order of completion" do
+		loader = described_class.new( conns, "COPY copyloader FROM STDIN", enco, batch_size: 10 )
+		finished = []
+		streams = loader.load( (1..30).map { |i| [i, 0] } ) do |stream|
+			expect( stream.result.cmd_tuples ).to eq( 10 )
+			finished << stream
+		end
+		expect( finished ).to match_array( streams )
+		expect( streams.map(&:index) ).to eq( [0, 1, 2] )
+	end
+
+	it "reports a failing stream without stopping the others" do
+		loader = described_class.new( conns, "COPY copyloader FROM STDIN", enco, batch_size: 10 )
+		rows = (1..300).map { |i| [i == 152 ? "invalid" : i, 0] }
+		streams = loader.load( rows )
+
+		expect( streams.map(&:success?) ).to eq( [true, false, true] )
+		expect( streams[1].error ).to be_a( PG::InvalidTextRepresentation )
+		expect( streams[1].result ).to be_nil
+		expect( @conn.exec( "SELECT count(*) FROM copyloader" ).getvalue(0, 0) ).to eq( "200" )
+		conns.each { |conn| expect( conn ).to still_be_usable }
+	end
+
+	it "aborts all streams when the row source raises" do
+		loader = described_class.new( conns, "COPY copyloader FROM STDIN", enco, batch_size: 10 )
+		source = Enumerator.new do |y|
+			100.times { |i| y << [i, 0] }
+			raise "source failed"
+		end
+		expect { loader.load( source ) }.to raise_error( RuntimeError, "source failed" )
+		expect( @conn.exec( "SELECT count(*) FROM copyloader" ).getvalue(0, 0) ).to eq( "0" )
+		conns.each { |conn| expect( conn ).to still_be_usable }
+	end
+end
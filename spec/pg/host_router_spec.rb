@@ -0,0 +1,64 @@
+# -*- rspec -*-
+# encoding: utf-8
+
+require_relative '../helpers'
+require 'pg'
+
+describe PG::HostRouter do
+	let!(:router) { described_class.new(ttl: 60) }
+
+	after :each do
+		PG::Connection.host_router = nil
+	end
+
+	it "keeps the order of unknown hosts" do
+		allow( router ).to receive( :probe )
+		router.record("10.0.0.1", "a", "5432", rtt: 0.010, healthy: true)
+		router.record("10.0.0.2", "b", "5432", rtt: nil, healthy: false)
+		dests = [["10.0.0.3", "c", "5432"], ["10.0.0.1", "a", "5432"], ["10.0.0.4", "d", "5432"], ["10.0.0.2", "b", "5432"]]
+		expect( router.order(dests, {}).map{|d| d[1] } ).to eq( %w[a c d b] )
+		expect( router["10.0.0.3", "c", "5432"] ).to be_nil
+		expect( router["10.0.0.4", "d", "5432"] ).to be_nil
+	end
+
+	it "sorts healthy hosts by round trip time" do
+		router.record("10.0.0.1", "a", "5432", rtt: 0.010, healthy: true)
+		router.record("10.0.0.2", "b", "5432", rtt: 0.002, healthy: true)
+		router.record("10.0.0.3", "c", "5432", rtt: nil, healthy: false)
+		dests = [["10.0.0.3", "c", "5432"], ["10.0.0.1", "a", "5432"], ["10.0.0.2", "b", "5432"]]
+		expect( router.order(dests, {}).map{|d| d[1] } ).to eq( %w[b a c] )
+	end
+
+	it "prefers replicas for read-only connections" do
+		router.record("10.0.0.1", "a", "5432", rtt: 0.001, healthy: true, standby: false)
+		router.record("10.0.0.2", "b", "5432", rtt: 0.010, healthy: true, standby: true)
+		dests = [["10.0.0.1", "a", "5432"], ["10.0.0.2", "b", "5432"]]
+		expect( router.order(dests, {}).map{|d| d[1] } ).to eq( %w[a b] )
+		expect( router.order(dests, {target_session_attrs: "prefer-standby"}).map{|d| d[1] } ).to eq( %w[b a] )
+	end
+
+	it "smoothes the round trip time" do
+		router.record("10.0.0.1", "a", nil, rtt: 1.0, healthy: true)
+		router.record("10.0.0.1", "a", "", rtt: 2.0, healthy: true)
+		expect( router["10.0.0.1", "a", PG::DEF_PGPORT].rtt ).to be_within(0.001).of(1.3)
+	end
+
+	it "probes unknown hosts and routes to the server" do
+		PG::Connection.host_router = router
+		PG.connect(host: "localhost,localhost", port: "#{@port_down},#{@port}", dbname: "test") do |conn|
+			expect( conn.port ).to eq( @port )
+			expect( router[conn.hostaddr, "localhost", @port].healthy ).to be true
+			expect( router[conn.hostaddr, "localhost", @port].rtt ).to be > 0
+			expect( router[conn.hostaddr, "localhost", @port_down].healthy ).to be false
+		end
+	end
+
+	it "tries the fastest healthy host first" do
+		router.record("127.0.0.1", "127.0.0.1", @port, rtt: 0.001, healthy: true)
+		router.record("127.0.0.1", "127.0.0.1", @port_down, rtt: nil, healthy: false)
+		PG::Connection.host_router = router
+		PG.connect(host: "127.0.0.1,127.0.0.1", port: "#{@port_down},#{@port}", dbname: "test") do |conn|
+			expect( conn.port ).to eq( @port )
+		end
+	end
+end
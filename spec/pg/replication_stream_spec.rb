@@ -0,0 +1,139 @@
+# -*- rspec -*-
+# encoding: utf-8
+
+require_relative '../helpers'
+require 'pg'
+
+describe PG::ReplicationStream do
+	def xlogdata(payload)
+		["w", [0x100, 0x200, 1_000_000].pack("Q>Q>q>"), payload].join.b
+	end
+
+	let!(:relation_msg) do
+		["R", [16384].pack("N"), "public\0", "repl_test\0", "d", [3].pack("n"),
+			[1].pack("C"), "id\0", [23, -1].pack("Nl>"),
+			[0].pack("C"), "name\0", [25, -1].pack("Nl>"),
+			[0].pack("C"), "flag\0", [16, -1].pack("Nl>")].join
+	end
+
+	context "decoding messages" do
+		let!(:stream) { described_class.new(@conn, "slot", publications: "pub") }
+
+		def decode(data)
+			stream.send(:decode_message, data)
+		end
+
+		it "decodes keepalive messages" do
+			event = decode(["k", [0x1234, 1_000_000, 1].pack("Q>q>C")].join)
+			expect( event ).to be_a( described_class::Keepalive )
+			expect( event.wal_end ).to eq( 0x1234 )
+			expect( event.send_time ).to eq( Time.utc(2000, 1, 1, 0, 0, 1) )
+			expect( event.reply_requested ).to be true
+			expect( stream.received_lsn ).to eq( 0x1234 )
+		end
+
+		it "decodes begin and commit" do
+			event = decode(xlogdata(["B", [0x300, -1_000_000, 7].pack("Q>q>N")].join))
+			expect( event.to_a ).to eq( [0x300, Time.utc(1999, 12, 31, 23, 59, 59), 7] )
+			event = decode(xlogdata(["C", [0, 0x300, 0x310, 0].pack("CQ>Q>q>")].join))
+			expect( event ).to be_a( described_class::Commit )
+			expect( event.commit_lsn ).to eq( 0x300 )
+			expect( event.end_lsn ).to eq( 0x310 )
+			expect( stream.received_lsn ).to eq( 0x100 )
+		end
+
+		it "decodes changes through the type map of the relation" do
+			relation = decode(xlogdata(relation_msg))
+			expect( relation.name ).to eq( "repl_test" )
+			expect( relation.columns.map(&:to_a) ).to eq( [["id", 23, -1, true], ["name", 25, -1, false], ["flag", 16, -1, false]] )
+			expect( stream.relations ).to eq( 16384 => relation )
+			relation.type_map = PG::TypeMapByColumn.new([PG::TextDecoder::Integer.new, nil, PG::TextDecoder::Boolean.new])
+
+			event = decode(xlogdata(["I", [16384].pack("N"), "N", [3, "t", 1, "1", "t", 3, "abc", "n"].pack("naNa*aNa*a")].join))
+			expect( event.relation ).to equal( relation )
+			expect( event.new_tuple ).to eq( [1, "abc", nil] )
+
+			event = decode(xlogdata(["U", [16384].pack("N"), "K", [3, "t", 1, "1", "n", "n"].pack("naNa*aa"), "N", [3, "t", 1, "2", "u", "t", 1, "t"].pack("naNa*aaNa*")].join))
+			expect( event.old_tuple ).to eq( [1, nil, nil] )
+			expect( event.new_tuple ).to eq( [2, :unchanged_toast, true] )
+
+			event = decode(xlogdata(["D", [16384].pack("N"), "K", [3, "t", 1, "2", "n", "n"].pack("naNa*aa")].join))
+			expect( event ).to be_a( described_class::Delete )
+			expect( event.old_tuple ).to eq( [2, nil, nil] )
+		end
+
+		it "decodes truncate and unknown messages" do
+			decode(xlogdata(relation_msg))
+			event = decode(xlogdata(["T", [1, 1, 16384].pack("NCN")].join))
+			expect( event.relations.map(&:oid) ).to eq( [16384] )
+			expect( event.cascade ).to be true
+			expect( event.restart_identity ).to be false
+
+			event = decode(xlogdata("Oorigin"))
+			expect( event.to_a ).to eq( ["O", "origin"] )
+		end
+
+		it "raises an error at invalid messages" do
+			expect{ decode("x") }.to raise_error(ArgumentError, /unknown replication message type/)
+			expect{ decode(xlogdata("B\0")) }.to raise_error(ArgumentError, /premature end/)
+			expect{ decode(xlogdata(["I", [1].pack("N"), "N", [0].pack("n")].join)) }.to raise_error(ArgumentError, /unknown relation OID 1/)
+			expect{ decode(xlogdata(["B", [1, 2, 3].pack("Q>q>N"), "x"].join)) }.to raise_error(ArgumentError, /trailing data/)
+		end
+
+		it "returns raw WAL data of a physical stream" do
+			stream = described_class.new(@conn, "slot")
+			event = stream.send(:decode_message, xlogdata("walbytes"))
+			expect( event.to_a ).to eq( [0x100, 0x200, Time.utc(2000, 1, 1, 0, 0, 1), "walbytes"] )
+		end
+	end
+
+	it "converts WAL positions" do
+		expect( described_class.parse_lsn("16/B374D848") ).to eq( 0x16_B374D848 )
+		expect( described_class.format_lsn(0x16_B374D848) ).to eq( "16/B374D848" )
+	end
+
+	context "with logical replication", :without_transaction do
+		before :all do
+			@port_logical = @port + 3
+			@dbms = PG::TestingHelpers::PostgresServer.new("logical",
+				port: @port_logical,
+				postgresql_conf: "wal_level = logical"
+			)
+			@dbms.create_test_db
+			@lconn = @dbms.connect
+			@lconn.exec( "CREATE TABLE repl_test (id INT PRIMARY KEY, name TEXT, flag BOOL)" )
+			@lconn.exec( "CREATE PUBLICATION repl_pub FOR TABLE repl_test" )
+			@lconn.exec( "SELECT pg_create_logical_replication_slot('repl_slot', 'pgoutput')" )
+		end
+
+		after :all do
+			@lconn&.close
+			@dbms&.teardown
+		end
+
+		it "streams decoded changes and confirms the position" do
+			@lconn.exec( "INSERT INTO repl_test VALUES (1, 'abc', true); UPDATE repl_test SET name='def'; DELETE FROM repl_test" )
+
+			rconn = PG.connect( @dbms.conninfo, replication: "database" )
+			stream = described_class.new( rconn, "repl_slot", publications: ["repl_pub"], type_map: PG::BasicTypeMapForResults.new(rconn) )
+			events = []
+			stream.each do |event|
+				events << event
+				if event.is_a?( described_class::Commit )
+					stream.acknowledge( event.end_lsn )
+					stream.stop
+				end
+			end
+
+			expect( events.map(&:class) ).to eq( [described_class::Begin, described_class::Relation, described_class::Insert, described_class::Update, described_class::Delete, described_class::Commit] )
+			expect( events[2].new_tuple ).to eq( [1, "abc", true] )
+			expect( events[3].new_tuple ).to eq( [1, "def", true] )
+			expect( events[4].old_tuple ).to eq( [1, nil, nil] )
+
+			confirmed = @lconn.exec( "SELECT confirmed_flush_lsn FROM pg_replication_slots WHERE slot_name='repl_slot'" ).getvalue(0, 0)
+			expect( described_class.parse_lsn(confirmed) ).to be >= events.last.end_lsn
+		ensure
+			rconn&.close
+		end
+	end
+end
@@ -3,6 +3,7 @@
 
 require 'pg'
 require 'time'
+require 'securerandom'
 unless defined?(ObjectSpace.memsize_of)
 	require "objspace"
 	DATA_OBJ_MEMSIZE = ObjectSpace.memsize_of(Object.new)
@@ -91,6 +92,28 @@ describe "PG::Type derivations" do
 				expect( intdec_incrementer.decode("3") ).to eq( 4 )
 			end
 
+			it "should decode floats from text format" do
+				expect( textdec_float.decode("0.1") ).to eq( 0.1 )
+				expect( textdec_float.decode("-1.2345678901234567") ).to eq( -1.2345678901234567 )
+				expect( textdec_float.decode("1.7976931348623157e+308") ).to eq( Float::MAX )
+				expect( textdec_float.decode("2.2250738585072014e-308") ).to eq( Float::MIN )
+				expect( textdec_float.decode("5e-324") ).to eq( 5e-324 )
+				expect( textdec_float.decode("1e400") ).to eq( Float::INFINITY )
+				expect( textdec_float.decode("1.234567890123456789012345") ).to eq( 1.2345678901234568 )
+				expect( 1 / textdec_float.decode("-0") ).to eq( -Float::INFINITY )
+				expect( textdec_float.decode("Infinity") ).to eq( Float::INFINITY )
+				expect( textdec_float.decode("-Infinity") ).to eq( -Float::INFINITY )
+				expect( textdec_float.decode("NaN") ).to be_nan
+			end
+
+			it "should decode random floats equally to Float()" do
+				prng = Random.new(42)
+				1000.times do
+					str = "#{prng.rand(10**prng.rand(1..20))}e#{prng.rand(-330..310)}"
+					expect( textdec_float.decode(str) ).to eq( Float(str) )
+				end
+			end
+
 			it "should decode integers of different lengths from text format" do
 				30.times do |zeros|
 					expect( textdec_int.decode("1" + "0"*zeros) ).to eq( 10 ** zeros )
@@ -234,6 +257,251 @@ describe "PG::Type derivations" do
 				end
 			end
 
+			context 'timestamps with TIMESTAMP_CACHE' do
+				let!(:textdec_timestamp_cached) { PG::TextDecoder::TimestampUtc.new(flags: PG::Coder::TIMESTAMP_CACHE) }
+				let!(:binarydec_timestamp_cached) { PG::BinaryDecoder::Timestamp.new(flags: PG::Coder::TIMESTAMP_CACHE) }
+
+				it 'keeps the flag in the convenience classes' do
+					expect( textdec_timestamp_cached.flags ).to eq( PG::Coder::TIMESTAMP_CACHE | PG::Coder::TIMESTAMP_DB_UTC | PG::Coder::TIMESTAMP_APP_UTC )
+				end
+				it 'returns the same frozen Time for repeated values of a column' do
+					t1 = textdec_timestamp_cached.decode('2016-01-02 23:23:59.123456', 0, 2)
+					t2 = textdec_timestamp_cached.decode('2016-01-02 23:23:59.123456', 1, 2)
+					expect( t1 ).to be_frozen
+					expect( t2 ).to equal( t1 )
+					expect( t1 ).to eq( Time.utc(2016,1,2, 23,23,59.123456r) )
+				end
+				it 'decodes other values of the same date' do
+					expect( textdec_timestamp_cached.decode('2016-01-02 23:23:59', 0, 2) ).to eq( Time.utc(2016,1,2, 23,23,59) )
+					expect( textdec_timestamp_cached.decode('2016-01-02 00:00:01', 1, 2) ).to eq( Time.utc(2016,1,2, 0,0,1) )
+					expect( textdec_timestamp_cached.decode('2016-01-02 10:00:01+02', 2, 2) ).to eq( Time.utc(2016,1,2, 8,0,1) )
+					expect( textdec_timestamp_cached.decode('2016-01-03 00:00:01', 3, 2) ).to eq( Time.utc(2016,1,3, 0,0,1) )
+				end
+				it 'returns infinity as String' do
+					expect( textdec_timestamp_cached.decode('infinity', 0, 2) ).to eq( 'infinity' )
+					expect( textdec_timestamp_cached.decode('infinity', 1, 2) ).to eq( 'infinity' )
+				end
+				it 'distinguishes decoders with different flags' do
+					t1 = textdec_timestamp_cached.decode('2016-01-02 23:23:59', 0, 2)
+					t2 = PG::TextDecoder::TimestampUtcToLocal.new(flags: PG::Coder::TIMESTAMP_CACHE).decode('2016-01-02 23:23:59', 1, 2)
+					expect( t1 ).to be_utc
+					expect( t2 ).not_to be_utc
+				end
+				it 'decodes BC and AD values after a flag switch of the column' do
+					other = PG::TextDecoder::TimestampUtcToLocal.new(flags: PG::Coder::TIMESTAMP_CACHE)
+					expect( other.decode('2000-01-01 00:00:00', 0, 1) ).to eq( Time.utc(2000,1,1, 0,0,0) )
+					expect( textdec_timestamp_cached.decode('0001-01-01 00:00:01 BC', 1, 1) ).to eq( Time.utc(0,1,1, 0,0,1) )
+					expect( textdec_timestamp_cached.decode('0001-01-01 00:00:02 BC', 2, 1) ).to eq( Time.utc(0,1,1, 0,0,2) )
+					expect( other.decode('0001-01-01 00:00:03 BC', 3, 1) ).to eq( Time.utc(0,1,1, 0,0,3) )
+					expect( textdec_timestamp_cached.decode('2000-01-01 00:00:04', 4, 1) ).to eq( Time.utc(2000,1,1, 0,0,4) )
+					expect( textdec_timestamp_cached.decode('0001-01-01 00:00:05 BC', 5, 1) ).to eq( Time.utc(0,1,1, 0,0,5) )
+				end
+				it 'returns the same frozen Time for repeated binary values' do
+					t1 = binarydec_timestamp_cached.decode("\x00\x00\x00\x00\x00\x0F\x42\x40".b, 0, 1)
+					t2 = binarydec_timestamp_cached.decode("\x00\x00\x00\x00\x00\x0F\x42\x40".b, 1, 1)
+					expect( t1 ).to eq( Time.utc(2000,1,1, 0,0,1) )
+					expect( t1 ).to be_frozen
+					expect( t2 ).to equal( t1 )
+				end
+			end
+
+			context 'dates' do
+				let!(:textdec_date) { PG::TextDecoder::Date.new }
+
+				it 'decodes dates' do
+					expect( textdec_date.decode('2016-01-02') ).to eq( Date.new(2016,1,2) )
+					expect( textdec_date.decode('0001-01-01') ).to eq( Date.new(1,1,1, Date::GREGORIAN) )
+					expect( textdec_date.decode('12345-06-07') ).to eq( Date.new(12345,6,7) )
+				end
+				it 'decodes dates BC' do
+					expect( textdec_date.decode('0044-03-13 BC') ).to eq( Date.new(-43,3,13, Date::GREGORIAN) )
+					expect( textdec_date.decode('4714-11-24 BC') ).to eq( Date.new(-4713,11,24, Date::GREGORIAN) )
+				end
+				it 'returns infinity and other date styles as String' do
+					expect( textdec_date.decode('infinity') ).to eq( 'infinity' )
+					expect( textdec_date.decode('-infinity') ).to eq( '-infinity' )
+					expect( textdec_date.decode('01/02/2016') ).to eq( '01/02/2016' )
+					expect( textdec_date.decode('2016-01-02x') ).to eq( '2016-01-02x' )
+				end
+				it 'reuses frozen Date objects of the same column' do
+					d1 = textdec_date.decode('2016-01-02', 0, 3)
+					d2 = textdec_date.decode('2016-01-02', 1, 3)
+					expect( d1 ).to be_frozen
+					expect( d2 ).to equal( d1 )
+				end
+				it 'returns frozen Date objects, which can be duplicated' do
+					d = textdec_date.decode('1999-12-31', 0, 5)
+					expect( d ).to be_frozen
+					expect( d.dup ).not_to be_frozen
+					expect( d.dup ).to eq( Date.new(1999,12,31) )
+				end
+				it "doesn't share cached Date objects with coders of different flags" do
+					d1 = textdec_date.decode('2016-01-03', 0, 4)
+					d2 = PG::TextDecoder::Date.new(flags: 0x8000).decode('2016-01-03', 0, 4)
+					expect( d2 ).to eq( d1 )
+					expect( d2 ).not_to equal( d1 )
+					expect( textdec_date.decode('2016-01-03', 1, 4) ).not_to equal( d1 )
+				end
+			end
+
+			context 'numeric', :bigdecimal do
+				let!(:textdec_numeric) { PG::TextDecoder::Numeric.new }
+				let!(:textdec_numeric_int_float) { PG::TextDecoder::Numeric.new(to_integer: true, to_float: true) }
+
+				it 'decodes to BigDecimal by default' do
+					expect( textdec_numeric.decode('-12.50') ).to eq( BigDecimal('-12.5') )
+					expect( textdec_numeric.decode('-12.50') ).to be_kind_of( BigDecimal )
+					expect( textdec_numeric.decode('42') ).to be_kind_of( BigDecimal )
+					expect( textdec_numeric.decode('NaN') ).to be_nan
+				end
+				it 'decodes values without fraction to Integer' do
+					deco = PG::TextDecoder::Numeric.new(flags: PG::Coder::NUMERIC_TO_INTEGER)
+					expect( deco.to_integer ).to eq( true )
+					expect( deco.decode('42') ).to eq( 42 )
+					expect( deco.decode('-42.000') ).to eq( -42 )
+					expect( deco.decode('-123456789012345678901234567890') ).to eq( -123456789012345678901234567890 )
+					expect( deco.decode('42.5') ).to eq( BigDecimal('42.5') )
+				end
+				it 'decodes values with zero fraction to Integer, but keeps other fractions' do
+					deco = PG::TextDecoder::Numeric.new(to_integer: true)
+					expect( deco.decode('12.000') ).to eql( 12 )
+					expect( deco.decode('12.5') ).to be_kind_of( BigDecimal )
+					expect( deco.decode('12.5') ).to eq( BigDecimal('12.5') )
+					expect( textdec_numeric_int_float.decode('12.000') ).to eql( 12 )
+					expect( textdec_numeric_int_float.decode('12.5') ).to eql( 12.5 )
+				end
+				it 'decodes values with up to 15 significant digits to Float' do
+					expect( textdec_numeric_int_float.decode('12.50') ).to eql( 12.5 )
+					expect( textdec_numeric_int_float.decode('-0.001') ).to eql( -0.001 )
+					expect( textdec_numeric_int_float.decode('1234567890.12345') ).to eql( 1234567890.12345 )
+					expect( textdec_numeric_int_float.decode('1234567890.123456') ).to eq( BigDecimal('1234567890.123456') )
+					expect( textdec_numeric_int_float.decode('-Infinity') ).to eql( -Float::INFINITY )
+					expect( textdec_numeric_int_float.decode('NaN') ).to be_nan
+				end
+				it 'keeps values beyond the Float range as BigDecimal' do
+					tiny = "0." + "0" * 400 + "1"
+					expect( textdec_numeric_int_float.decode(tiny) ).to eq( BigDecimal(tiny) )
+					expect( textdec_numeric_int_float.decode("-" + tiny) ).to eq( BigDecimal("-" + tiny) )
+					expect( textdec_numeric_int_float.decode("0." + "0" * 320 + "1") ).to eq( BigDecimal("1e-321") )
+					expect( textdec_numeric_int_float.decode("0." + "0" * 300 + "1") ).to eql( 1e-301 )
+					expect( textdec_numeric_int_float.decode("0.000") ).to eql( 0 )
+					expect( PG::TextDecoder::Numeric.new(to_float: true).decode("-0.000") ).to eql( -0.0 )
+				end
+			end
+
+			context 'binary numeric', :bigdecimal do
+				let!(:bindec_numeric) { PG::BinaryDecoder::Numeric.new }
+
+				it 'decodes base-10000 digit groups' do
+					expect( bindec_numeric.decode([2, 0, 0x4000, 2, 12, 3400].pack("n*")) ).to eq( BigDecimal('-12.34') )
+					expect( bindec_numeric.decode([1, -2, 0, 10, 25].pack("n*")) ).to eq( BigDecimal('0.00000025') )
+					expect( bindec_numeric.decode([1, 2, 0, 0, 7].pack("n*")) ).to eq( BigDecimal('700000000') )
+					expect( bindec_numeric.decode([0, 0, 0, 2].pack("n*")) ).to eq( BigDecimal('0') )
+					expect( bindec_numeric.decode([0, 0, 0xC000, 0].pack("n*")) ).to be_nan
+				end
+				it 'decodes to Integer and Float per flags' do
+					deco = PG::BinaryDecoder::Numeric.new(to_integer: true, to_float: true)
+					expect( deco.decode([3, 2, 0x4000, 2, 1, 2345, 6789].pack("n*")) ).to eql( -123456789 )
+					expect( deco.decode([6, 5, 0, 0, 1, 2345, 6789, 0, 1234, 5678].pack("n*")) ).to eq( 123456789000012345678 )
+					expect( deco.decode([2, 0, 0, 2, 12, 3400].pack("n*")) ).to eql( 12.34 )
+					expect( deco.decode([0, 0, 0xD000, 0].pack("n*")) ).to eql( Float::INFINITY )
+				end
+				it 'keeps values beyond the Float range as BigDecimal' do
+					deco = PG::BinaryDecoder::Numeric.new(to_float: true)
+					expect( deco.decode([1, -101, 0, 401, 1000].pack("n*")) ).to eq( BigDecimal("1e-401") )
+					expect( deco.decode([1, -101, 0x4000, 401, 1000].pack("n*")) ).to eq( BigDecimal("-1e-401") )
+				end
+				it 'raises at invalid data' do
+					expect{ bindec_numeric.decode([2, 0, 0, 0, 1].pack("n*")) }.to raise_error(TypeError, /wrong data/)
+					expect{ bindec_numeric.decode([1, 0, 0x1234, 0, 1].pack("n*")) }.to raise_error(TypeError, /wrong sign/)
+				end
+			end
+
+			context 'UUID' do
+				let!(:uuid) { "a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11" }
+				let!(:uuid_bin) { ["a0eebc999c0b4ef8bb6d6bb9bd380a11"].pack("H*") }
+
+				it 'decodes text uuid to String' do
+					deco = PG::TextDecoder::UUID.new
+					expect( deco.decode(uuid) ).to eq( uuid )
+					expect( deco.decode(uuid) ).not_to be_frozen
+				end
+				it 'decodes text uuid to binary String' do
+					deco = PG::TextDecoder::UUID.new(binary_string: true)
+					expect( deco.decode(uuid) ).to eq( uuid_bin )
+					expect( deco.decode(uuid).encoding ).to eq( Encoding::BINARY )
+					expect{ deco.decode(uuid.sub("a11", "a1g")) }.to raise_error(TypeError, /wrong data/)
+				end
+				it 'decodes text uuid to deduplicated String' do
+					deco = PG::TextDecoder::UUID.new(flags: PG::Coder::UUID_INTERN)
+					expect( deco.intern ).to eq( true )
+					expect( deco.decode(uuid) ).to be_frozen
+					expect( deco.decode(uuid.dup) ).to equal( deco.decode(uuid.dup) )
+				end
+				it 'decodes binary uuid' do
+					expect( PG::BinaryDecoder::UUID.new.decode(uuid_bin) ).to eq( uuid )
+					expect( PG::BinaryDecoder::UUID.new(binary_string: true).decode(uuid_bin) ).to eq( uuid_bin )
+					expect( PG::BinaryDecoder::UUID.new(intern: true).decode(uuid_bin) ).to be_frozen
+					expect{ PG::BinaryDecoder::UUID.new.decode("x") }.to raise_error(TypeError, /wrong data/)
+				end
+				it 'decodes random uuids' do
+					deco = PG::BinaryDecoder::UUID.new
+					1000.times do
+						u = SecureRandom.uuid
+						expect( deco.decode([u.delete("-")].pack("H*")) ).to eq( u )
+					end
+				end
+			end
+
+			context 'intervals' do
+				let!(:textdec_interval) { PG::TextDecoder::Interval.new }
+
+				it 'decodes postgres style' do
+					expect( textdec_interval.decode('00:00:00') ).to eq( [0, 0, 0] )
+					expect( textdec_interval.decode('1 year 2 mons -3 days +04:05:06.5') ).to eq( [14, -3, 14706500000] )
+					expect( textdec_interval.decode('-1 days +02:03:00') ).to eq( [0, -1, 7380000000] )
+					expect( textdec_interval.decode('-00:00:00.000001') ).to eq( [0, 0, -1] )
+				end
+				it 'decodes postgres_verbose style' do
+					expect( textdec_interval.decode('@ 1 year 2 mons -3 days 4 hours 5 mins 6.789 secs ago') ).to eq( [-14, 3, -14706789000] )
+					expect( textdec_interval.decode('@ 0') ).to eq( [0, 0, 0] )
+				end
+				it 'decodes iso_8601 style' do
+					expect( textdec_interval.decode('PT0S') ).to eq( [0, 0, 0] )
+					expect( textdec_interval.decode('P1Y2M3DT4H5M6.789S') ).to eq( [14, 3, 14706789000] )
+					expect( textdec_interval.decode('P-1Y-2M3DT-4H-5M-6.789S') ).to eq( [-14, 3, -14706789000] )
+				end
+				it 'returns other styles and infinity as String' do
+					expect( textdec_interval.decode('1-2 3 4:05:06') ).to eq( '1-2 3 4:05:06' )
+					expect( textdec_interval.decode('infinity') ).to eq( 'infinity' )
+					expect( textdec_interval.decode('-infinity') ).to eq( '-infinity' )
+					expect( textdec_interval.decode('300000000 years') ).to eq( '300000000 years' )
+					expect( textdec_interval.decode('2562047788:00:54.775808') ).to eq( '2562047788:00:54.775808' )
+					expect( textdec_interval.decode('@ 1 mon 2562047788 hours 1 min') ).to eq( '@ 1 mon 2562047788 hours 1 min' )
+				end
+				it 'decodes the whole microseconds range like the binary decoder' do
+					expect( textdec_interval.decode('2562047788:00:54.775807') ).to eq( [0, 0, 2**63-1] )
+					expect( textdec_interval.decode('-2562047788:00:54.775808') ).to eq( [0, 0, -2**63] )
+					expect( textdec_interval.decode('PT2562047788H54.775807S') ).to eq( [0, 0, 2**63-1] )
+					expect( textdec_interval.decode('@ 153722867280 mins 54.775807 secs') ).to eq( [0, 0, 2**63-1] )
+					expect( PG::BinaryDecoder::Interval.new.decode([2**63-1, 0, 0].pack("q>l>l>")) ).to eq( [0, 0, 2**63-1] )
+				end
+				it 'decodes to seconds' do
+					deco = PG::TextDecoder::Interval.new(flags: PG::Coder::INTERVAL_TO_SECONDS)
+					expect( deco.to_seconds ).to eq( true )
+					expect( deco.decode('1 day 00:00:01.5') ).to eq( 86401.5 )
+					expect( deco.decode('1 year 1 mon') ).to eq( 365.25 * 86400 + 30 * 86400 )
+					expect( deco.decode('-infinity') ).to eq( -Float::INFINITY )
+				end
+				it 'decodes binary intervals' do
+					deco = PG::BinaryDecoder::Interval.new
+					expect( deco.decode([14706500000, -3, 14].pack("q>l>l>")) ).to eq( [14, -3, 14706500000] )
+					expect( deco.decode([2**63-1, 2**31-1, 2**31-1].pack("q>l>l>")) ).to eq( 'infinity' )
+					expect( PG::BinaryDecoder::Interval.new(to_seconds: true).decode([1500000, 1, 0].pack("q>l>l>")) ).to eq( 86401.5 )
+					expect{ deco.decode("x") }.to raise_error(TypeError, /wrong data/)
+				end
+			end
+
 			context 'identifier quotation' do
 				it 'should build an array out of an quoted identifier string' do
 					quoted_type = PG::TextDecoder::Identifier.new
@@ -255,6 +523,74 @@ describe "PG::Type derivations" do
 				end
 			end
 
+			context 'JSON' do
+				let!(:textdec_json) { PG::TextDecoder::JSON.new }
+
+				it 'decodes like JSON.parse' do
+					[
+						%q({"a":1,"b":[true,false,null,"x\\ny\\u00e9\\ud83d\\ude00\\/"],"c":{"d":-1.5e3,"":[]}}),
+						%q( [ 1 , -0, -0.0, 0.1, 1E2, 12345678901234567890123, -999999999999999999 ] ),
+						%q({"a":1,"a":2}),
+						%q("\\ude00"),
+						"[" * 100 + "]" * 100,
+						'"' + "x" * 100 + '\\"' + "y" * 50 + '"',
+					].each do |str|
+						expect( textdec_json.decode(str) ).to eq( JSON.parse(str) )
+					end
+				end
+
+				it 'raises JSON::ParserError on invalid input' do
+					["", " ", "[1,]", "[1] x", "01", "1.", "-", "tru", %Q("a\tb"), %q("abc), %q({"a" 1}), %q({1:2}), %q("\\ud800x")].each do |str|
+						expect{ textdec_json.decode(str) }.to raise_error(JSON::ParserError)
+					end
+					expect{ textdec_json.decode("[" * 101 + "]" * 101) }.to raise_error(JSON::NestingError, /nesting of 101/)
+				end
+
+				it 'decodes strings with the given encoding and deduplicates keys' do
+					v = textdec_json.decode(%q({"a":"\xE9"}).force_encoding("iso-8859-1"))
+					expect( v["a"].encoding ).to eq( Encoding::ISO_8859_1 )
+					expect( v.keys.first ).to be_frozen
+					expect( textdec_json.decode(%q({"b":1})).keys.first ).to equal( textdec_json.decode(%q({"b":2})).keys.first )
+				end
+
+				it 'can symbolize names' do
+					deco = PG::TextDecoder::JSON.new(symbolize_names: true)
+					expect( deco.symbolize_names ).to be true
+					expect( deco.decode(%q({"a":{"b\\n":1}})) ).to eq( {a: {"b\n": 1}} )
+				end
+
+				it 'can deep freeze the result' do
+					deco = PG::TextDecoder::JSON.new(deep_freeze: true)
+					v = deco.decode(%q({"a":["x",{"b":"y\\n"}]}))
+					expect( v ).to eq( {"a" => ["x", {"b" => "y\n"}]} )
+					expect( [v, v["a"], v["a"][0], v["a"][1], v["a"][1]["b"]] ).to all( be_frozen )
+				end
+
+				it 'can decode numbers as BigDecimal' do
+					PG.require_bigdecimal_without_warning
+					deco = PG::TextDecoder::JSON.new(decimal_class: BigDecimal)
+					expect( deco.decimal_class ).to eq( BigDecimal )
+					expect( deco.decode("[1.5, 2, 1e3]") ).to eq( [BigDecimal("1.5"), 2, BigDecimal("1000")] )
+					expect( deco.decode("0.1").class ).to eq( BigDecimal )
+					expect( deco.dup.decimal_class ).to eq( BigDecimal )
+					expect{ deco.decimal_class = Float }.to raise_error(ArgumentError)
+				end
+			end
+
+			context 'binary JSON' do
+				it 'decodes json and jsonb with version byte' do
+					deco = PG::BinaryDecoder::JSON.new(symbolize_names: true)
+					expect( deco.format ).to eq( 1 )
+					expect( deco.decode(%Q(\x01{"a":[1,2.5]})) ).to eq( {a: [1, 2.5]} )
+					expect( deco.decode(%q({"a":null})) ).to eq( {a: nil} )
+					expect( deco.decode(%Q(\n"x")) ).to eq( "x" )
+				end
+
+				it 'raises at unknown jsonb versions' do
+					expect{ PG::BinaryDecoder::JSON.new.decode("\x02{}") }.to raise_error(ArgumentError, /jsonb version number 2/)
+				end
+			end
+
 			it "should raise when decode method is called with wrong args" do
 				expect{ textdec_int.decode() }.to raise_error(ArgumentError)
 				expect{ textdec_int.decode("123", 2, 3, 4) }.to raise_error(ArgumentError)
@@ -324,7 +660,7 @@ describe "PG::Type derivations" do
 			it "should encode floats" do
 				expect( textenc_float.encode(0) ).to eq( "0.0" )
 				expect( textenc_float.encode(-1) ).to eq( "-1.0" )
-				expect( textenc_float.encode(-1.234567890123456789) ).to eq( "-1.234567890123457" )
+				expect( textenc_float.encode(-1.234567890123456789) ).to eq( "-1.2345678901234567" )
 				expect( textenc_float.encode(9) ).to eq( "9.0" )
 				expect( textenc_float.encode(10) ).to eq( "10.0" )
 				expect( textenc_float.encode(-99) ).to eq( "-99.0" )
@@ -346,28 +682,42 @@ describe "PG::Type derivations" do
 				expect( textenc_float.encode(-1234567890123456) ).to eq( "-1.234567890123456e15" )
 				expect( textenc_float.encode(9999999999999999) ).to eq( "1e16" )
 
-				expect( textenc_float.encode(-0.0) ).to eq( "0.0" )
+				expect( textenc_float.encode(-0.0) ).to eq( "-0.0" )
 				expect( textenc_float.encode(0.1) ).to eq( "0.1" )
-				expect( textenc_float.encode(0.1234567890123456789) ).to eq( "0.1234567890123457" )
+				expect( textenc_float.encode(0.1234567890123456789) ).to eq( "0.12345678901234568" )
 				expect( textenc_float.encode(-0.9) ).to eq( "-0.9" )
-				expect( textenc_float.encode(-0.01234567890123456789) ).to eq( "-0.01234567890123457" )
+				expect( textenc_float.encode(-0.01234567890123456789) ).to eq( "-0.012345678901234568" )
 				expect( textenc_float.encode(0.09) ).to eq( "0.09" )
-				expect( textenc_float.encode(0.001234567890123456789) ).to eq( "0.001234567890123457" )
+				expect( textenc_float.encode(0.001234567890123456789) ).to eq( "0.0012345678901234567" )
 				expect( textenc_float.encode(-0.009) ).to eq( "-0.009" )
-				expect( textenc_float.encode(-0.0001234567890123456789) ).to eq( "-0.0001234567890123457" )
+				expect( textenc_float.encode(-0.0001234567890123456789) ).to eq( "-0.00012345678901234567" )
 				expect( textenc_float.encode(0.0009) ).to eq( "0.0009" )
 				expect( textenc_float.encode(0.00001) ).to eq( "1e-5" )
-				expect( textenc_float.encode(0.00001234567890123456789) ).to eq( "1.234567890123457e-5" )
+				expect( textenc_float.encode(0.00001234567890123456789) ).to eq( "1.2345678901234568e-5" )
 				expect( textenc_float.encode(-0.00009) ).to eq( "-9e-5" )
 				expect( textenc_float.encode(-0.11) ).to eq( "-0.11" )
 				expect( textenc_float.encode(10.11) ).to eq( "10.11" )
-				expect( textenc_float.encode(-1.234567890123456789E-280) ).to eq( "-1.234567890123457e-280" )
-				expect( textenc_float.encode(-1.234567890123456789E280) ).to eq( "-1.234567890123457e280" )
-				expect( textenc_float.encode(9876543210987654321E280) ).to eq( "9.87654321098765e298" )
+				expect( textenc_float.encode(-1.234567890123456789E-280) ).to eq( "-1.2345678901234568e-280" )
+				expect( textenc_float.encode(-1.234567890123456789E280) ).to eq( "-1.2345678901234568e280" )
+				expect( textenc_float.encode(9876543210987654321E280) ).to eq( "9.876543210987654e298" )
 				expect( textenc_float.encode(9876543210987654321E-400) ).to eq( "0.0" )
 				expect( textenc_float.encode(9876543210987654321E400) ).to eq( "Infinity" )
 			end
 
+			it "should encode floats with the shortest representation that reads back equally" do
+				expect( textenc_float.encode(0.1 + 0.2) ).to eq( "0.30000000000000004" )
+				expect( textenc_float.encode(5e-324) ).to eq( "5e-324" )
+				expect( textenc_float.encode(Float::MIN) ).to eq( "2.2250738585072014e-308" )
+				expect( textenc_float.encode(Float::MAX) ).to eq( "1.7976931348623157e308" )
+
+				prng = Random.new(42)
+				1000.times do
+					f = [prng.bytes(8)].pack("a8").unpack1("D")
+					next if f.nan? || f.infinite?
+					expect( textdec_float.decode(textenc_float.encode(f)) ).to eq( f )
+				end
+			end
+
 			it "should encode special floats equally to Float#to_s" do
 				expect( textenc_float.encode(Float::INFINITY) ).to eq( Float::INFINITY.to_s )
 				expect( textenc_float.encode(-Float::INFINITY) ).to eq( (-Float::INFINITY).to_s )
@@ -422,6 +772,27 @@ describe "PG::Type derivations" do
 				end
 			end
 
+			context 'text dates' do
+				let!(:textenc_date) { PG::TextEncoder::Date.new }
+
+				it 'encodes dates' do
+					expect( textenc_date.encode(Date.new(2016,1,2)) ).to eq( '2016-01-02' )
+					expect( textenc_date.encode(Date.new(12,1,2, Date::GREGORIAN)) ).to eq( '0012-01-02' )
+					expect( textenc_date.encode(Date.new(12345,6,7)) ).to eq( '12345-06-07' )
+				end
+				it 'encodes dates in the gregorian calendar' do
+					expect( textenc_date.encode(Date.new(1500,3,1, Date::JULIAN)) ).to eq( '1500-03-11' )
+					expect( textenc_date.encode(DateTime.new(2016,1,2, 23,59,59)) ).to eq( '2016-01-02' )
+				end
+				it 'encodes dates BC' do
+					expect( textenc_date.encode(Date.new(0,1,1, Date::GREGORIAN)) ).to eq( '0001-01-01 BC' )
+					expect( textenc_date.encode(Date.new(-4713,11,24, Date::GREGORIAN)) ).to eq( '4714-11-24 BC' )
+				end
+				it 'encodes other objects per #to_s' do
+					expect( textenc_date.encode('infinity') ).to eq( 'infinity' )
+				end
+			end
+
 			context 'binary timestamps' do
 				it 'encodes timestamps as UTC' do
 					expect( binaryenc_timestamputc.encode(Time.utc(2000,1,1)) ).
@@ -437,6 +808,141 @@ describe "PG::Type derivations" do
 				end
 			end
 
+			context 'JSON' do
+				let!(:textenc_json) { PG::TextEncoder::JSON.new }
+
+				it 'encodes like JSON.generate' do
+					[
+						{"a" => 1, :b => [true, false, nil, "x\ny\u0001\u001f\"\\é/\x7f", :sym], "c" => {"d" => -1.5e3}},
+						[1.0, 0.1, 1e20, 1.5e-7, -0.0, 123456789.123, 1e15, 4484822615461965.5, 1e-5, 5e-324, 1.7976931348623157e308],
+						[2**70, -2**64, 0, -1, 2**62],
+						"", [], {},
+					].each do |value|
+						expect( textenc_json.encode(value, "UTF-8") ).to eq( JSON.generate(value) )
+					end
+				end
+
+				it 'respects to_json of other objects and subclasses' do
+					klass = Class.new(Hash) { def to_json(*) '"sub"' end }
+					value = {"a" => [Time.at(0).utc, klass.new], 1 => "é".encode("iso-8859-1")}
+					expect( textenc_json.encode(value, "UTF-8") ).to eq( JSON.generate(value) )
+				end
+
+				it 'raises like JSON.generate' do
+					expect{ textenc_json.encode(Float::NAN) }.to raise_error(JSON::GeneratorError)
+					expect{ textenc_json.encode("\xff") }.to raise_error(JSON::GeneratorError)
+					a = []
+					a << a
+					expect{ textenc_json.encode(a) }.to raise_error(JSON::NestingError)
+				end
+
+				it 'can be used as element coder' do
+					arrenc = PG::TextEncoder::Array.new(elements_type: textenc_json)
+					expect( arrenc.encode([{"a" => "b,c"}, nil, {}]) ).to eq( %[{"{\\"a\\":\\"b,c\\"}",NULL,"{}"}] )
+					recenc = PG::TextEncoder::Record.new(type_map: PG::TypeMapByColumn.new([textenc_json, nil]))
+					expect( recenc.encode([{"a" => [1, 2]}, "x"]) ).to eq( %[("{""a"":[1,2]}","x")] )
+				end
+			end
+
+			context 'binary numeric', :bigdecimal do
+				let!(:binenc_numeric) { PG::BinaryEncoder::Numeric.new }
+
+				it 'encodes Integer, Float and BigDecimal to base-10000 digit groups' do
+					expect( binenc_numeric.encode(0).unpack("n*") ).to eq( [0, 0, 0, 0] )
+					expect( binenc_numeric.encode(-123456789).unpack("n*") ).to eq( [3, 2, 0x4000, 0, 1, 2345, 6789] )
+					expect( binenc_numeric.encode(10**20).unpack("n*") ).to eq( [1, 5, 0, 0, 1] )
+					expect( binenc_numeric.encode(-0.05).unpack("n*") ).to eq( [1, 0xffff, 0x4000, 2, 500] )
+					expect( binenc_numeric.encode(BigDecimal("12.34")).unpack("n*") ).to eq( [2, 0, 0, 2, 12, 3400] )
+					expect( binenc_numeric.encode("-0.00000025").unpack("n*") ).to eq( [1, 0xfffe, 0x4000, 8, 25] )
+					expect( binenc_numeric.encode(Float::NAN).unpack("n*") ).to eq( [0, 0, 0xC000, 0] )
+					expect( binenc_numeric.encode(BigDecimal("-Infinity")).unpack("n*") ).to eq( [0, 0, 0xF000, 0] )
+				end
+				it 'roundtrips with the binary decoder' do
+					deco = PG::BinaryDecoder::Numeric.new
+					%w[ 1 -1 10000 0.0001 -98765432109876543210.0123456789 1e-40 3.14159 ].each do |v|
+						expect( deco.decode(binenc_numeric.encode(BigDecimal(v))) ).to eq( BigDecimal(v) )
+					end
+				end
+				it 'raises at invalid values' do
+					expect{ binenc_numeric.encode("1x") }.to raise_error(ArgumentError, /invalid value/)
+				end
+			end
+
+			context 'UUID' do
+				let!(:uuid) { "a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11" }
+				let!(:uuid_bin) { ["a0eebc999c0b4ef8bb6d6bb9bd380a11"].pack("H*") }
+
+				it 'encodes binary and text uuid to text' do
+					enco = PG::TextEncoder::UUID.new
+					expect( enco.encode(uuid_bin) ).to eq( uuid )
+					expect( enco.encode(uuid) ).to eq( uuid )
+				end
+				it 'encodes binary and text uuid to binary' do
+					enco = PG::BinaryEncoder::UUID.new
+					expect( enco.format ).to eq( 1 )
+					expect( enco.encode(uuid_bin) ).to eq( uuid_bin )
+					expect( enco.encode(uuid) ).to eq( uuid_bin )
+					expect( enco.encode(uuid.upcase) ).to eq( uuid_bin )
+					expect( enco.encode(uuid.delete("-")) ).to eq( uuid_bin )
+					expect( enco.encode("{#{uuid}}") ).to eq( uuid_bin )
+				end
+				it 'raises at invalid uuid' do
+					enco = PG::BinaryEncoder::UUID.new
+					expect{ enco.encode(uuid.sub("a11", "a1g")) }.to raise_error(ArgumentError, /invalid value/)
+					expect{ enco.encode(uuid.sub("-", "+")) }.to raise_error(ArgumentError, /invalid value/)
+					expect{ enco.encode(uuid[1..-1]) }.to raise_error(ArgumentError, /invalid value/)
+				end
+			end
+
+			context 'intervals' do
+				it 'encodes triple and seconds to text' do
+					enco = PG::TextEncoder::Interval.new
+					expect( enco.encode([14, -3, 14706500000]) ).to eq( "+14 mons -3 days +04:05:06.500000" )
+					expect( enco.encode(90) ).to eq( "+0 mons +0 days +00:01:30.000000" )
+					expect( enco.encode(-0.000001) ).to eq( "+0 mons +0 days -00:00:00.000001" )
+					expect( enco.encode(Rational(1, 3)) ).to eq( "+0 mons +0 days +00:00:00.333333" )
+					expect( enco.encode(Float::INFINITY) ).to eq( "infinity" )
+					expect( enco.encode("1 day") ).to eq( "1 day" )
+				end
+				it 'encodes triple and seconds to binary' do
+					enco = PG::BinaryEncoder::Interval.new
+					expect( enco.encode([14, -3, 14706500000]) ).to eq( [14706500000, -3, 14].pack("q>l>l>") )
+					expect( enco.encode(1.5) ).to eq( [1500000, 0, 0].pack("q>l>l>") )
+					expect( enco.encode(-Float::INFINITY) ).to eq( [-2**63, -2**31, -2**31].pack("q>l>l>") )
+				end
+				it 'roundtrips with the decoders' do
+					[[0, 0, 0], [1, -2, 3], [-2**31, 2**31-1, -2**63+1]].each do |triple|
+						expect( PG::BinaryDecoder::Interval.new.decode(PG::BinaryEncoder::Interval.new.encode(triple)) ).to eq( triple )
+					end
+					[[0, 0, 0], [1, -2, 3], [-2**31, 2**31-1, -2**63+1], [0, 0, 2**63-1]].each do |triple|
+						expect( PG::TextDecoder::Interval.new.decode(PG::TextEncoder::Interval.new.encode(triple)) ).to eq( triple )
+					end
+				end
+				it 'raises at invalid values' do
+					enco = PG::TextEncoder::Interval.new
+					expect{ enco.encode([1, 2]) }.to raise_error(ArgumentError, /3 elements/)
+					expect{ enco.encode(:x) }.to raise_error(TypeError, /wrong data/)
+					expect{ enco.encode(Float::NAN) }.to raise_error(RangeError)
+					expect{ enco.encode([0, 0, -2**63]) }.to raise_error(RangeError, /out of range/)
+					expect{ PG::BinaryEncoder::Interval.new.encode([1, 0, -2**63]) }.to raise_error(RangeError, /out of range/)
+				end
+				it 'encodes the infinity sentinels as infinity' do
+					enco = PG::TextEncoder::Interval.new
+					expect( enco.encode([-2**31, -2**31, -2**63]) ).to eq( "-infinity" )
+					expect( enco.encode([2**31-1, 2**31-1, 2**63-1]) ).to eq( "infinity" )
+				end
+			end
+
+			context 'binary JSON' do
+				it 'encodes json as text and jsonb with version byte' do
+					expect( PG::BinaryEncoder::JSON.new.encode({"a" => [1, nil]}) ).to eq( %q({"a":[1,null]}) )
+					jsonb = PG::BinaryEncoder::JSONB.new
+					expect( jsonb.format ).to eq( 1 )
+					expect( jsonb.encode({"a" => 1}) ).to eq( %Q(\x01{"a":1}) )
+					expect( jsonb.encode(Time.at(0).utc) ).to eq( "\x01" + JSON.generate(Time.at(0).utc) )
+				end
+			end
+
 			context 'identifier quotation' do
 				it 'should quote and escape identifier' do
 					quoted_type = PG::TextEncoder::Identifier.new
@@ -1373,6 +1879,21 @@ describe "PG::Type derivations" do
 						to eq("xyz\t123\t2456\t34567\t456789\t5678901\t[1, 2, 3]\t12.1\tabcdefg\t\\N\n")
 				end
 
+				it "should escape special characters at any position of long strings" do
+					(0..40).each do |pos|
+						["\\", "\n", "\r", "\t"].each do |c|
+							str = "x" * pos + c + "y" * (40 - pos)
+							expect( encoder.encode([str, "a#{c}b"]) ).to eq( "#{str.gsub(c) { "\\#{c}" }}\ta\\#{c}b\n" )
+						end
+					end
+				end
+
+				it "should escape the delimiter in long strings" do
+					enco = PG::TextEncoder::CopyRow.new delimiter: ","
+					str = "a" * 33 + "," + "b" * 17 + "\t"
+					expect( enco.encode([str, 5]) ).to eq( "#{"a" * 33}\\,#{"b" * 17}\t,5\n" )
+				end
+
 				it 'should output a string with correct character encoding' do
 					v = encoder.encode(["Héllo"], "iso-8859-1")
 					expect( v.encoding ).to eq( Encoding::ISO_8859_1 )
@@ -1505,6 +2026,50 @@ describe "PG::Type derivations" do
 						to eq("\x00\x05\x00\x00\x00\x03xyz\x00\x00\x00\x04\x00\x00\x00{\x00\x00\x00\x0313 \x00\x00\x00\aabcdefg\xFF\xFF\xFF\xFF".b)
 				end
 			end
+
+			context "with TypeMapByColumn" do
+				let!(:tm) do
+					PG::TypeMapByColumn.new [
+						PG::BinaryEncoder::Boolean.new, PG::BinaryEncoder::Int2.new, PG::BinaryEncoder::Int4.new,
+						PG::BinaryEncoder::Int8.new, PG::BinaryEncoder::Float4.new, PG::BinaryEncoder::Float8.new,
+						PG::BinaryEncoder::String.new, nil
+					]
+				end
+				let!(:encoder) do
+					PG::BinaryEncoder::CopyRow.new type_map: tm
+				end
+
+				it "should encode fixed width columns" do
+					expect( encoder.encode([true, -2, 3, 2**40, 1.5, -0.25, "abc", "de"]) ).
+						to eq([8, 1, 1, 2, -2, 4, 3, 8, 2**40, 4, 1.5, 8, -0.25, 3, "abc", 2, "de"].pack("nNCNs>NNNq>Ng NG Na*Na*"))
+				end
+
+				it "should encode NULL values" do
+					expect( encoder.encode([nil]*8) ).to eq( ([8] + [-1]*8).pack("nN*") )
+				end
+
+				it "should encode other objects per coder" do
+					expect( encoder.encode([false, "7", 2.7, 2**62, 3, 4, :sym, 5]) ).
+						to eq([8, 1, 0, 2, 7, 4, 2, 8, 2**62, 4, 3, 8, 4, 3, "sym", 1, "5"].pack("nNCNs>NNNQ>Ng NG Na*Na*"))
+				end
+
+				it "should raise the errors of the coders" do
+					expect{ encoder.encode(["t"] + [nil]*7) }.to raise_error(TypeError, /wrong data for binary boolean/)
+					expect{ encoder.encode([nil, 2**31] + [nil]*6) }.to raise_error(RangeError)
+					expect{ encoder.encode([nil]*7) }.to raise_error(ArgumentError, /number of .* fields/)
+				end
+
+				it "should ignore the plan of a type map initialized again" do
+					tm.send(:initialize, [PG::BinaryEncoder::String.new] * 8)
+					expect( encoder.encode([1, 2, 3, 4, 5, 6, 7, 8]) ).
+						to eq(([8] + (1..8).flat_map { |i| [1, i.to_s] }).pack("n" + "Na*" * 8))
+				end
+
+				it "should use the plan of a frozen encoder" do
+					enco = PG::BinaryEncoder::CopyRow.new(type_map: PG::TypeMapByColumn.new([PG::BinaryEncoder::Int4.new].freeze).freeze).freeze
+					expect( enco.encode([5]) ).to eq( [1, 4, 5].pack("nNN") )
+				end
+			end
 		end
 
 		describe PG::TextDecoder::CopyRow do
@@ -1512,12 +2077,27 @@ describe "PG::Type derivations" do
 				let!(:decoder) do
 					PG::TextDecoder::CopyRow.new
 				end
+				let!(:impl_before) { PG.simd }
 
 				describe '#decode' do
 					it "should decode COPY text format to array of strings" do
 						expect( decoder.decode("123\t \0#\t#\n#\r#\\ \t234\t#\x01#\002\n".gsub("#", "\\"))).to eq( ["123", " \0\t\n\r\\ ", "234", "\x01\x02"] )
 					end
 
+					%i[avx2 sse2 swar scalar].each do |impl|
+						it "should decode long fields with #{impl} scanner" do
+							begin
+								PG.simd = impl
+							rescue ArgumentError
+								skip "#{impl} is not supported"
+							end
+							line = "#{"a" * 40}\\x41\\101\\n\\tq\t\\N\tzz\\\\#{"b" * 33}\t#{"c" * 70}\n"
+							expect( decoder.decode(line) ).to eq( ["#{"a" * 40}AA\n\tq", nil, "zz\\#{"b" * 33}", "c" * 70] )
+						ensure
+							PG.simd = impl_before
+						end
+					end
+
 					it 'should respect input character encoding' do
 						v = decoder.decode("Héllo\n".encode("EUC-JP")).first
 						expect( v.encoding ).to eq(Encoding::EUC_JP)
@@ -1545,6 +2125,125 @@ describe "PG::Type derivations" do
 					end
 				end
 			end
+
+			context "with TypeMapByColumn of integers" do
+				let!(:decoder) do
+					PG::TextDecoder::CopyRow.new type_map: PG::TypeMapByColumn.new([textdec_int] * 3)
+				end
+
+				it "should decode integers in place" do
+					expect( decoder.decode("123\t-9223372036854775808\t9223372036854775807\n") ).to eq( [123, -9223372036854775808, 9223372036854775807] )
+					expect( decoder.decode("0\t-1\t12345678901234567890123") ).to eq( [0, -1, 12345678901234567890123] )
+				end
+				it "should decode NULL and escaped integers" do
+					expect( decoder.decode("\\N\t\\061\\x32\t3\n") ).to eq( [nil, 12, 3] )
+				end
+				it "should raise an error on trailing data" do
+					expect{ decoder.decode("1\t2\t3\nx") }.to raise_error(ArgumentError, /trailing data/)
+				end
+				it "should ignore the plan of a type map initialized again" do
+					decoder.type_map.send(:initialize, [PG::TextDecoder::String.new] * 3)
+					expect( decoder.decode("1\t2\t3\n") ).to eq( ["1", "2", "3"] )
+				end
+			end
+		end
+
+		describe PG::TextEncoder::CopyCsvRow do
+			let!(:encoder) do
+				PG::TextEncoder::CopyCsvRow.new
+			end
+
+			it "should have CSV defaults" do
+				expect( encoder.delimiter ).to eq( "," )
+				expect( encoder.null_string ).to eq( "" )
+				expect( encoder.quote ).to eq( '"' )
+				expect( encoder.escape ).to eq( '"' )
+				expect( encoder.force_quote ).to eq( false )
+			end
+
+			it "should quote only values which need quoting" do
+				expect( encoder.encode(["abc", 123, nil, "", "a,b", "a\"b", "a\nb", "a\rb"]) ).
+					to eq( "abc,123,,\"\",\"a,b\",\"a\"\"b\",\"a\nb\",\"a\rb\"\n" )
+			end
+
+			it "should quote a single \\. value" do
+				expect( encoder.encode(["\\."]) ).to eq( "\"\\.\"\n" )
+				expect( encoder.encode(["\\.", 1]) ).to eq( "\\.,1\n" )
+			end
+
+			it "should respect quote, escape and delimiter options" do
+				enc = PG::TextEncoder::CopyCsvRow.new quote: "'", escape: "\\", delimiter: ";", null_string: "NULL"
+				expect( enc.encode(["a'b\\c", "x;y", nil, "NULL", "\"q\""]) ).to eq( "'a\\'b\\\\c';'x;y';NULL;'NULL';\"q\"\n" )
+			end
+
+			it "should force quotes for all columns" do
+				enc = PG::TextEncoder::CopyCsvRow.new force_quote: true
+				expect( enc.encode(["a", nil, 3]) ).to eq( "\"a\",,\"3\"\n" )
+			end
+
+			it "should force quotes for selected columns" do
+				enc = PG::TextEncoder::CopyCsvRow.new force_quote: [0, 2]
+				expect( enc.force_quote ).to eq( [0, 2] )
+				expect( enc.encode(["a", "b", 3]) ).to eq( "\"a\",b,\"3\"\n" )
+				expect{ enc.force_quote = ["a"] }.to raise_error( TypeError )
+			end
+
+			it "should escape long values" do
+				str = "x" * 40 + "\"" + "y" * 40
+				expect( encoder.encode([str]) ).to eq( "\"#{"x" * 40}\"\"#{"y" * 40}\"\n" )
+			end
+
+			it "should encode values per type map" do
+				enc = PG::TextEncoder::CopyCsvRow.new type_map: PG::TypeMapByColumn.new([textenc_int, PG::TextEncoder::Array.new])
+				expect( enc.encode([5, ["a", "b,c"]]) ).to eq( "5,\"{a,\"\"b,c\"\"}\"\n" )
+			end
+
+			it "should be convertible to a Hash" do
+				enc = PG::TextEncoder::CopyCsvRow.new quote: "'", force_quote: true
+				expect( enc.to_h ).to include( quote: "'", escape: '"', force_quote: true, delimiter: "," )
+			end
+
+			it "should deny changes when frozen" do
+				enc = PG::TextEncoder::CopyCsvRow.new.freeze
+				expect{ enc.quote = "'" }.to raise_error(FrozenError)
+				expect{ enc.escape = "'" }.to raise_error(FrozenError)
+				expect{ enc.force_quote = true }.to raise_error(FrozenError)
+			end
+		end
+
+		describe PG::TextDecoder::CopyCsvRow do
+			let!(:decoder) do
+				PG::TextDecoder::CopyCsvRow.new
+			end
+
+			it "should decode quoted and unquoted values" do
+				expect( decoder.decode("abc,123,,\"\",\"a,b\",\"a\"\"b\",\"a\nb\",x\"y\"z\n") ).
+					to eq( ["abc", "123", nil, "", "a,b", "a\"b", "a\nb", "xyz"] )
+			end
+
+			it "should accept CR LF line ends" do
+				expect( decoder.decode("a,b\r\n") ).to eq( ["a", "b"] )
+			end
+
+			it "should respect quote, escape and null_string options" do
+				dec = PG::TextDecoder::CopyCsvRow.new quote: "'", escape: "\\", delimiter: ";", null_string: "NULL"
+				expect( dec.decode("'a\\'b\\\\c';'x;y';NULL;'NULL';\"q\"\n") ).to eq( ["a'b\\c", "x;y", nil, "NULL", "\"q\""] )
+			end
+
+			it "should raise on malformed data" do
+				expect{ decoder.decode("\"abc\n") }.to raise_error( ArgumentError, /unterminated/ )
+				expect{ decoder.decode("a\rb\n") }.to raise_error( ArgumentError, /unquoted carriage return/ )
+			end
+
+			it "should decode values per type map" do
+				dec = PG::TextDecoder::CopyCsvRow.new type_map: PG::TypeMapByColumn.new([textdec_int, textdec_string])
+				expect( dec.decode("\"12\",\"a,b\"\n") ).to eq( [12, "a,b"] )
+			end
+
+			it "should round trip values of the encoder" do
+				row = ["x" * 40 + "\"\n," + "y" * 20, "", nil, "\\N", "é"]
+				expect( decoder.decode(PG::TextEncoder::CopyCsvRow.new.encode(row, "UTF-8")) ).to eq( row )
+			end
 		end
 
 		describe PG::BinaryDecoder::CopyRow do
@@ -1602,6 +2301,27 @@ describe "PG::Type derivations" do
 						expect( decoder.decode([4, 2, "\x01\x02", 7, " \0\t\n\r\xff ", 0, "", 3, "abc"].pack("nNa*Na*Na*Na*")) )
 								.to eq( [258, " \0\t\n\r\xff ".b, 1, "abc"] )
 					end
+
+					it "should decode fixed width columns of all lengths" do
+						deco = PG::BinaryDecoder::CopyRow.new type_map: PG::TypeMapByColumn.new([
+							PG::BinaryDecoder::Boolean.new, PG::BinaryDecoder::Integer.new, PG::BinaryDecoder::Integer.new,
+							PG::BinaryDecoder::Integer.new, PG::BinaryDecoder::Float.new, PG::BinaryDecoder::Float.new,
+							PG::BinaryDecoder::Timestamp.new, PG::BinaryDecoder::Bytea.new
+						])
+						data = [8, 1, 1, 2, -2, 4, 3, 8, 2**40, 4, 1.5, 8, -0.25, 8, 0, 2, "ab"].pack("nNCNs>Nl>Nq>Ng NG Nq>Na*")
+						expect( deco.decode(data) ).to eq( [true, -2, 3, 2**40, 1.5, -0.25, Time.utc(2000, 1, 1), "ab"] )
+						expect( deco.decode(([8] + [-1]*8).pack("nN*")) ).to eq( [nil]*8 )
+					end
+
+					it "should raise the errors of the decoders at unexpected lengths" do
+						expect{ decoder.decode([4, 3, "abc", -1, -1, -1].pack("nNa*NNN")) }
+								.to raise_error(TypeError, /wrong data for binary integer converter in tuple 0 field 0 length 3/)
+					end
+
+					it "should raise an error at too many fields" do
+						expect{ decoder.decode([5, 2, "ab", -1, -1, -1, 2, "ab"].pack("nNa*NNNNa*")) }
+								.to raise_error(ArgumentError, /number of copy fields/)
+					end
 				end
 			end
 		end
@@ -38,6 +38,62 @@ describe PG do
 		expect( PG ).to be_threadsafe()
 	end
 
+	describe "adaptive GVL mode" do
+		after :each do
+			PG.gvl_adaptive = false
+		end
+
+		it "can be enabled and disabled" do
+			expect( PG.gvl_adaptive ).to be false
+			PG.gvl_adaptive = true
+			expect( PG.gvl_adaptive ).to be true
+		end
+
+		it "counts calls with released GVL" do
+			before = PG.gvl_stats.dig("PQgetResult", :blocking) || 0
+			@conn.exec("SELECT 1")
+			expect( PG.gvl_stats.dig("PQgetResult", :blocking) ).to be > before
+		end
+
+		it "keeps the GVL for buffered results" do
+			PG.gvl_adaptive = true
+			before = PG.gvl_stats.dig("PQgetResult", :nonblocking) || 0
+			res = @conn.exec("SELECT 1")
+			expect( res.values ).to eq( [["1"]] )
+			expect( PG.gvl_stats.dig("PQgetResult", :nonblocking) ).to be > before
+		end
+
+		it "doesn't use the fast path with a notice receiver" do
+			PG.gvl_adaptive = true
+			notices = []
+			@conn.set_notice_receiver { |res| notices << res.error_message }
+			before = PG.gvl_stats.dig("PQgetResult", :nonblocking) || 0
+			@conn.exec("DO $$ BEGIN RAISE NOTICE 'hello'; END; $$")
+			expect( PG.gvl_stats.dig("PQgetResult", :nonblocking) || 0 ).to eq( before )
+			expect( notices.join ).to match( /hello/ )
+		ensure
+			@conn.set_notice_receiver
+		end
+	end
+
+	describe "COPY text scanner" do
+		it "selects an implementation" do
+			expect( %i[avx2 sse2 swar scalar] ).to include( PG.simd )
+		end
+
+		it "can select the scalar implementation" do
+			impl = PG.simd
+			PG.simd = :scalar
+			expect( PG.simd ).to eq( :scalar )
+		ensure
+			PG.simd = impl
+		end
+
+		it "refuses unknown implementations" do
+			expect{ PG.simd = :mmx }.to raise_error( ArgumentError, /mmx/ )
+		end
+	end
+
 	it "tells about the libpq library path" do
 		expect( PG::POSTGRESQL_LIB_PATH ).to include("/")
 	end